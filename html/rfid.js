@@ -107,11 +107,14 @@ function initWebSocket() {
                 updateNfcData(data.payload);
             } else if (data.type === 'writeNfcTag') {
                 handleWriteNfcTagResponse(data.success);
+            } else if (data.type === 'cloneTag') {
+                updateCloneStatus(data.payload);
+            } else if (data.type === 'spoolmanHealth') {
+                updateSpoolmanDot(data.payload.connected);
             } else if (data.type === 'heartbeat') {
                 // Optional: Spezifische Behandlung von Heartbeat-Antworten
                 // Update status dots
                 const bambuDot = document.getElementById('bambuDot');
-                const spoolmanDot = document.getElementById('spoolmanDot');
                 const ramStatus = document.getElementById('ramStatus');
 
                 if (bambuDot) {
@@ -132,24 +135,7 @@ function initWebSocket() {
                         bambuDot.onclick = null;
                     }
                 }
-                if (spoolmanDot) {
-                    spoolmanDot.className = 'status-dot ' + (data.spoolman_connected ? 'online' : 'offline');
-                    // Add click handler only when offline
-                    if (!data.spoolman_connected) {
-                        spoolmanDot.style.cursor = 'pointer';
-                        spoolmanDot.onclick = function() {
-                            if (socket && socket.readyState === WebSocket.OPEN) {
-                                socket.send(JSON.stringify({
-                                    type: 'reconnect',
-                                    payload: 'spoolman'
-                                }));
-                            }
-                        };
-                    } else {
-                        spoolmanDot.style.cursor = 'default';
-                        spoolmanDot.onclick = null;
-                    }
-                }
+                updateSpoolmanDot(data.spoolman_connected);
                 if (ramStatus) {
                     ramStatus.textContent = `${data.freeHeap}k`;
                 }
@@ -192,6 +178,29 @@ function updateConnectionStatus() {
     }
 }
 
+// Spoolman Status-Punkt, aus Heartbeat und spoolmanHealth-Push
+function updateSpoolmanDot(connected) {
+    const spoolmanDot = document.getElementById('spoolmanDot');
+    if (!spoolmanDot) return;
+
+    spoolmanDot.className = 'status-dot ' + (connected ? 'online' : 'offline');
+    // Add click handler only when offline
+    if (!connected) {
+        spoolmanDot.style.cursor = 'pointer';
+        spoolmanDot.onclick = function() {
+            if (socket && socket.readyState === WebSocket.OPEN) {
+                socket.send(JSON.stringify({
+                    type: 'reconnect',
+                    payload: 'spoolman'
+                }));
+            }
+        };
+    } else {
+        spoolmanDot.style.cursor = 'default';
+        spoolmanDot.onclick = null;
+    }
+}
+
 // Event Listeners
 document.addEventListener("DOMContentLoaded", function() {
     initWebSocket();
@@ -816,6 +825,39 @@ function handleWriteNfcTagResponse(success) {
     
 }
 
+let cloneActive = false;
+
+function toggleCloneMode() {
+    if (socket?.readyState === WebSocket.OPEN) {
+        socket.send(JSON.stringify({
+            type: 'cloneTag',
+            action: cloneActive ? 'stop' : 'start'
+        }));
+    } else {
+        alert('Not connected to Server. Please check connection.');
+    }
+}
+
+function updateCloneStatus(status) {
+    const cloneButton = document.getElementById("cloneTagButton");
+    const cloneInfo = document.getElementById("cloneInfo");
+    if (!cloneButton || !cloneInfo) return;
+
+    cloneActive = status.state !== 'off';
+    cloneButton.textContent = cloneActive ? "Stop Clone" : "Start Clone";
+
+    if (status.error) {
+        cloneInfo.textContent = status.error;
+    } else if (status.state === 'awaitSource') {
+        cloneInfo.textContent = "Present the source tag";
+    } else if (status.state === 'active') {
+        cloneInfo.textContent = `Source ${status.source} (${status.bytes} bytes) - present blank tags. ` +
+            `Copies: ${status.copies}, failed: ${status.failed}, ${status.avgWriteMs} ms/tag, ${status.bytesPerSec} B/s`;
+    } else if (status.copies > 0) {
+        cloneInfo.textContent = `Clone stopped after ${status.copies} copies`;
+    }
+}
+
 function showNotification(message, isSuccess) {
     const notification = document.createElement('div');
     notification.className = `notification ${isSuccess ? 'success' : 'error'}`;
@@ -0,0 +1,434 @@
+#!/usr/bin/env python3
+"""Local Spoolman stand-in for benchmarking the FilaMan API client.
+
+Implements the part of the Spoolman API that src/api.cpp uses, with
+configurable latency, jitter, 5xx and timeout injection:
+
+    python3 scripts/spoolman_standin.py serve --port 7912 --latency-ms 150 --jitter-ms 50 --error-rate 0.05
+
+Point the device's Spoolman URL at http://<host>:7912 to run the firmware
+against it, or replay the firmware's request sequences from the host:
+
+    python3 scripts/spoolman_standin.py bench --scenario brand-spools --count 20
+    python3 scripts/spoolman_standin.py bench --scenario weigh-ins --count 100
+
+The bench client is a plain sequential client with a fixed policy of its own
+(3 attempts, 1 s apart, 10 s timeout, no retry on 4xx except 408/429, one
+keep-alive connection). It has no queue, priorities, adaptive timeouts or circuit
+breaker, so its numbers show the server and network side, not the firmware's
+scheduling; compare runs against each other, not against the device.
+Server side counters are available at GET /_stats and are reset by POST /_stats.
+Only the standard library is used.
+"""
+
+import argparse
+import hashlib
+import http.client
+import json
+import random
+import re
+import statistics
+import threading
+import time
+import urllib.parse
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+API = "/api/v1"
+
+# Bench client policy
+MAX_RETRIES = 3
+RETRY_DELAY_S = 1.0
+HTTP_TIMEOUT_S = 10.0
+
+
+## Server
+
+class Faults:
+    def __init__(self, args):
+        self.latency = args.latency_ms / 1000.0
+        self.jitter = args.jitter_ms / 1000.0
+        self.error_rate = args.error_rate
+        self.timeout_rate = args.timeout_rate
+        self.timeout_s = args.timeout_s
+
+    def delay(self):
+        return max(0.0, self.latency + random.uniform(-self.jitter, self.jitter))
+
+
+class Store:
+    """In-memory vendors, filaments, spools and extra fields."""
+
+    def __init__(self, version):
+        self.lock = threading.Lock()
+        self.version = version
+        self.vendors = {}
+        self.filaments = {}
+        self.spools = {}
+        self.fields = {"spool": [], "filament": []}
+        self.next_id = {"vendor": 1, "filament": 1, "spool": 1}
+        self.stats = {}
+        self.status_counts = {}
+
+    def new_id(self, kind):
+        value = self.next_id[kind]
+        self.next_id[kind] += 1
+        return value
+
+    def count(self, route, status):
+        entry = self.stats.setdefault(route, {"count": 0, "errors": 0})
+        entry["count"] += 1
+        if status >= 500:
+            entry["errors"] += 1
+        self.status_counts[str(status)] = self.status_counts.get(str(status), 0) + 1
+
+    def spool_view(self, spool):
+        view = dict(spool)
+        filament = dict(self.filaments[spool["filament_id"]])
+        filament["vendor"] = self.vendors.get(filament.get("vendor_id"))
+        view["filament"] = filament
+        return view
+
+    def seed_spools(self, count):
+        vendor = {"id": self.new_id("vendor"), "name": "Seed", "extra": {}}
+        self.vendors[vendor["id"]] = vendor
+        filament = {"id": self.new_id("filament"), "name": "Seed PLA", "vendor_id": vendor["id"],
+                    "material": "PLA", "color_hex": "FFFFFF", "weight": 1000, "spool_weight": 180,
+                    "external_id": "seed", "extra": {"nozzle_temperature": "[190,230]"}}
+        self.filaments[filament["id"]] = filament
+        for _ in range(count):
+            spool = {"id": self.new_id("spool"), "filament_id": filament["id"], "initial_weight": 1000,
+                     "spool_weight": 180, "remaining_weight": 1000, "location": "", "extra": {}}
+            self.spools[spool["id"]] = spool
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # keep-alive, like the firmware's connection pool
+    disable_nagle_algorithm = True
+    store = None
+    faults = None
+
+    def log_message(self, fmt, *args):
+        if self.server.verbose:
+            super().log_message(fmt, *args)
+
+    def read_json(self):
+        length = int(self.headers.get("Content-Length") or 0)
+        body = self.rfile.read(length) if length else b""
+        return json.loads(body) if body else {}
+
+    def send_json(self, status, payload, route):
+        body = json.dumps(payload).encode()
+        etag = '"%s"' % hashlib.sha1(body).hexdigest()[:16]
+        if status == 200 and self.command == "GET" and self.headers.get("If-None-Match") == etag:
+            status, body = 304, b""
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        if status in (200, 304):
+            self.send_header("ETag", etag)
+        self.end_headers()
+        self.wfile.write(body)
+        with self.store.lock:
+            self.store.count(route, status)
+
+    def inject(self, route):
+        """Apply latency and faults. Returns True if the request was answered already."""
+        time.sleep(self.faults.delay())
+        if random.random() < self.faults.timeout_rate:
+            # Longer than the client timeout, then drop the connection
+            time.sleep(self.faults.timeout_s)
+            with self.store.lock:
+                self.store.count(route, 599)
+            self.close_connection = True
+            return True
+        if random.random() < self.faults.error_rate:
+            self.send_json(503, {"message": "injected failure"}, route)
+            return True
+        return False
+
+    def handle_any(self):
+        parsed = urllib.parse.urlparse(self.path)
+        query = urllib.parse.parse_qs(parsed.query)
+        path = parsed.path
+
+        if path == "/_stats":
+            with self.store.lock:
+                if self.command == "POST":
+                    self.store.stats, self.store.status_counts = {}, {}
+                payload = {"routes": self.store.stats, "status": self.store.status_counts}
+            body = json.dumps(payload).encode()
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+            return
+
+        if not path.startswith(API):
+            self.send_json(404, {"message": "not found"}, "other")
+            return
+        path = path[len(API):].rstrip("/") or "/"
+        route = self.command + " " + re.sub(r"/\d+", "/{id}", path)
+        body = self.read_json() if self.command in ("POST", "PUT", "PATCH") else {}
+        if self.inject(route):
+            return
+
+        status, payload = self.dispatch(path, query, body)
+        self.send_json(status, payload, route)
+
+    def dispatch(self, path, query, body):
+        s = self.store
+        with s.lock:
+            if path == "/health":
+                return 200, {"status": "healthy"}
+
+            if path == "/info":
+                # The firmware compares the version to revalidate its extra fields
+                return 200, {"version": s.version, "debug_mode": False, "automatic_backups": False,
+                             "data_dir": "/tmp/spoolman", "logs_dir": "/tmp/spoolman/logs",
+                             "backups_dir": "/tmp/spoolman/backups", "db_type": "sqlite",
+                             "git_commit": None, "build_date": None}
+
+            match = re.fullmatch(r"/field/(spool|filament)(?:/(\w+))?", path)
+            if match:
+                entity, key = match.groups()
+                if self.command == "POST" and key:
+                    s.fields[entity] = [f for f in s.fields[entity] if f["key"] != key] + [dict(body, key=key)]
+                return 200, s.fields[entity]
+
+            if path in ("/vendor", "/filament"):
+                kind = path[1:]
+                table = s.vendors if kind == "vendor" else s.filaments
+                if self.command == "POST":
+                    item = dict(body, id=s.new_id(kind))
+                    if kind == "filament":
+                        item["vendor_id"] = int(item.get("vendor_id", 0))
+                        item["vendor"] = s.vendors.get(item["vendor_id"])
+                    table[item["id"]] = item
+                    return 200, item
+                items = list(table.values())
+                if "name" in query:
+                    items = [v for v in items if v["name"].lower() == query["name"][0].strip().lower()]
+                if "vendor.id" in query:
+                    items = [f for f in items if str(f.get("vendor_id")) == query["vendor.id"][0]]
+                if "external_id" in query:
+                    items = [f for f in items if f.get("external_id") == query["external_id"][0]]
+                offset = int(query.get("offset", ["0"])[0])
+                limit = int(query.get("limit", [str(len(items) or 1)])[0])
+                page = items[offset:offset + limit]
+                if kind == "filament":
+                    page = [dict(f, vendor=s.vendors.get(f.get("vendor_id"))) for f in page]
+                return 200, page
+
+            if path == "/spool" and self.command == "POST":
+                filament_id = int(body.get("filament_id", 0))
+                if filament_id not in s.filaments:
+                    return 404, {"message": "filament not found"}
+                spool = {"id": s.new_id("spool"), "filament_id": filament_id,
+                         "initial_weight": float(body.get("initial_weight", 1000)),
+                         "spool_weight": float(body.get("spool_weight", 180)),
+                         "location": "", "extra": body.get("extra", {})}
+                spool["remaining_weight"] = float(body.get("remaining_weight", spool["initial_weight"]))
+                s.spools[spool["id"]] = spool
+                return 200, s.spool_view(spool)
+
+            match = re.fullmatch(r"/spool/(\d+)(/measure)?", path)
+            if match:
+                spool = s.spools.get(int(match.group(1)))
+                if spool is None:
+                    return 404, {"message": "spool not found"}
+                if match.group(2) and self.command == "PUT":
+                    gross = float(body.get("weight", 0))
+                    spool["remaining_weight"] = max(0.0, gross - spool["spool_weight"])
+                elif self.command == "PATCH":
+                    for key in ("location", "remaining_weight"):
+                        if key in body:
+                            spool[key] = body[key]
+                    spool["extra"].update(body.get("extra", {}))
+                return 200, s.spool_view(spool)
+
+        return 404, {"message": "not found"}
+
+    do_GET = do_POST = do_PUT = do_PATCH = handle_any
+
+
+def serve(args):
+    store = Store(args.spoolman_version)
+    store.seed_spools(args.seed_spools)
+    Handler.store = store
+    Handler.faults = Faults(args)
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.verbose = args.verbose
+    print("Spoolman stand-in on http://%s:%d (latency %d±%d ms, 5xx %.0f%%, timeouts %.0f%%, %d seeded spools)"
+          % (args.host, args.port, args.latency_ms, args.jitter_ms, args.error_rate * 100,
+             args.timeout_rate * 100, args.seed_spools))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        print(json.dumps({"routes": store.stats, "status": store.status_counts}, indent=2))
+
+
+## Bench client
+
+class ApiClient:
+    """Sequential client: one keep-alive connection, fixed retries, 4xx stops."""
+
+    def __init__(self, base_url):
+        parsed = urllib.parse.urlparse(base_url)
+        self.host, self.port = parsed.hostname, parsed.port or 80
+        self.conn = None
+        self.requests = 0
+        self.attempts = 0
+        self.failures = 0
+        self.handshakes = 0
+
+    def _connection(self):
+        if self.conn is None:
+            self.conn = http.client.HTTPConnection(self.host, self.port, timeout=HTTP_TIMEOUT_S)
+            self.handshakes += 1
+        return self.conn
+
+    def request(self, method, path, payload=None):
+        self.requests += 1
+        body = json.dumps(payload).encode() if payload is not None else None
+        status = -1
+        for attempt in range(1, MAX_RETRIES + 1):
+            self.attempts += 1
+            try:
+                conn = self._connection()
+                conn.request(method, API + path, body=body, headers={"Content-Type": "application/json"})
+                response = conn.getresponse()
+                data = response.read()
+                status = response.status
+                if status in (200, 201):
+                    return status, json.loads(data) if data else None
+            except (OSError, http.client.HTTPException):
+                status = -1
+                if self.conn is not None:
+                    self.conn.close()
+                self.conn = None
+            if 400 <= status < 500 and status not in (408, 429):
+                break
+            if attempt < MAX_RETRIES:
+                time.sleep(RETRY_DELAY_S)
+        self.failures += 1
+        return status, None
+
+
+def first_id(response):
+    if isinstance(response, list):
+        return response[0]["id"] if response else 0
+    return (response or {}).get("id", 0)
+
+
+def brand_spool(client, index):
+    """checkVendor -> createVendor -> checkFilament -> createFilament -> createSpool"""
+    brand = "Bench Brand %d" % (index % 3)
+    article = "BENCH-%03d" % (index % 5)
+
+    _, found = client.request("GET", "/vendor?name=" + urllib.parse.quote_plus(brand))
+    vendor_id = first_id(found)
+    if not vendor_id:
+        _, created = client.request("POST", "/vendor", {"name": brand, "comment": brand})
+        vendor_id = first_id(created)
+    if not vendor_id:
+        return False
+
+    _, found = client.request("GET", "/filament?vendor.id=%d&external_id=%s" % (vendor_id, article))
+    filament_id = first_id(found)
+    if not filament_id:
+        _, created = client.request("POST", "/filament", {
+            "name": "Bench " + article, "vendor_id": str(vendor_id), "material": "PLA",
+            "density": "1.24", "diameter": "1.75", "weight": "1000", "spool_weight": "180",
+            "external_id": article, "color_hex": "FFFFFF"})
+        filament_id = first_id(created)
+    if not filament_id:
+        return False
+
+    _, spool = client.request("POST", "/spool", {
+        "filament_id": str(filament_id), "initial_weight": "1000", "spool_weight": "180",
+        "remaining_weight": "1000", "lot_nr": article, "comment": "automatically generated",
+        "extra": {"tag": "\"BENCH%04d\"" % index}})
+    return first_id(spool) > 0
+
+
+def weigh_in(client, index):
+    """updateSpoolWeight() on one of the seeded spools"""
+    spool_id = 1 + index % 10
+    status, _ = client.request("PUT", "/spool/%d/measure" % spool_id, {"weight": random.randint(300, 1180)})
+    return status == 200
+
+
+SCENARIOS = {
+    "brand-spools": brand_spool,
+    "weigh-ins": weigh_in,
+}
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(round(fraction * (len(ordered) - 1))))]
+
+
+def bench(args):
+    client = ApiClient(args.url)
+    stats_conn = http.client.HTTPConnection(client.host, client.port, timeout=HTTP_TIMEOUT_S)
+    stats_conn.request("POST", "/_stats")
+    stats_conn.getresponse().read()
+
+    run = SCENARIOS[args.scenario]
+    latencies = []
+    failed = 0
+    started = time.monotonic()
+    for index in range(args.count):
+        begin = time.monotonic()
+        if not run(client, index):
+            failed += 1
+        latencies.append((time.monotonic() - begin) * 1000.0)
+    total = time.monotonic() - started
+
+    stats_conn.request("GET", "/_stats")
+    server_stats = json.loads(stats_conn.getresponse().read())
+
+    print("Scenario %s: %d runs in %.1f s, %d failed" % (args.scenario, args.count, total, failed))
+    print("  end-to-end ms: p50 %.0f  p95 %.0f  max %.0f  mean %.0f" % (
+        percentile(latencies, 0.5), percentile(latencies, 0.95), max(latencies), statistics.mean(latencies)))
+    print("  client: %d requests, %d attempts, %d failed requests, %d connections" % (
+        client.requests, client.attempts, client.failures, client.handshakes))
+    print("  server:")
+    for route, counts in sorted(server_stats["routes"].items()):
+        print("    %-28s %5d  (%d 5xx)" % (route, counts["count"], counts["errors"]))
+    print("    status codes: %s" % json.dumps(server_stats["status"], sort_keys=True))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("serve", help="run the stand-in server")
+    p.add_argument("--host", default="0.0.0.0")
+    p.add_argument("--port", type=int, default=7912)
+    p.add_argument("--latency-ms", type=int, default=0)
+    p.add_argument("--jitter-ms", type=int, default=0)
+    p.add_argument("--error-rate", type=float, default=0.0, help="share of requests answered with 503")
+    p.add_argument("--timeout-rate", type=float, default=0.0, help="share of requests left hanging")
+    p.add_argument("--timeout-s", type=float, default=HTTP_TIMEOUT_S + 2, help="how long a hanging request hangs")
+    p.add_argument("--spoolman-version", default="0.22.1", help="version reported by /info")
+    p.add_argument("--seed-spools", type=int, default=10, help="spools 1..n for weigh-in scenarios")
+    p.add_argument("--verbose", action="store_true")
+    p.set_defaults(func=serve)
+
+    p = sub.add_parser("bench", help="replay a firmware request scenario against a server")
+    p.add_argument("--url", default="http://127.0.0.1:7912")
+    p.add_argument("--scenario", choices=sorted(SCENARIOS), default="weigh-ins")
+    p.add_argument("--count", type=int, default=100)
+    p.set_defaults(func=bench)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
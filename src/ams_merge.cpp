@@ -0,0 +1,203 @@
+#include "ams_merge.h"
+#include "bambu.h"
+
+static int findAmsIndex(int amsId) {
+    for (int k = 0; k < ams_count; k++) {
+        if (ams_data[k].ams_id == amsId) return k;
+    }
+    return -1;
+}
+
+// New slot for an AMS unit. The external spool always stays the last slot.
+static int addAms(uint8_t amsId) {
+    int extIdx = findAmsIndex(255);
+    int normalAms = ams_count - (extIdx == -1 ? 0 : 1);
+    if (ams_count >= MAX_AMS) return -1;
+    if (amsId != 255 && normalAms >= MAX_AMS - 1) return -1; // Reserve one slot for the optional external spool
+
+    int index = ams_count;
+    if (amsId != 255 && extIdx != -1) {
+        ams_data[ams_count] = ams_data[extIdx];
+        index = extIdx;
+    }
+    ams_data[index] = AMSData();
+    ams_data[index].ams_id = amsId;
+    for (uint8_t t = 0; t < 4; t++) {
+        ams_data[index].trays[t].id = (amsId == 255) ? 254 : t;
+    }
+    ams_count++;
+
+    Serial.printf("AMS %u added (slot %d)\n", amsId, index);
+    return index;
+}
+
+// Deltas may carry single trays, their position in the array is not the slot
+static int trayIndexOf(JsonObject trayObj, int position) {
+    return trayObj["id"].isNull() ? position : trayObj["id"].as<int>();
+}
+
+static bool mergeField(JsonObject obj, const char* key, String& target) {
+    JsonVariant value = obj[key];
+    if (value.isNull()) return false;
+    String merged = value.as<String>();
+    if (merged == target) return false;
+    target = merged;
+    return true;
+}
+
+static bool mergeField(JsonObject obj, const char* key, int& target) {
+    JsonVariant value = obj[key];
+    if (value.isNull()) return false;
+    int merged = value.as<int>();
+    if (merged == target) return false;
+    target = merged;
+    return true;
+}
+
+static bool clearField(String& target) {
+    if (target == "") return false;
+    target = "";
+    return true;
+}
+
+static bool clearField(int& target) {
+    if (target == 0) return false;
+    target = 0;
+    return true;
+}
+
+// A tray taken out is reported with its id only (and "state"), not with empty fields
+static bool isEmptyTrayReport(JsonObject trayObj) {
+    if (trayObj["id"].isNull()) return false;
+    for (JsonPair field : trayObj) {
+        if (field.key() != "id" && field.key() != "state") return false;
+    }
+    return true;
+}
+
+static bool clearTray(TrayData& tray) {
+    bool changed = false;
+    changed |= clearField(tray.tray_info_idx);
+    changed |= clearField(tray.tray_type);
+    changed |= clearField(tray.tray_sub_brands);
+    changed |= clearField(tray.tray_color);
+    changed |= clearField(tray.nozzle_temp_min);
+    changed |= clearField(tray.nozzle_temp_max);
+    changed |= clearField(tray.setting_id);
+    changed |= clearField(tray.cali_idx);
+    changed |= clearField(tray.remain);
+    changed |= clearField(tray.tray_uuid);
+    changed |= clearField(tray.tag_uid);
+    return changed;
+}
+
+static bool mergeTray(JsonObject trayObj, TrayData& tray, bool external) {
+    if (isEmptyTrayReport(trayObj)) {
+        if (!clearTray(tray)) return false;
+        tray.version++;
+        return true;
+    }
+
+    bool changed = false;
+    changed |= mergeField(trayObj, "tray_info_idx", tray.tray_info_idx);
+    changed |= mergeField(trayObj, "tray_type", tray.tray_type);
+    changed |= mergeField(trayObj, "tray_sub_brands", tray.tray_sub_brands);
+    changed |= mergeField(trayObj, "tray_color", tray.tray_color);
+    changed |= mergeField(trayObj, "nozzle_temp_min", tray.nozzle_temp_min);
+    changed |= mergeField(trayObj, "nozzle_temp_max", tray.nozzle_temp_max);
+    changed |= mergeField(trayObj, "setting_id", tray.setting_id);
+    changed |= mergeField(trayObj, "remain", tray.remain);
+    changed |= mergeField(trayObj, "tray_uuid", tray.tray_uuid);
+    changed |= mergeField(trayObj, "tag_uid", tray.tag_uid);
+
+    // Empty tray: the printer keeps reporting the old calibration of the external spool
+    if (tray.tray_type == "") {
+        changed |= clearField(tray.setting_id);
+        if (external) changed |= clearField(tray.cali_idx);
+    }
+    if (!external || tray.tray_type != "") {
+        changed |= mergeField(trayObj, "cali_idx", tray.cali_idx);
+    }
+
+    if (changed) tray.version++;
+    return changed;
+}
+
+// Fields that tell one spool from another, remain and temperatures change while printing
+static bool sameSpool(const TrayData& a, const TrayData& b) {
+    return a.tray_type == b.tray_type && a.tray_info_idx == b.tray_info_idx &&
+           a.tray_sub_brands == b.tray_sub_brands && a.tray_color == b.tray_color &&
+           a.tray_uuid == b.tray_uuid && a.tag_uid == b.tag_uid;
+}
+
+static void mergeTrayInto(AmsMergeResult& result, uint8_t amsId, JsonObject trayObj, TrayData& tray, bool external) {
+    TrayData before = tray;
+    bool wasEmpty = tray.tray_type == "";
+    if (!mergeTray(trayObj, tray, external)) return;
+
+    AmsTrayChange change;
+    change.amsId = amsId;
+    change.trayId = tray.id;
+    change.filled = wasEmpty && tray.tray_type != "";
+    change.spoolChanged = tray.tray_type != "" && !sameSpool(before, tray);
+    change.isBambuSpool = (tray.tag_uid != "" && tray.tag_uid != "0000000000000000") ||
+                          (tray.tray_uuid != "" && tray.tray_uuid != "00000000000000000000000000000000");
+    result.changes.push_back(change);
+
+    Serial.printf("AMS %u Tray %u updated (version %lu)\n", amsId, tray.id, (unsigned long)tray.version);
+}
+
+AmsMergeResult amsMergeReport(JsonObject print) {
+    AmsMergeResult result;
+
+    for (JsonObject amsObj : print["ams"]["ams"].as<JsonArray>()) {
+        if (amsObj["id"].isNull()) continue;
+        uint8_t amsId = amsObj["id"].as<uint8_t>();
+
+        int index = findAmsIndex(amsId);
+        if (index == -1) {
+            index = addAms(amsId);
+            if (index == -1) continue;
+            result.newAms = true;
+        }
+
+        int position = 0;
+        for (JsonObject trayObj : amsObj["tray"].as<JsonArray>()) {
+            int t = trayIndexOf(trayObj, position++);
+            if (t < 0 || t >= 4) continue;
+            mergeTrayInto(result, amsId, trayObj, ams_data[index].trays[t], false);
+        }
+    }
+
+    // Externe Spule
+    if (print["vt_tray"].is<JsonObject>()) {
+        int index = findAmsIndex(255);
+        if (index == -1) {
+            index = addAms(255);
+            if (index != -1) result.newAms = true;
+        }
+        if (index != -1) {
+            mergeTrayInto(result, 255, print["vt_tray"].as<JsonObject>(), ams_data[index].trays[0], true);
+        }
+    }
+
+    return result;
+}
+
+bool amsMergeSetting(int amsId, int trayId, const String& settingId) {
+    if (findAmsIndex(amsId) == -1) return false;
+
+    TrayData* tray = nullptr;
+    if (trayId == 254) {
+        // Suche AMS mit ID 255 (externe Spule)
+        int extIdx = findAmsIndex(255);
+        if (extIdx != -1) tray = &ams_data[extIdx].trays[0];
+    } else if (trayId >= 0 && trayId < 4) {
+        tray = &ams_data[findAmsIndex(amsId)].trays[trayId];
+    }
+    if (tray == nullptr || tray->setting_id == settingId) return false;
+
+    tray->setting_id = settingId;
+    tray->version++;
+    return true;
+}
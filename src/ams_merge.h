@@ -0,0 +1,29 @@
+#ifndef AMS_MERGE_H
+#define AMS_MERGE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+
+// Tray that took a new value from a report
+struct AmsTrayChange {
+    uint8_t amsId;
+    uint8_t trayId;         // 254 = external spool
+    bool filled;            // was empty before the report
+    bool spoolChanged;      // holds a different spool than before (filled or swapped)
+    bool isBambuSpool;      // RFID tag or tray UUID reported
+};
+
+struct AmsMergeResult {
+    std::vector<AmsTrayChange> changes;
+    bool newAms = false;    // unit added, a delta may have carried only part of it
+};
+
+// Apply the "print" object of a Bambu report onto ams_data. Reports may be
+// partial: only the AMS units, trays and fields they contain are changed, every
+// changed tray gets a new version.
+AmsMergeResult amsMergeReport(JsonObject print);
+// Result of an ams_filament_setting command
+bool amsMergeSetting(int amsId, int trayId, const String& settingId);
+
+#endif
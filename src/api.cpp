@@ -1,11 +1,21 @@
 #include "api.h"
 #include <HTTPClient.h>
+#include <functional>
+#include <deque>
 #include <ArduinoJson.h>
 #include "commonFS.h"
 #include <Preferences.h>
 #include "debug.h"
 #include "scale.h"
 #include "nfc.h"
+#include "offline.h"
+#include "spool_cache.h"
+#include "brand_cache.h"
+#include "api_future.h"
+#include "spoolman_events.h"
+#include "http_pool.h"
+#include "upstream.h"
+#include "spoolman_endpoint.h"
 #include <time.h>
 volatile spoolmanApiStateType spoolmanApiState = API_IDLE;
 
@@ -13,19 +23,12 @@ volatile spoolmanApiStateType spoolmanApiState = API_IDLE;
 String spoolmanUrl = "";
 String spoolmanInternalUrl = "";
 bool octoEnabled = false;
-bool sendOctoUpdate = false;
 String octoUrl = "";
 String octoToken = "";
+String octoTool = OCTOPRINT_DEFAULT_TOOL;
 uint16_t remainingWeight = 0;
-uint16_t createdVendorId = 0;  // Store ID of newly created vendor
-uint16_t foundVendorId = 0;    // Store ID of found vendor
-uint16_t foundFilamentId = 0;  // Store ID of found filament
-uint16_t createdFilamentId = 0;  // Store ID of newly created filament
-uint16_t createdSpoolId = 0;  // Store ID of newly created spool
-uint16_t updateOctoSpoolId = 0; // Store spool ID for OctoPrint update
 bool spoolmanConnected = false;
 bool spoolmanExtraFieldsChecked = false;
-TaskHandle_t* apiTask;
 
 // Generate a tag ID from the NFC UID: hex characters from UID + random 8 alphanumeric chars
 String generateTagId(const String& uidString) {
@@ -48,412 +51,1007 @@ String generateTagId(const String& uidString) {
     return cleanUid + randomPart;
 }
 
-struct SendToApiParams {
+// #### API worker
+// A single long-lived task works through the job queue. Requests to the same
+// origin share one transport so HTTP keep-alive can skip the TCP/TLS setup.
+// Jobs with a coalesce key (e.g. weight of spool 12) replace a still queued job
+// with the same key instead of queueing behind it (last write wins).
+// Jobs are served by priority class: interactive (what the operator waits for),
+// normal (Bambu, offline replay) and background (prefetch, warm-up, health).
+// A waiting job moves up one class every API_JOB_AGING_MS so background work is
+// not starved. A job still queued at its deadline is dropped, writes go to the
+// offline log instead.
+
+// Runs on the API worker after the response has been handled
+typedef std::function<void(bool success, int httpCode, JsonDocument& response)> ApiJobCallback;
+
+enum ApiJobPriority : uint8_t {
+    API_PRIORITY_INTERACTIVE,
+    API_PRIORITY_NORMAL,
+    API_PRIORITY_BACKGROUND,
+    API_PRIORITY_COUNT
+};
+
+struct ApiJob {
     SpoolmanApiRequestType requestType;
     String httpType;
-    String spoolsUrl;
-    String updatePayload;
+    String url;
+    String payload;
     String octoToken;
-    // Weight update parameters for sequential execution
-    bool triggerWeightUpdate;
-    String spoolIdForWeight;
-    uint16_t weightValue;
+    String coalesceKey;     // empty = never coalesced
+    bool chained;           // follow-up of the job that queued it, goes to the front of its class
+    String walKey;          // set when replayed from the offline log
+    String etag;            // sent as If-None-Match, 304 then counts as success
+    ApiJobCallback onComplete;
+    ApiFuture::Ptr step;    // workflow step waiting for the result, the job is dropped once it timed out
+    ApiJobPriority priority;
+    unsigned long queuedAt;
+    unsigned long deadline; // 0 = none (replayed entries)
 };
 
-JsonDocument fetchSingleSpoolInfo(int spoolId) {
-    HTTPClient http;
-    http.setReuse(false);
-    http.setTimeout(10000);
-    String targetUrl = (spoolmanInternalUrl != "") ? spoolmanInternalUrl : spoolmanUrl;
-    String spoolsUrl = targetUrl + apiUrl + "/spool/" + spoolId;
+struct ApiQueueStats {
+    uint32_t queued;
+    uint32_t coalesced;     // superseded by a newer job with the same key
+    uint32_t rejected;      // queue full
+    uint32_t completed;
+    uint32_t failed;
+    uint32_t expired;       // deadline passed while queued
+    uint32_t aged;          // served ahead of a higher class after waiting
+};
 
-    Serial.print("Rufe Spool-Daten von: ");
-    Serial.println(spoolsUrl);
+static const unsigned long apiDeadlineMs[API_PRIORITY_COUNT] = {
+    API_DEADLINE_INTERACTIVE_MS, API_DEADLINE_NORMAL_MS, API_DEADLINE_BACKGROUND_MS
+};
 
-    http.begin(spoolsUrl);
-    int httpCode = http.GET();
+static std::deque<ApiJob*> apiJobQueues[API_PRIORITY_COUNT];  // guarded by apiPendingMutex
+static TaskHandle_t apiWorkerTask = NULL;
+static volatile bool apiJobRunning = false;
+static volatile ApiJobPriority apiRunningPriority = API_PRIORITY_COUNT;
+static SemaphoreHandle_t apiPendingMutex = NULL;
+static ApiQueueStats apiQueueStats = {};
+static volatile uint16_t offlineReplayOutstanding = 0;
+static String apiResponseEtag;  // ETag of the current response, valid inside completion callbacks
+
+// #### Spoolman health
+// Tracked passively: every answer from Spoolman proves it is up, a request that
+// got none on any endpoint proves it is down. The health check only probes an
+// endpoint that has been idle. Changes are counted in spoolmanHealthChanges, the
+// main loop publishes them to the display and web clients.
+static volatile uint32_t spoolmanHealthChanges = 0;
+static volatile bool spoolmanReachablePending = false;  // follow-up work for the worker
+
+static void onSpoolmanReachable();
+
+static void setSpoolmanConnected(bool connected) {
+    if (spoolmanConnected == connected) return;
+    spoolmanConnected = connected;
+    if (connected) spoolmanReachablePending = true;
+    spoolmanHealthChanges++;
+    Serial.println(connected ? "Spoolman reachable" : "Spoolman unreachable");
+}
 
-    JsonDocument filteredDoc;
-    if (httpCode == HTTP_CODE_OK) {
-        String payload = http.getString();
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, payload);
-        if (error) {
-            Serial.print("Fehler beim Parsen der JSON-Antwort: ");
-            Serial.println(error.c_str());
-        } else {
-            String filamentType = doc["filament"]["material"].as<String>();
-            String filamentBrand = doc["filament"]["vendor"]["name"].as<String>();
-
-            int nozzle_temp_min = 0;
-            int nozzle_temp_max = 0;
-            if (doc["filament"]["extra"]["nozzle_temperature"].is<String>()) {
-                String tempString = doc["filament"]["extra"]["nozzle_temperature"].as<String>();
-                tempString.replace("[", "");
-                tempString.replace("]", "");
-                int commaIndex = tempString.indexOf(',');
-                
-                if (commaIndex != -1) {
-                    nozzle_temp_min = tempString.substring(0, commaIndex).toInt();
-                    nozzle_temp_max = tempString.substring(commaIndex + 1).toInt();
-                }
-            } 
+uint32_t spoolmanHealthVersion() {
+    return spoolmanHealthChanges;
+}
+
+// Caller holds apiPendingMutex
+static size_t apiQueuedJobCount() {
+    size_t count = 0;
+    for (uint8_t p = 0; p < API_PRIORITY_COUNT; p++) count += apiJobQueues[p].size();
+    return count;
+}
 
-            String filamentColor = doc["filament"]["color_hex"].as<String>();
-            filamentColor.toUpperCase();
+static void apiUpdateIdleState() {
+    if (apiJobRunning || apiPendingMutex == NULL) return;
 
-            String tray_info_idx = doc["filament"]["extra"]["bambu_idx"].as<String>();
-            tray_info_idx.replace("\"", "");
-            
-            String cali_idx = doc["filament"]["extra"]["bambu_cali_id"].as<String>(); // "\"153\""
-            cali_idx.replace("\"", "");
-            
-            String bambu_setting_id = doc["filament"]["extra"]["bambu_setting_id"].as<String>(); // "\"PFUSf40e9953b40d3d\""
-            bambu_setting_id.replace("\"", "");
+    xSemaphoreTake(apiPendingMutex, portMAX_DELAY);
+    bool empty = apiQueuedJobCount() == 0;
+    xSemaphoreGive(apiPendingMutex);
+    if (empty) spoolmanApiState = API_IDLE;
+}
 
-            doc.clear();
+bool apiForegroundBusy() {
+    if (apiRunningPriority == API_PRIORITY_INTERACTIVE) return true;
+    if (apiPendingMutex == NULL) return false;
 
-            filteredDoc["color"] = filamentColor;
-            filteredDoc["type"] = filamentType;
-            filteredDoc["nozzle_temp_min"] = nozzle_temp_min;
-            filteredDoc["nozzle_temp_max"] = nozzle_temp_max;
-            filteredDoc["brand"] = filamentBrand;
-            filteredDoc["tray_info_idx"] = tray_info_idx;
-            filteredDoc["cali_idx"] = cali_idx;
-            filteredDoc["bambu_setting_id"] = bambu_setting_id;
+    xSemaphoreTake(apiPendingMutex, portMAX_DELAY);
+    bool busy = !apiJobQueues[API_PRIORITY_INTERACTIVE].empty();
+    xSemaphoreGive(apiPendingMutex);
+    return busy;
+}
+
+// Evaluate a successful response; ids for the brand workflow reach their futures via the job callback
+static void handleApiResponse(SpoolmanApiRequestType requestType, JsonDocument& doc) {
+    switch(requestType){
+    case API_REQUEST_SPOOL_WEIGHT_UPDATE:
+        remainingWeight = doc["remaining_weight"].as<uint16_t>();
+        offlineMirrorUpdate(doc.as<JsonObjectConst>());
+        spoolCacheStore(doc.as<JsonObjectConst>(), "");
+        Serial.print("Aktuelles Gewicht: ");
+        Serial.println(remainingWeight);
+        // With OctoPrint the remaining weight is shown once the chained selection is done
+        if(!octoEnabled){
+            oledShowMessage("Remaining: " + String(remainingWeight) + "g");
+            remainingWeight = 0;
+        }
+        break;
+    case API_REQUEST_SPOOL_LOCATION_UPDATE:
+        offlineMirrorUpdate(doc.as<JsonObjectConst>());
+        spoolCacheStore(doc.as<JsonObjectConst>(), "");
+        oledShowProgressBar(1, 1, "Loc. Tag", "Done!");
+        break;
+    case API_REQUEST_SPOOL_TAG_ID_UPDATE:
+        offlineMirrorUpdate(doc.as<JsonObjectConst>());
+        spoolCacheStore(doc.as<JsonObjectConst>(), "");
+        oledShowProgressBar(1, 1, "Write Tag", "Done!");
+        break;
+    case API_REQUEST_OCTO_SPOOL_UPDATE:
+        Serial.println("Octoprint spool selected");
+        break;
+    case API_REQUEST_VENDOR_CREATE:
+        Serial.println("Vendor successfully created!");
+        brandCacheStoreVendor(doc["name"].as<String>(), doc["id"].as<uint16_t>());
+        Serial.print("Created Vendor ID: ");
+        Serial.println(doc["id"].as<uint16_t>());
+        oledShowProgressBar(1, 1, "Vendor", "Created!");
+        break;
+    case API_REQUEST_VENDOR_CHECK:
+        if (doc.isNull() || doc.size() == 0) {
+            Serial.println("Vendor not found in response");
+        } else {
+            brandCacheStoreVendor(doc[0]["name"].as<String>(), doc[0]["id"].as<uint16_t>());
+            Serial.print("Found Vendor ID: ");
+            Serial.println(doc[0]["id"].as<uint16_t>());
         }
+        break;
+    case API_REQUEST_FILAMENT_CHECK:
+        if (doc.isNull() || doc.size() == 0) {
+            Serial.println("Filament not found in response");
+        } else {
+            brandCacheStoreFilament(doc[0]["vendor"]["id"].as<uint16_t>(), doc[0]["external_id"] | "", doc[0]["id"].as<uint16_t>());
+            Serial.print("Found Filament ID: ");
+            Serial.println(doc[0]["id"].as<uint16_t>());
+        }
+        break;
+    case API_REQUEST_FILAMENT_CREATE:
+        Serial.println("Filament successfully created!");
+        brandCacheStoreFilament(doc["vendor"]["id"].as<uint16_t>(), doc["external_id"] | "", doc["id"].as<uint16_t>());
+        Serial.print("Created Filament ID: ");
+        Serial.println(doc["id"].as<uint16_t>());
+        oledShowProgressBar(1, 1, "Filament", "Created!");
+        break;
+    case API_REQUEST_SPOOL_CREATE:
+        Serial.println("Spool successfully created!");
+        Serial.print("Created Spool ID: ");
+        Serial.println(doc["id"].as<uint16_t>());
+        oledShowProgressBar(1, 1, "Spool", "Created!");
+        break;
+    default:
+        break;
+    }
+}
+
+// failedFast: the circuit breaker refused the request, nothing to wait for
+static void handleApiFailure(SpoolmanApiRequestType requestType, int httpCode, bool failedFast = false) {
+    // Background requests fail quietly
+    if (requestType == API_REQUEST_SPOOL_FETCH || requestType == API_REQUEST_VENDOR_LIST ||
+        requestType == API_REQUEST_FILAMENT_LIST || requestType == API_REQUEST_HEALTH_CHECK ||
+        requestType == API_REQUEST_SERVER_INFO) {
+        Serial.println("Background request failed, HTTP Code: " + String(httpCode));
+        return;
+    }
+
+    switch(requestType){
+    case API_REQUEST_SPOOL_WEIGHT_UPDATE:
+    case API_REQUEST_SPOOL_LOCATION_UPDATE:
+    case API_REQUEST_SPOOL_TAG_ID_UPDATE:
+        oledShowProgressBar(1, 1, "Failure!", "Spoolman update");
+        break;
+    case API_REQUEST_OCTO_SPOOL_UPDATE:
+        oledShowProgressBar(1, 1, "Failure!", "Octoprint update");
+        break;
+    case API_REQUEST_BAMBU_UPDATE:
+        oledShowProgressBar(1, 1, "Failure!", "Bambu update");
+        break;
+    case API_REQUEST_VENDOR_CHECK:
+        oledShowProgressBar(1, 1, "Failure!", "Vendor check");
+        break;
+    case API_REQUEST_VENDOR_CREATE:
+        oledShowProgressBar(1, 1, "Failure!", "Vendor create");
+        break;
+    case API_REQUEST_FILAMENT_CHECK:
+        oledShowProgressBar(1, 1, "Failure!", "Filament check");
+        break;
+    case API_REQUEST_FILAMENT_CREATE:
+        oledShowProgressBar(1, 1, "Failure!", "Filament create");
+        break;
+    case API_REQUEST_SPOOL_CREATE:
+        oledShowProgressBar(1, 1, "Failure!", "Spool create");
+        break;
+    }
+    if (failedFast) {
+        Serial.println("Nicht gesendet, Server nicht erreichbar");
     } else {
-        Serial.print("Fehler beim Abrufen der Spool-Daten. HTTP-Code: ");
-        Serial.println(httpCode);
+        Serial.println("Fehler beim Senden an Spoolman! HTTP Code: " + String(httpCode));
+        oledHoldMessage(API_FAILURE_DISPLAY_MS);
     }
+    nfcReaderState = NFC_IDLE; // Reset NFC state to allow retry
+}
 
-    http.end();
-    return filteredDoc;
+// #### Response parsing
+// Bodies are parsed straight from the socket through a filter, so only the
+// fields a request type uses are ever allocated.
+
+// Everything the spool cache and the offline mirror keep from a spool document
+static void buildSpoolFilter(JsonVariant filter) {
+    filter["id"] = true;
+    filter["location"] = true;
+    filter["spool_weight"] = true;
+    filter["initial_weight"] = true;
+    filter["remaining_weight"] = true;
+
+    JsonObject filament = filter["filament"].to<JsonObject>();
+    filament["id"] = true;
+    filament["name"] = true;
+    filament["material"] = true;
+    filament["color_hex"] = true;
+    filament["spool_weight"] = true;
+    filament["weight"] = true;
+    filament["vendor"]["id"] = true;
+    filament["vendor"]["name"] = true;
+    filament["extra"]["nozzle_temperature"] = true;
+    filament["extra"]["bambu_idx"] = true;
+    filament["extra"]["bambu_cali_id"] = true;
+    filament["extra"]["bambu_setting_id"] = true;
 }
 
-void sendToApi(void *parameter) {
-    HEAP_DEBUG_MESSAGE("sendToApi begin");
+static void buildResponseFilter(SpoolmanApiRequestType requestType, JsonDocument& filter) {
+    switch (requestType) {
+    case API_REQUEST_SPOOL_WEIGHT_UPDATE:
+    case API_REQUEST_SPOOL_LOCATION_UPDATE:
+    case API_REQUEST_SPOOL_TAG_ID_UPDATE:
+    case API_REQUEST_SPOOL_FETCH:
+        buildSpoolFilter(filter.to<JsonVariant>());
+        break;
+    // The first array element of a filter applies to all elements
+    case API_REQUEST_VENDOR_CHECK:
+    case API_REQUEST_VENDOR_LIST:
+        filter[0]["id"] = true;
+        filter[0]["name"] = true;
+        break;
+    case API_REQUEST_FILAMENT_CHECK:
+    case API_REQUEST_FILAMENT_LIST:
+        filter[0]["id"] = true;
+        filter[0]["external_id"] = true;
+        filter[0]["vendor"]["id"] = true;
+        break;
+    case API_REQUEST_VENDOR_CREATE:
+        filter["id"] = true;
+        filter["name"] = true;
+        break;
+    case API_REQUEST_FILAMENT_CREATE:
+        filter["id"] = true;
+        filter["external_id"] = true;
+        filter["vendor"]["id"] = true;
+        break;
+    case API_REQUEST_SPOOL_CREATE:
+        filter["id"] = true;
+        break;
+    case API_REQUEST_HEALTH_CHECK:
+        filter["status"] = true;
+        break;
+    case API_REQUEST_SERVER_INFO:
+        filter["version"] = true;
+        break;
+    default:
+        // Body is not evaluated, parse it anyway to consume it
+        filter["id"] = true;
+        break;
+    }
+}
 
-    // Wait until API is IDLE
-    while(spoolmanApiState != API_IDLE){
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-        yield();
+// Parse from the stream when Content-Length is known, chunked bodies are buffered first
+static DeserializationError deserializeResponse(HTTPClient& http, JsonDocument& doc, const JsonDocument& filter) {
+    if (http.getSize() > 0) {
+        return deserializeJson(doc, http.getStream(), DeserializationOption::Filter(filter));
+    }
+    String payload = http.getString();
+    return deserializeJson(doc, payload, DeserializationOption::Filter(filter));
+}
+
+// #### Offline log
+// Spool updates that cannot reach Spoolman go to the write-ahead log (offline.cpp)
+// and are replayed in order once the health check sees the server again.
+static bool isOfflineCapable(SpoolmanApiRequestType requestType) {
+    return requestType == API_REQUEST_SPOOL_WEIGHT_UPDATE ||
+           requestType == API_REQUEST_SPOOL_LOCATION_UPDATE ||
+           requestType == API_REQUEST_SPOOL_TAG_ID_UPDATE;
+}
+
+static bool logOfflineUpdate(SpoolmanApiRequestType requestType, const String& httpType, const String& url,
+                             const String& payload, const String& coalesceKey) {
+    String path;
+    if (!spoolmanEndpointRelative(url, path)) return false;
+
+    OfflineUpdate update;
+    update.requestType = requestType;
+    update.method = httpType;
+    update.path = path;
+    update.payload = payload;
+    update.coalesceKey = coalesceKey;
+    if (!offlineLogAppend(update)) return false;
+
+    // Keep the local mirror in step so the next weigh-in shows sensible values
+    uint16_t spoolId = coalesceKey.substring(coalesceKey.indexOf(':') + 1).toInt();
+    JsonDocument doc;
+    deserializeJson(doc, payload);
+    switch (requestType) {
+    case API_REQUEST_SPOOL_WEIGHT_UPDATE: {
+        uint16_t remaining = 0;
+        if (spoolId > 0 && offlineMirrorApplyWeight(spoolId, doc["weight"].as<uint16_t>(), remaining)) {
+            oledShowMessage("Offline: " + String(remaining) + "g");
+        } else {
+            oledShowProgressBar(1, 1, "Spool Tag", "Saved offline");
+        }
+        break;
+    }
+    case API_REQUEST_SPOOL_LOCATION_UPDATE:
+        if (spoolId > 0) offlineMirrorApplyLocation(spoolId, doc["location"].as<String>());
+        oledShowProgressBar(1, 1, "Loc. Tag", "Saved offline");
+        break;
+    default:
+        oledShowProgressBar(1, 1, "Write Tag", "Saved offline");
+        break;
+    }
+    return true;
+}
+
+static UpstreamId upstreamOf(SpoolmanApiRequestType requestType) {
+    return (requestType == API_REQUEST_OCTO_SPOOL_UPDATE) ? UPSTREAM_OCTOPRINT : UPSTREAM_SPOOLMAN;
+}
+
+static bool runApiJob(ApiJob& job) {
+    // Replay stops as soon as Spoolman is gone again, the entries stay in the log
+    if (job.walKey.length() > 0 && !spoolmanConnected) {
+        JsonDocument empty;
+        if (job.onComplete) job.onComplete(false, -1, empty);
+        return false;
     }
-    spoolmanApiState = API_TRANSMITTING;
-    SendToApiParams* params = (SendToApiParams*)parameter;
-
-    // Extract values including weight update parameters
-    SpoolmanApiRequestType requestType = params->requestType;
-    String httpType = params->httpType;
-    String spoolsUrl = params->spoolsUrl;
-    String updatePayload = params->updatePayload;
-    String octoToken = params->octoToken;
-    bool triggerWeightUpdate = params->triggerWeightUpdate;
-    String spoolIdForWeight = params->spoolIdForWeight;
-    uint16_t weightValue = params->weightValue;
 
     // Retry mechanism with configurable parameters
-    const uint8_t MAX_RETRIES = 3;
-    const uint16_t RETRY_DELAY_MS = 1000; // 1 second between retries
-    const uint16_t HTTP_TIMEOUT_MS = 10000; // 10 second HTTP timeout
-    
+    // Background work gets one short attempt so it never holds up a weigh-in for long
+    const bool background = job.priority == API_PRIORITY_BACKGROUND;
+    const uint8_t MAX_RETRIES = background ? 1 : API_JOB_MAX_ATTEMPTS;
+    const uint16_t RETRY_DELAY_MS = API_RETRY_DELAY_MS;
+    const UpstreamId upstream = upstreamOf(job.requestType);
+    // A health probe tests one endpoint, which may be the unused alternate. Its outcome
+    // only goes to the endpoint statistics, not to the breaker and RTT of the upstream.
+    const bool probe = job.requestType == API_REQUEST_HEALTH_CHECK;
+
     bool success = false;
+    bool failedFast = false;
     int httpCode = -1;
-    String responsePayload = "";
-    
-    // Try request with retries
+    JsonDocument doc;
+    DeserializationError parseError;
+    JsonDocument filter;
+    buildResponseFilter(job.requestType, filter);
+    apiResponseEtag = "";
+    const char* collectedHeaders[] = { "ETag" };
+
     for (uint8_t attempt = 1; attempt <= MAX_RETRIES && !success; attempt++) {
-        Serial.printf("API Request attempt %d/%d to: %s\n", attempt, MAX_RETRIES, spoolsUrl.c_str());
-        
+        // Open breaker: fail fast instead of waiting for another timeout
+        if (!probe && !upstreamAllow(upstream)) {
+            Serial.println("API Request skipped, upstream unreachable: " + job.url);
+            failedFast = true;
+            httpCode = -1;
+            break;
+        }
+        // Spoolman requests follow the endpoint selector, a retry may go to the other URL.
+        // Health checks probe one endpoint each and stay where they are.
+        String url = (job.requestType == API_REQUEST_HEALTH_CHECK) ? job.url : spoolmanEndpointRoute(job.url);
+        Serial.printf("API Request attempt %d/%d to: %s\n", attempt, MAX_RETRIES, url.c_str());
+
+        // Timeout follows the measured response times of this upstream
+        uint16_t timeoutMs = upstreamTimeoutMs(upstream);
+        if (background && timeoutMs > API_BACKGROUND_TIMEOUT_MS) timeoutMs = API_BACKGROUND_TIMEOUT_MS;
+
+        WiFiClient* lease = nullptr;
         HTTPClient http;
-        http.setReuse(false);
-        http.setTimeout(HTTP_TIMEOUT_MS); // Set HTTP timeout
-        
-        http.begin(spoolsUrl);
+        http.setConnectTimeout(timeoutMs);
+        http.setTimeout(timeoutMs);
+
+        if (!httpPoolBegin(http, url, lease)) {
+            Serial.println("API: invalid URL " + url);
+            break;
+        }
         http.addHeader("Content-Type", "application/json");
-        if (octoEnabled && octoToken != "") http.addHeader("X-Api-Key", octoToken);
+        if (octoEnabled && job.octoToken != "") http.addHeader("X-Api-Key", job.octoToken);
+        if (job.etag.length() > 0) http.addHeader("If-None-Match", job.etag);
+        http.collectHeaders(collectedHeaders, 1);
 
         // Execute HTTP request based on type
-        if (httpType == "PATCH") httpCode = http.PATCH(updatePayload);
-        else if (httpType == "POST") httpCode = http.POST(updatePayload);
-        else if (httpType == "GET") httpCode = http.GET();
-        else httpCode = http.PUT(updatePayload);
+        unsigned long requestStart = millis();
+        if (job.httpType == "PATCH") httpCode = http.PATCH(job.payload);
+        else if (job.httpType == "POST") httpCode = http.POST(job.payload);
+        else if (job.httpType == "GET") httpCode = http.GET();
+        else httpCode = http.PUT(job.payload);
+        uint32_t elapsed = millis() - requestStart;
+        bool answered = httpCode > 0 && httpCode < 500;
+        if (!probe) upstreamRecord(upstream, answered, elapsed);
+        spoolmanEndpointRecord(url, answered, elapsed);
+        if (answered && upstream == UPSTREAM_SPOOLMAN) setSpoolmanConnected(true);
+
+        if (httpCode == HTTP_CODE_NOT_MODIFIED && job.etag.length() > 0) {
+            success = true;
+            Serial.println("API Request: not modified");
+            httpPoolEnd(http, lease, true);
+            break;
+        }
 
-        // Check if request was successful
         if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_CREATED) {
-            responsePayload = http.getString();
+            apiResponseEtag = http.header("ETag");
+            parseError = deserializeResponse(http, doc, filter);
             success = true;
             Serial.printf("API Request successful on attempt %d, HTTP Code: %d\n", attempt, httpCode);
-        } else {
-            Serial.printf("API Request failed on attempt %d, HTTP Code: %d (%s)\n", 
-                         attempt, httpCode, http.errorToString(httpCode).c_str());
-            
-            // Don't retry on certain error codes (client errors)
-            if (httpCode >= 400 && httpCode < 500 && httpCode != 408 && httpCode != 429) {
-                Serial.println("Client error detected, stopping retries");
-                break;
-            }
-            
-            // Wait before retry (except on last attempt)
-            if (attempt < MAX_RETRIES) {
-                Serial.printf("Waiting %dms before retry...\n", RETRY_DELAY_MS);
-                http.end();
-                vTaskDelay(RETRY_DELAY_MS / portTICK_PERIOD_MS);
-                continue;
-            }
+            // A body that was not read to the end leaves the connection unusable
+            httpPoolEnd(http, lease, !parseError);
+            break;
+        }
+
+        Serial.printf("API Request failed on attempt %d, HTTP Code: %d (%s)\n",
+                      attempt, httpCode, http.errorToString(httpCode).c_str());
+        // The error body is not read, leftover bytes would be taken for the next response
+        httpPoolEnd(http, lease, false);
+
+        // Don't retry on certain error codes (client errors)
+        if (httpCode >= 400 && httpCode < 500 && httpCode != 408 && httpCode != 429) {
+            Serial.println("Client error detected, stopping retries");
+            break;
+        }
+
+        if (!probe && upstreamIsOpen(upstream)) break;
+
+        if (attempt < MAX_RETRIES) {
+            Serial.printf("Waiting %dms before retry...\n", RETRY_DELAY_MS);
+            vTaskDelay(RETRY_DELAY_MS / portTICK_PERIOD_MS);
         }
-        
-        http.end();
     }
 
-    // Process successful response
-    if (success) {
+    bool unreachable = (httpCode < 0 || httpCode >= 500);
+    if (!success && unreachable && upstream == UPSTREAM_SPOOLMAN && (failedFast || !spoolmanEndpointAnyHealthy())) {
+        setSpoolmanConnected(false);
+    }
+    if (success && httpCode == HTTP_CODE_NOT_MODIFIED) {
+        // Nothing to parse, the callback keeps its cached copy
+    } else if (success) {
         Serial.println("Spoolman Abfrage erfolgreich");
-
-        // Restgewicht der Spule auslesen
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, responsePayload);
-        if (error) {
+        if (parseError) {
             Serial.print("Fehler beim Parsen der JSON-Antwort: ");
-            Serial.println(error.c_str());
+            Serial.println(parseError.c_str());
         } else {
-            switch(requestType){
-            case API_REQUEST_SPOOL_WEIGHT_UPDATE:
-                remainingWeight = doc["remaining_weight"].as<uint16_t>();
-                Serial.print("Aktuelles Gewicht: ");
-                Serial.println(remainingWeight);
-                //oledShowMessage("Remaining: " + String(remaining_weight) + "g");
-                if(!octoEnabled){
-                    // TBD: Do not use Strings...
-                    //oledShowProgressBar(1, 1, "Spool Tag", ("Done: " + String(remainingWeight) + " g remain").c_str());
-                    oledShowMessage("Remaining: " + String(remainingWeight) + "g");
-                    remainingWeight = 0;
-                }else{
-                    // ocoto is enabled, trigger octo update
-                    sendOctoUpdate = true;
-                }
-                break;
-            case API_REQUEST_SPOOL_LOCATION_UPDATE:
-                oledShowProgressBar(1, 1, "Loc. Tag", "Done!");
-                break;
-            case API_REQUEST_SPOOL_TAG_ID_UPDATE:
-                oledShowProgressBar(1, 1, "Write Tag", "Done!");
-                break;
-            case API_REQUEST_OCTO_SPOOL_UPDATE:
-                // TBD: Do not use Strings...
-                //oledShowProgressBar(5, 5, "Spool Tag", ("Done: " + String(remainingWeight) + " g remain").c_str());
-                oledShowMessage("Remaining: " + String(remainingWeight) + "g");
-                remainingWeight = 0;
-                break;
-            case API_REQUEST_VENDOR_CREATE:
-                Serial.println("Vendor successfully created!");
-                createdVendorId = doc["id"].as<uint16_t>();
-                Serial.print("Created Vendor ID: ");
-                Serial.println(createdVendorId);
-                oledShowProgressBar(1, 1, "Vendor", "Created!");
-                break;
-            case API_REQUEST_VENDOR_CHECK:
-                if (doc.isNull() || doc.size() == 0) {
-                    Serial.println("Vendor not found in response");
-                    foundVendorId = 0;
-                } else {
-                    foundVendorId = doc[0]["id"].as<uint16_t>();
-                    Serial.print("Found Vendor ID: ");
-                    Serial.println(foundVendorId);
-                }
-                break;
-            case API_REQUEST_FILAMENT_CHECK:
-                if (doc.isNull() || doc.size() == 0) {
-                    Serial.println("Filament not found in response");
-                    foundFilamentId = 0;
-                } else {
-                    foundFilamentId = doc[0]["id"].as<uint16_t>();
-                    Serial.print("Found Filament ID: ");
-                    Serial.println(foundFilamentId);
-                }
-                break;
-            case API_REQUEST_FILAMENT_CREATE:
-                Serial.println("Filament successfully created!");
-                createdFilamentId = doc["id"].as<uint16_t>();
-                Serial.print("Created Filament ID: ");
-                Serial.println(createdFilamentId);
-                oledShowProgressBar(1, 1, "Filament", "Created!");
-                break;
-            case API_REQUEST_SPOOL_CREATE:
-                Serial.println("Spool successfully created!");
-                createdSpoolId = doc["id"].as<uint16_t>();
-                Serial.print("Created Spool ID: ");
-                Serial.println(createdSpoolId);
-                oledShowProgressBar(1, 1, "Spool", "Created!");
-                break;
+            handleApiResponse(job.requestType, doc);
+        }
+    } else if (isOfflineCapable(job.requestType) && unreachable) {
+        // Keep the update instead of dropping it
+        if (job.walKey.length() == 0 && !logOfflineUpdate(job.requestType, job.httpType, job.url, job.payload, job.coalesceKey)) {
+            handleApiFailure(job.requestType, httpCode, failedFast);
+        }
+    } else {
+        handleApiFailure(job.requestType, httpCode, failedFast);
+    }
+
+    if (job.onComplete) job.onComplete(success, httpCode, doc);
+    doc.clear();
+    return success;
+}
+
+static ApiJobPriority apiPriorityOf(const ApiJob& job) {
+    if (job.walKey.length() > 0) return API_PRIORITY_NORMAL;
+    switch (job.requestType) {
+    case API_REQUEST_BAMBU_UPDATE:
+        return API_PRIORITY_NORMAL;
+    case API_REQUEST_SPOOL_FETCH:
+    case API_REQUEST_VENDOR_LIST:
+    case API_REQUEST_FILAMENT_LIST:
+    case API_REQUEST_HEALTH_CHECK:
+    case API_REQUEST_SERVER_INFO:
+        return API_PRIORITY_BACKGROUND;
+    default:
+        return API_PRIORITY_INTERACTIVE;
+    }
+}
+
+// Caller holds apiPendingMutex
+static ApiJob* findQueuedKeyed(const String& key) {
+    for (uint8_t p = 0; p < API_PRIORITY_COUNT; p++) {
+        for (ApiJob* queued : apiJobQueues[p]) {
+            if (queued->walKey.length() == 0 && queued->coalesceKey == key) return queued;
+        }
+    }
+    return nullptr;
+}
+
+// Caller holds apiPendingMutex. Takes queued replays with this key out of the queue,
+// a live update with the same key carries newer data.
+static void takeQueuedReplays(const String& key, std::vector<ApiJob*>& replays) {
+    for (uint8_t p = 0; p < API_PRIORITY_COUNT; p++) {
+        for (auto it = apiJobQueues[p].begin(); it != apiJobQueues[p].end();) {
+            if ((*it)->walKey.length() > 0 && (*it)->coalesceKey == key) {
+                replays.push_back(*it);
+                it = apiJobQueues[p].erase(it);
+            } else {
+                ++it;
             }
         }
-        doc.clear();
-    } else if (httpCode == HTTP_CODE_CREATED) {
-        Serial.println("Spoolman erfolgreich erstellt");
-        
-        // Parse response for created resources  
+    }
+}
+
+// The log entry is settled by the newer update and must not overwrite it later
+static void dropSupersededReplay(ApiJob* job) {
+    Serial.printf("API: %s replay superseded by live update\n", job->coalesceKey.c_str());
+    offlineLogAck(job->walKey);
+    apiQueueStats.coalesced++;
+    JsonDocument empty;
+    if (job->onComplete) job->onComplete(false, -1, empty);
+    delete job;
+}
+
+// Head of the class with the best effective priority. Waiting lowers the class by
+// one step per API_JOB_AGING_MS, on a tie the older job wins. Caller holds apiPendingMutex.
+static ApiJob* takeNextJob() {
+    unsigned long now = millis();
+    int8_t best = -1;
+    long bestEffective = 0;
+    unsigned long bestWaited = 0;
+    for (uint8_t p = 0; p < API_PRIORITY_COUNT; p++) {
+        if (apiJobQueues[p].empty()) continue;
+        unsigned long waited = now - apiJobQueues[p].front()->queuedAt;
+        long effective = (long)p - (long)(waited / API_JOB_AGING_MS);
+        if (effective < 0) effective = 0;
+        if (best == -1 || effective < bestEffective || (effective == bestEffective && waited > bestWaited)) {
+            best = p;
+            bestEffective = effective;
+            bestWaited = waited;
+        }
+    }
+    if (best == -1) return nullptr;
+
+    for (int8_t p = 0; p < best; p++) {
+        if (!apiJobQueues[p].empty()) {
+            apiQueueStats.aged++;
+            break;
+        }
+    }
+    ApiJob* job = apiJobQueues[best].front();
+    apiJobQueues[best].pop_front();
+    return job;
+}
+
+// Nobody waits for the result any more: writes are kept in the offline log, the rest is dropped
+static void expireApiJob(ApiJob& job) {
+    apiQueueStats.expired++;
+    Serial.printf("API: request expired after %lu ms in queue: %s\n", millis() - job.queuedAt, job.url.c_str());
+    if (isOfflineCapable(job.requestType) && job.walKey.length() == 0) {
+        logOfflineUpdate(job.requestType, job.httpType, job.url, job.payload, job.coalesceKey);
+    }
+    JsonDocument empty;
+    if (job.onComplete) job.onComplete(false, -1, empty);
+}
+
+static void apiWorker(void *parameter) {
+    for (;;) {
+        // Wake up regularly so workflow steps that never got an answer time out
+        apiFutureSweep();
+        httpPoolSweep();
+
+        // Replay and cache warm-up queue new jobs, so they run between jobs
+        if (spoolmanReachablePending && spoolmanConnected) {
+            spoolmanReachablePending = false;
+            onSpoolmanReachable();
+        }
+
+        // A job taken from the queue can no longer be replaced by a newer one
+        xSemaphoreTake(apiPendingMutex, portMAX_DELAY);
+        ApiJob* job = takeNextJob();
+        if (job != nullptr) {
+            apiJobRunning = true;
+            apiRunningPriority = job->priority;
+        }
+        xSemaphoreGive(apiPendingMutex);
+
+        if (job == nullptr) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(API_FUTURE_SWEEP_MS));
+            continue;
+        }
+
+        spoolmanApiState = API_TRANSMITTING;
+        HEAP_DEBUG_MESSAGE("apiJob begin");
+
+        if (job->step && job->step->isResolved()) {
+            // The workflow has moved on, e.g. to create the vendor after a failed check
+            Serial.println("API: step already timed out, request dropped: " + job->url);
+            apiQueueStats.expired++;
+        }
+        else if (job->deadline != 0 && (long)(millis() - job->deadline) >= 0) expireApiJob(*job);
+        else if (runApiJob(*job)) apiQueueStats.completed++;
+        else apiQueueStats.failed++;
+        delete job;
+
+        HEAP_DEBUG_MESSAGE("apiJob end");
+        apiRunningPriority = API_PRIORITY_COUNT;
+        apiJobRunning = false;
+        apiUpdateIdleState();
+    }
+}
+
+static bool ensureApiWorker() {
+    if (apiPendingMutex == NULL) {
+        apiPendingMutex = xSemaphoreCreateMutex();
+        if (apiPendingMutex == NULL) return false;
+    }
+    if (apiWorkerTask == NULL) {
+        BaseType_t result = xTaskCreatePinnedToCore(
+            apiWorker,
+            "SpoolmanApi",
+            8192,
+            NULL,
+            apiTaskPrio,
+            &apiWorkerTask,
+            apiTaskCore);
+        if (result != pdPASS) {
+            Serial.println("Fehler beim Erstellen des API Tasks");
+            apiWorkerTask = NULL;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Hand a job to the API worker, takes ownership of job. Returns false if the queue is full.
+// With a coalesceKey a still queued job with the same key is updated in place.
+static bool submitApiJob(ApiJob* job) {
+    if (!ensureApiWorker()) {
+        delete job;
+        return false;
+    }
+
+    // Straight to the offline log while Spoolman is known to be down
+    if ((!spoolmanConnected || upstreamIsOpen(UPSTREAM_SPOOLMAN)) &&
+        job->walKey.length() == 0 && isOfflineCapable(job->requestType) &&
+        logOfflineUpdate(job->requestType, job->httpType, job->url, job->payload, job->coalesceKey)) {
+        delete job;
+        return true;
+    }
+
+    job->priority = apiPriorityOf(*job);
+    job->queuedAt = millis();
+    job->deadline = (job->walKey.length() > 0) ? 0 : job->queuedAt + apiDeadlineMs[job->priority];
+
+    // Replayed entries are never merged, neither with each other nor with live updates.
+    // A live update replaces queued replays with its key instead, they hold older data.
+    bool coalescable = job->coalesceKey.length() > 0 && job->walKey.length() == 0;
+    bool replayed = job->coalesceKey.length() > 0 && job->walKey.length() > 0;
+    std::vector<ApiJob*> superseded;
+
+    xSemaphoreTake(apiPendingMutex, portMAX_DELAY);
+    if (replayed && findQueuedKeyed(job->coalesceKey) != nullptr) {
+        xSemaphoreGive(apiPendingMutex);
+        dropSupersededReplay(job);
+        return true;
+    }
+    if (coalescable) takeQueuedReplays(job->coalesceKey, superseded);
+    ApiJob* pending = coalescable ? findQueuedKeyed(job->coalesceKey) : nullptr;
+    if (pending != nullptr) {
+        // Keeps its place in the queue, but the newer data and deadline
+        pending->url = job->url;
+        pending->payload = job->payload;
+        pending->octoToken = job->octoToken;
+        pending->etag = job->etag;
+        pending->onComplete = job->onComplete;
+        pending->deadline = job->deadline;
+        apiQueueStats.coalesced++;
+        xSemaphoreGive(apiPendingMutex);
+        Serial.printf("API: %s superseded queued request (%u coalesced)\n",
+                      job->coalesceKey.c_str(), apiQueueStats.coalesced);
+        for (ApiJob* replay : superseded) dropSupersededReplay(replay);
+        delete job;
+        return true;
+    }
+
+    // The last slots are kept free for interactive jobs
+    size_t limit = (job->priority == API_PRIORITY_INTERACTIVE) ? API_JOB_QUEUE_LENGTH
+                                                               : API_JOB_QUEUE_LENGTH - API_JOB_INTERACTIVE_RESERVE;
+    bool sent = apiQueuedJobCount() < limit;
+    if (sent) {
+        spoolmanApiState = API_TRANSMITTING;
+        if (job->chained) apiJobQueues[job->priority].push_front(job);
+        else apiJobQueues[job->priority].push_back(job);
+    }
+    xSemaphoreGive(apiPendingMutex);
+    // Each removed replay freed a slot, so the live update is always queued here
+    for (ApiJob* replay : superseded) dropSupersededReplay(replay);
+
+    if (!sent) {
+        apiQueueStats.rejected++;
+        Serial.println("API queue full, request dropped: " + job->url);
+        delete job;
+        apiUpdateIdleState();
+        return false;
+    }
+    apiQueueStats.queued++;
+    xTaskNotifyGive(apiWorkerTask);
+    return true;
+}
+
+static bool enqueueApiJob(SpoolmanApiRequestType requestType, const char* httpType, const String& url,
+                          const String& payload, ApiJobCallback onComplete = nullptr, const String& token = "",
+                          const String& coalesceKey = "", const String& walKey = "") {
+    ApiJob* job = new ApiJob();
+    if (job == nullptr) {
+        Serial.println("Fehler: Kann Speicher für API Job nicht allokieren.");
+        return false;
+    }
+    job->requestType = requestType;
+    job->httpType = httpType;
+    job->url = url;
+    job->payload = payload;
+    job->octoToken = token;
+    job->coalesceKey = coalesceKey;
+    job->walKey = walKey;
+    job->onComplete = onComplete;
+    return submitApiJob(job);
+}
+
+// Queue all pending offline log entries, called once Spoolman is reachable again
+static void replayOfflineLog() {
+    if (offlineReplayOutstanding > 0) return;
+
+    std::vector<OfflineUpdate> updates;
+    if (offlineLogLoadPending(updates) == 0) return;
+
+    Serial.printf("Replaying %u offline Spoolman updates\n", (unsigned)updates.size());
+    String base = spoolmanBaseUrl() + apiUrl;
+    for (const OfflineUpdate& update : updates) {
+        String key = update.key;
+        offlineReplayOutstanding++;
+        bool queued = enqueueApiJob((SpoolmanApiRequestType)update.requestType, update.method.c_str(),
+            base + update.path, update.payload,
+            [key](bool success, int httpCode, JsonDocument& response) {
+                // A client error will not get better by repeating it
+                if (success || (httpCode >= 400 && httpCode < 500)) {
+                    offlineLogAck(key);
+                }
+                if (offlineReplayOutstanding > 0) offlineReplayOutstanding--;
+            }, "", update.coalesceKey, key);
+        if (!queued) {
+            offlineReplayOutstanding--;
+            break;
+        }
+    }
+}
+
+String getApiQueueStatsJson() {
+    JsonDocument doc;
+    if (apiPendingMutex != NULL) {
+        xSemaphoreTake(apiPendingMutex, portMAX_DELAY);
+        doc["pending"] = apiQueuedJobCount();
+        doc["pendingInteractive"] = apiJobQueues[API_PRIORITY_INTERACTIVE].size();
+        doc["pendingNormal"] = apiJobQueues[API_PRIORITY_NORMAL].size();
+        doc["pendingBackground"] = apiJobQueues[API_PRIORITY_BACKGROUND].size();
+        xSemaphoreGive(apiPendingMutex);
+    }
+    doc["queued"] = apiQueueStats.queued;
+    doc["coalesced"] = apiQueueStats.coalesced;
+    doc["rejected"] = apiQueueStats.rejected;
+    doc["completed"] = apiQueueStats.completed;
+    doc["failed"] = apiQueueStats.failed;
+    doc["expired"] = apiQueueStats.expired;
+    doc["aged"] = apiQueueStats.aged;
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
+
+// #### Spool cache
+// Conditional GET of one spool on the worker, result goes into the spool cache
+static bool requestSpoolRefresh(uint16_t spoolId, const String& etag) {
+    ApiJob* job = new ApiJob();
+    if (job == nullptr) return false;
+    job->requestType = API_REQUEST_SPOOL_FETCH;
+    job->httpType = "GET";
+    job->url = spoolmanBaseUrl() + apiUrl + "/spool/" + String(spoolId);
+    job->etag = etag;
+    job->coalesceKey = "fetch:" + String(spoolId);
+    job->onComplete = [spoolId](bool success, int httpCode, JsonDocument& response) {
+        if (!success) return;
+        if (httpCode == HTTP_CODE_NOT_MODIFIED) spoolCacheConfirm(spoolId);
+        else spoolCacheStore(response.as<JsonObjectConst>(), apiResponseEtag);
+    };
+    return submitApiJob(job);
+}
+
+bool prefetchSpoolInfo(int spoolId) {
+    if (!spoolmanConnected || spoolId <= 0) return false;
+
+    CachedSpool cached;
+    if (spoolCacheGet(spoolId, cached)) {
+        return spoolCacheIsStale(cached) ? requestSpoolRefresh(spoolId, cached.etag) : true;
+    }
+    return requestSpoolRefresh(spoolId, "");
+}
+
+void refreshSpoolCache() {
+    // Background class anyway, but no need to queue it while the operator waits
+    if (!spoolmanConnected || apiForegroundBusy()) return;
+
+    uint16_t staleIds[4];
+    size_t count = spoolCacheStaleIds(staleIds, sizeof(staleIds) / sizeof(staleIds[0]));
+    for (size_t i = 0; i < count; i++) {
+        CachedSpool cached;
+        if (spoolCacheGet(staleIds[i], cached)) requestSpoolRefresh(cached.id, cached.etag);
+    }
+}
+
+JsonDocument fetchSingleSpoolInfo(int spoolId) {
+    JsonDocument filteredDoc;
+
+    // Hot path: served from memory, a stale entry is refreshed in the background
+    CachedSpool cached;
+    if (spoolCacheGet(spoolId, cached)) {
+        if (spoolCacheIsStale(cached)) requestSpoolRefresh(spoolId, cached.etag);
+        spoolCacheToFilteredJson(cached, filteredDoc);
+        return filteredDoc;
+    }
+
+    if (!upstreamAllow(UPSTREAM_SPOOLMAN)) return filteredDoc;
+
+    uint16_t timeoutMs = upstreamTimeoutMs(UPSTREAM_SPOOLMAN);
+    HTTPClient http;
+    http.setConnectTimeout(timeoutMs);
+    http.setTimeout(timeoutMs);
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/spool/" + spoolId;
+
+    Serial.print("Rufe Spool-Daten von: ");
+    Serial.println(spoolsUrl);
+
+    WiFiClient* lease = nullptr;
+    if (!httpPoolBegin(http, spoolsUrl, lease)) {
+        return filteredDoc;
+    }
+    const char* collectedHeaders[] = { "ETag" };
+    http.collectHeaders(collectedHeaders, 1);
+    unsigned long requestStart = millis();
+    int httpCode = http.GET();
+    uint32_t elapsed = millis() - requestStart;
+    upstreamRecord(UPSTREAM_SPOOLMAN, httpCode > 0 && httpCode < 500, elapsed);
+    spoolmanEndpointRecord(spoolsUrl, httpCode > 0 && httpCode < 500, elapsed);
+    bool keepConnection = false;
+
+    if (httpCode == HTTP_CODE_OK) {
+        JsonDocument filter;
+        buildSpoolFilter(filter.to<JsonVariant>());
         JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, responsePayload);
+        DeserializationError error = deserializeResponse(http, doc, filter);
         if (error) {
             Serial.print("Fehler beim Parsen der JSON-Antwort: ");
             Serial.println(error.c_str());
         } else {
-            switch(requestType){
-            case API_REQUEST_VENDOR_CREATE:
-                Serial.println("Vendor successfully created!");
-                createdVendorId = doc["id"].as<uint16_t>();
-                Serial.print("Created Vendor ID: ");
-                Serial.println(createdVendorId);
-                oledShowProgressBar(1, 1, "Vendor", "Created!");
-                break;
-            case API_REQUEST_FILAMENT_CREATE:
-                Serial.println("Filament successfully created!");
-                createdFilamentId = doc["id"].as<uint16_t>();
-                Serial.print("Created Filament ID: ");
-                Serial.println(createdFilamentId);
-                oledShowProgressBar(1, 1, "Filament", "Created!");
-                break;
-            case API_REQUEST_SPOOL_CREATE:
-                Serial.println("Spool successfully created!");
-                createdSpoolId = doc["id"].as<uint16_t>();
-                Serial.print("Created Spool ID: ");
-                Serial.println(createdSpoolId);
-                oledShowProgressBar(1, 1, "Spool", "Created!");
-                break;
-            default:
-                // Handle other create operations if needed
-                break;
-            }
-        }
-        doc.clear();
-
-        // Execute weight update if requested and tag update was successful
-        if (triggerWeightUpdate && requestType == API_REQUEST_SPOOL_TAG_ID_UPDATE && weightValue > 10) {
-            Serial.println("Executing weight update after successful tag update");
-            
-            // Prepare weight update request
-            String weightUrl = spoolmanUrl + apiUrl + "/spool/" + spoolIdForWeight + "/measure";
-            JsonDocument weightDoc;
-            weightDoc["weight"] = weightValue;
-            
-            String weightPayload;
-            serializeJson(weightDoc, weightPayload);
-            
-            Serial.print("Weight update URL: ");
-            Serial.println(weightUrl);
-            Serial.print("Weight update payload: ");
-            Serial.println(weightPayload);
-
-            // Execute weight update
-            HTTPClient weightHttp;
-            weightHttp.setReuse(false);
-            weightHttp.setTimeout(HTTP_TIMEOUT_MS);
-            weightHttp.begin(weightUrl);
-            weightHttp.addHeader("Content-Type", "application/json");
-            
-            int weightHttpCode = weightHttp.PUT(weightPayload);
-            
-            if (weightHttpCode == HTTP_CODE_OK) {
-                Serial.println("Weight update successful");
-                String weightResponse = weightHttp.getString();
-                JsonDocument weightResponseDoc;
-                DeserializationError weightError = deserializeJson(weightResponseDoc, weightResponse);
-                
-                if (!weightError) {
-                    remainingWeight = weightResponseDoc["remaining_weight"].as<uint16_t>();
-                    Serial.print("Updated weight: ");
-                    Serial.println(remainingWeight);
-                    
-                    if (!octoEnabled) {
-                        oledShowProgressBar(1, 1, "Spool Tag", ("Done: " + String(remainingWeight) + " g remain").c_str());
-                        remainingWeight = 0;
-                    } else {
-                        sendOctoUpdate = true;
-                    }
-                }
-                weightResponseDoc.clear();
-            } else {
-                Serial.print("Weight update failed with HTTP code: ");
-                Serial.println(weightHttpCode);
-                oledShowProgressBar(1, 1, "Failure!", "Weight update");
+            keepConnection = true;
+            spoolCacheStore(doc.as<JsonObjectConst>(), http.header("ETag"));
+            doc.clear();
+            if (spoolCacheGet(spoolId, cached)) {
+                spoolCacheToFilteredJson(cached, filteredDoc);
             }
-            
-            weightHttp.end();
-            weightDoc.clear();
         }
     } else {
-        switch(requestType){
-        case API_REQUEST_SPOOL_WEIGHT_UPDATE:
-        case API_REQUEST_SPOOL_LOCATION_UPDATE:
-        case API_REQUEST_SPOOL_TAG_ID_UPDATE:
-            oledShowProgressBar(1, 1, "Failure!", "Spoolman update");
-            break;
-        case API_REQUEST_OCTO_SPOOL_UPDATE:
-            oledShowProgressBar(1, 1, "Failure!", "Octoprint update");
-            break;
-        case API_REQUEST_BAMBU_UPDATE:
-            oledShowProgressBar(1, 1, "Failure!", "Bambu update");
-            break;
-        case API_REQUEST_VENDOR_CHECK:
-            oledShowProgressBar(1, 1, "Failure!", "Vendor check");
-            foundVendorId = 0; // Set to 0 to indicate error/not found
-            break;
-        case API_REQUEST_VENDOR_CREATE:
-            oledShowProgressBar(1, 1, "Failure!", "Vendor create");
-            createdVendorId = 0; // Set to 0 to indicate error
-            break;
-        case API_REQUEST_FILAMENT_CHECK:
-            oledShowProgressBar(1, 1, "Failure!", "Filament check");
-            foundFilamentId = 0; // Set to 0 to indicate error/not found
-            break;
-        case API_REQUEST_FILAMENT_CREATE:
-            oledShowProgressBar(1, 1, "Failure!", "Filament create");
-            createdFilamentId = 0; // Set to 0 to indicate error
-            break;
-        case API_REQUEST_SPOOL_CREATE:
-            oledShowProgressBar(1, 1, "Failure!", "Spool create");
-            createdSpoolId = 0; // Set to 0 to indicate error instead of hanging
-            break;
-        }
-        Serial.println("Fehler beim Senden an Spoolman! HTTP Code: " + String(httpCode));
-        vTaskDelay(2000 / portTICK_PERIOD_MS);
-        nfcReaderState = NFC_IDLE; // Reset NFC state to allow retry
+        Serial.print("Fehler beim Abrufen der Spool-Daten. HTTP-Code: ");
+        Serial.println(httpCode);
     }
 
-    vTaskDelay(50 / portTICK_PERIOD_MS);
+    httpPoolEnd(http, lease, keepConnection);
+    return filteredDoc;
+}
+
+// #### Vendor / filament lookup cache warm-up
+// Vendors and filaments are read page by page so the filtered documents stay small
+static bool brandCacheWarmed = false;
+
+static void warmBrandCachePage(SpoolmanApiRequestType requestType, uint16_t offset) {
+    String path = (requestType == API_REQUEST_VENDOR_LIST) ? "/vendor" : "/filament";
+    String url = spoolmanBaseUrl() + apiUrl + path + "?limit=" + String(BRAND_CACHE_PAGE_SIZE) + "&offset=" + String(offset);
+
+    enqueueApiJob(requestType, "GET", url, "",
+        [requestType, offset](bool success, int httpCode, JsonDocument& response) {
+            if (!success) {
+                brandCacheWarmed = false;   // try again after the next health check
+                return;
+            }
+            JsonArrayConst items = response.as<JsonArrayConst>();
+            for (JsonObjectConst item : items) {
+                if (requestType == API_REQUEST_VENDOR_LIST) {
+                    brandCacheStoreVendor(item["name"].as<String>(), item["id"].as<uint16_t>(), false);
+                } else {
+                    brandCacheStoreFilament(item["vendor"]["id"].as<uint16_t>(), item["external_id"] | "", item["id"].as<uint16_t>(), false);
+                }
+            }
+            brandCacheSave();
 
-    // Speicher freigeben
-    delete params;
-    HEAP_DEBUG_MESSAGE("sendToApi end");
-    spoolmanApiState = API_IDLE;
-    vTaskDelete(NULL);
+            if (items.size() >= BRAND_CACHE_PAGE_SIZE) {
+                warmBrandCachePage(requestType, offset + items.size());
+            } else if (requestType == API_REQUEST_VENDOR_LIST) {
+                warmBrandCachePage(API_REQUEST_FILAMENT_LIST, 0);
+            } else {
+                Serial.println("Brand cache warmed: " + getBrandCacheStatsJson());
+            }
+        });
 }
 
-bool updateSpoolTagId(String uidString, const char* payload) {
-    oledShowProgressBar(2, 3, "Write Tag", "Update Spoolman");
+static void warmBrandCache() {
+    if (brandCacheWarmed) return;
+    brandCacheWarmed = true;
+    warmBrandCachePage(API_REQUEST_VENDOR_LIST, 0);
+}
 
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload);
-    
-    if (error) {
-        Serial.print("Fehler beim JSON-Parsing: ");
-        Serial.println(error.c_str());
+// #### OctoPrint
+// The weighed spool is selected in the Spoolman plugin for the configured tool
+// (octoTool, default "tool0"), chained on the worker right behind the weight update.
+// Only one tool: the plugin would otherwise show the same spool loaded in several
+// extruders and drop the spools really loaded there.
+static bool queueOctoSelection(int spoolId, bool chained) {
+    String tool = octoTool;
+    tool.trim();
+    if (tool == "") tool = OCTOPRINT_DEFAULT_TOOL;
+    oledShowProgressBar(4, 5, "Spool Tag", "Octoprint update");
+
+    String spoolsUrl = octoUrl + "/plugin/Spoolman/selectSpool";
+    Serial.print("Update Spule in Octoprint mit URL: ");
+    Serial.println(spoolsUrl);
+
+    JsonDocument updateDoc;
+    updateDoc["spool_id"] = spoolId;
+    updateDoc["tool"] = tool;
+
+    String updatePayload;
+    serializeJson(updateDoc, updatePayload);
+    Serial.print("Update Payload: ");
+    Serial.println(updatePayload);
+
+    ApiJob* job = new ApiJob();
+    if (job == nullptr) return false;
+    job->requestType = API_REQUEST_OCTO_SPOOL_UPDATE;
+    job->httpType = "POST";
+    job->url = spoolsUrl;
+    job->payload = updatePayload;
+    job->octoToken = octoToken;
+    job->coalesceKey = "octo:" + tool;
+    job->chained = chained;
+    job->onComplete = [](bool success, int httpCode, JsonDocument& response) {
+        // A failure has been shown by handleApiFailure already, the remaining
+        // weight belongs to a selection that did not happen
+        if (success) oledShowMessage("Remaining: " + String(remainingWeight) + "g");
+        remainingWeight = 0;
+    };
+    if (!submitApiJob(job)) {
+        oledShowProgressBar(1, 1, "Failure!", "Octoprint update");
+        remainingWeight = 0;
         return false;
     }
-    
-    // Überprüfe, ob die erforderlichen Felder vorhanden sind
-    if (!doc["sm_id"].is<String>() || doc["sm_id"].as<String>() == "") {
+    return true;
+}
+
+bool updateSpoolTagId(String uidString, const String& spoolId) {
+    oledShowProgressBar(2, 3, "Write Tag", "Update Spoolman");
+
+    // Überprüfe, ob eine Spoolman-ID vorhanden ist
+    if (spoolId == "" || spoolId == "0") {
         Serial.println("Keine Spoolman-ID gefunden.");
         return false;
     }
 
-    String spoolId = doc["sm_id"].as<String>();
-    String spoolsUrl = spoolmanUrl + apiUrl + "/spool/" + spoolId;
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/spool/" + spoolId;
     Serial.print("Update Spule mit URL: ");
     Serial.println(spoolsUrl);
-    
-    doc.clear();
 
     // Generate tag ID: UID hex + random 8 alphanumeric chars
     String tagId = generateTagId(uidString);
@@ -469,43 +1067,42 @@ bool updateSpoolTagId(String uidString, const char* payload) {
     Serial.print("Update Payload: ");
     Serial.println(updatePayload);
 
-    SendToApiParams* params = new SendToApiParams();  
-    if (params == nullptr) {
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        return false;
-    }
-    params->requestType = API_REQUEST_SPOOL_TAG_ID_UPDATE;
-    params->httpType = "PATCH";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = updatePayload;
-    
-    // Add weight update parameters for sequential execution
-    params->triggerWeightUpdate = (weight > 10);
-    params->spoolIdForWeight = spoolId;
-    params->weightValue = weight;
-
-    // Erstelle die Task mit erhöhter Stackgröße für zusätzliche HTTP-Anfrage
-    BaseType_t result = xTaskCreate(
-        sendToApi,                // Task-Funktion
-        "SendToApiTask",          // Task-Name
-        8192,                     // Erhöhte Stackgröße für zusätzliche HTTP-Anfrage
-        (void*)params,            // Parameter
-        0,                        // Priorität
-        apiTask                   // Task-Handle (nicht benötigt)
-    );
+    // Weight update is queued once the tag update went through
+    uint16_t weightValue = weight;
+    bool queued = enqueueApiJob(API_REQUEST_SPOOL_TAG_ID_UPDATE, "PATCH", spoolsUrl, updatePayload,
+        [spoolId, weightValue](bool success, int httpCode, JsonDocument& response) {
+            if (success && weightValue > 10) {
+                Serial.println("Executing weight update after successful tag update");
+                updateSpoolWeight(spoolId, weightValue);
+            }
+        });
 
     updateDoc.clear();
 
-    // Update Spool weight now handled sequentially in sendToApi task
-    // to prevent parallel API access issues
-
-    return true;
+    return queued;
 }
 
 uint8_t updateSpoolWeight(String spoolId, uint16_t weight) {
     HEAP_DEBUG_MESSAGE("updateSpoolWeight begin");
+
+    // Nothing to send if the spool still weighs what Spoolman already has
+    CachedSpool cached;
+    if (spoolCacheGet(spoolId.toInt(), cached) && !spoolCacheIsStale(cached) &&
+        fabsf((float)weight - (cached.remainingWeight + cached.spoolWeight)) <= SPOOL_WEIGHT_TOLERANCE_G) {
+        Serial.printf("Weight %u g within tolerance of cached spool %s, skipping update\n", weight, spoolId.c_str());
+        spoolCacheNoteWeightSkipped();
+        remainingWeight = (uint16_t)(cached.remainingWeight + 0.5f);
+        if (!octoEnabled) {
+            oledShowMessage("Remaining: " + String(remainingWeight) + "g");
+            remainingWeight = 0;
+        } else {
+            updateSpoolOcto(spoolId.toInt());
+        }
+        return 1;
+    }
+
     oledShowProgressBar(3, octoEnabled?5:4, "Spool Tag", "Spoolman update");
-    String spoolsUrl = spoolmanUrl + apiUrl + "/spool/" + spoolId + "/measure";
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/spool/" + spoolId + "/measure";
     Serial.print("Update Spule mit URL: ");
     Serial.println(spoolsUrl);
 
@@ -518,31 +1115,17 @@ uint8_t updateSpoolWeight(String spoolId, uint16_t weight) {
     Serial.print("Update Payload: ");
     Serial.println(updatePayload);
 
-    SendToApiParams* params = new SendToApiParams();
-    if (params == nullptr) {
-        // TBD: reset ESP instead of showing a message
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        return 0;
-    }
-    params->requestType = API_REQUEST_SPOOL_WEIGHT_UPDATE;
-    params->httpType = "PUT";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = updatePayload;
-
-    // Erstelle die Task
-    BaseType_t result = xTaskCreate(
-        sendToApi,                // Task-Funktion
-        "SendToApiTask",          // Task-Name
-        6144,                     // Stackgröße in Bytes
-        (void*)params,            // Parameter
-        0,                        // Priorität
-        apiTask                      // Task-Handle (nicht benötigt)
-    );
+    // OctoPrint follows straight after the response, on the same worker
+    int octoSpoolId = spoolId.toInt();
+    bool queued = enqueueApiJob(API_REQUEST_SPOOL_WEIGHT_UPDATE, "PUT", spoolsUrl, updatePayload,
+        [octoSpoolId](bool success, int httpCode, JsonDocument& response) {
+            if (success && octoEnabled) queueOctoSelection(octoSpoolId, true);
+        }, "", "weight:" + spoolId);
 
     updateDoc.clear();
     HEAP_DEBUG_MESSAGE("updateSpoolWeight end");
 
-    return 1;
+    return queued ? 1 : 0;
 }
 
 uint8_t updateSpoolLocation(String spoolId, String location){
@@ -550,7 +1133,7 @@ uint8_t updateSpoolLocation(String spoolId, String location){
 
     oledShowProgressBar(3, octoEnabled?5:4, "Loc. Tag", "Spoolman update");
 
-    String spoolsUrl = spoolmanUrl + apiUrl + "/spool/" + spoolId;
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/spool/" + spoolId;
     Serial.print("Update Spule mit URL: ");
     Serial.println(spoolsUrl);
 
@@ -563,77 +1146,17 @@ uint8_t updateSpoolLocation(String spoolId, String location){
     Serial.print("Update Payload: ");
     Serial.println(updatePayload);
 
-    SendToApiParams* params = new SendToApiParams();
-    if (params == nullptr) {
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        return 0;
-    }
-    params->requestType = API_REQUEST_SPOOL_LOCATION_UPDATE;
-    params->httpType = "PATCH";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = updatePayload;
-
-
-    if(apiTask == nullptr){
-        // Erstelle die Task
-        BaseType_t result = xTaskCreate(
-            sendToApi,                // Task-Funktion
-            "SendToApiTask",          // Task-Name
-            6144,                     // Stackgröße in Bytes
-            (void*)params,            // Parameter
-            0,                        // Priorität
-            apiTask                   // Task-Handle
-        );
-    }else{
-        Serial.println("Not spawning new task, API still active!");
-    }
+    bool queued = enqueueApiJob(API_REQUEST_SPOOL_LOCATION_UPDATE, "PATCH", spoolsUrl, updatePayload,
+                                nullptr, "", "location:" + spoolId);
 
     updateDoc.clear();
 
     HEAP_DEBUG_MESSAGE("updateSpoolLocation end");
-    return 1;
+    return queued ? 1 : 0;
 }
 
 bool updateSpoolOcto(int spoolId) {
-    oledShowProgressBar(4, octoEnabled?5:4, "Spool Tag", "Octoprint update");
-
-    String spoolsUrl = octoUrl + "/plugin/Spoolman/selectSpool";
-    Serial.print("Update Spule in Octoprint mit URL: ");
-    Serial.println(spoolsUrl);
-
-    JsonDocument updateDoc;
-    updateDoc["spool_id"] = spoolId;
-    updateDoc["tool"] = "tool0";
-
-    String updatePayload;
-    serializeJson(updateDoc, updatePayload);
-    Serial.print("Update Payload: ");
-    Serial.println(updatePayload);
-
-    SendToApiParams* params = new SendToApiParams();
-    if (params == nullptr) {
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        return false;
-    }
-    params->requestType = API_REQUEST_OCTO_SPOOL_UPDATE;
-    params->httpType = "POST";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = updatePayload;
-    params->octoToken = octoToken;
-
-    // Erstelle die Task
-    BaseType_t result = xTaskCreate(
-        sendToApi,                // Task-Funktion
-        "SendToApiTask",          // Task-Name
-        6144,                     // Stackgröße in Bytes
-        (void*)params,            // Parameter
-        0,                        // Priorität
-        apiTask                      // Task-Handle (nicht benötigt)
-    );
-
-    updateDoc.clear();
-
-    return true;
+    return queueOctoSelection(spoolId, false);
 }
 
 bool updateSpoolBambuData(String payload) {
@@ -645,7 +1168,7 @@ bool updateSpoolBambuData(String payload) {
         return false;
     }
 
-    String spoolsUrl = spoolmanUrl + apiUrl + "/filament/" + doc["filament_id"].as<String>();
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/filament/" + doc["filament_id"].as<String>();
     Serial.print("Update Spule mit URL: ");
     Serial.println(spoolsUrl);
 
@@ -659,26 +1182,53 @@ bool updateSpoolBambuData(String payload) {
 }
 
 // #### Brand Filament
-uint16_t createVendor(const JsonDocument& payload) {
+// Onboarding runs as a chain of futures on the API worker:
+//   check/create vendor -> check/create filament -> create spool -> queue tag write
+// Nothing waits for a response, so the reader keeps scanning in the meantime.
+static volatile bool brandOnboardingActive = false;
+
+// Queue a request whose response carries an id (object or first array element).
+// Resolves with the id, 0 if the request failed, found nothing or timed out.
+static ApiFuture::Ptr requestId(SpoolmanApiRequestType requestType, const String& httpType,
+                                const String& url, const String& payload) {
+    ApiFuture::Ptr future = ApiFuture::create(API_STEP_TIMEOUT_MS);
+    ApiJob* job = new ApiJob();
+    if (job == nullptr) {
+        future->resolve(0);
+        return future;
+    }
+    job->requestType = requestType;
+    job->httpType = httpType;
+    job->url = url;
+    job->payload = payload;
+    job->step = future;
+    // The future only lets go of the job by timing out, a late answer is then ignored
+    job->onComplete = [future](bool success, int httpCode, JsonDocument& response) {
+        uint16_t id = 0;
+        if (success) {
+            id = response.is<JsonArray>() ? (response[0]["id"] | 0) : (response["id"] | 0);
+        }
+        future->resolve(id);
+    };
+    if (!submitApiJob(job)) future->resolve(0);
+    return future;
+}
+
+static ApiFuture::Ptr createVendorAsync(const SpoolTagRecord& payload) {
     oledShowProgressBar(2, 5, "New Brand", "Create new Vendor");
 
-    // Create new vendor in Spoolman database using task system
-    // Note: Due to async nature, the ID will be stored in createdVendorId global variable
-    // Note: This function assumes that the caller has already ensured API is IDLE
-    createdVendorId = 65535; // Reset previous value
-    
-    String spoolsUrl = spoolmanUrl + apiUrl + "/vendor";
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/vendor";
     Serial.print("Create vendor with URL: ");
     Serial.println(spoolsUrl);
 
     // Create JSON payload for vendor creation
     JsonDocument vendorDoc;
-    vendorDoc["name"] = payload["b"].as<String>();
+    vendorDoc["name"] = payload.b;
     
     // Extract domain from URL if present, otherwise use brand name
     String externalId = "";
-    if (payload["u"].is<String>()) {
-        String url = payload["u"].as<String>();
+    if (payload.u.length() > 0) {
+        const String& url = payload.u;
         // Extract domain from URL (e.g., "https://www.blubb.de/f1234/?suche=irgendwas" -> "https://www.blubb.de")
         int protocolEnd = url.indexOf("://");
         if (protocolEnd != -1) {
@@ -688,7 +1238,7 @@ uint16_t createVendor(const JsonDocument& payload) {
             externalId = url; // No protocol found, use as is
         }
     } else {
-        externalId = payload["b"].as<String>();
+        externalId = payload.b;
     }
     vendorDoc["comment"] = externalId;
 
@@ -696,267 +1246,112 @@ uint16_t createVendor(const JsonDocument& payload) {
     serializeJson(vendorDoc, vendorPayload);
     Serial.print("Vendor Payload: ");
     Serial.println(vendorPayload);
-
-    SendToApiParams* params = new SendToApiParams();
-    if (params == nullptr) {
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        vendorDoc.clear();
-        return 0;
-    }
-    params->requestType = API_REQUEST_VENDOR_CREATE;
-    params->httpType = "POST";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = vendorPayload;
-
-    // Create task without additional API state check since caller ensures synchronization
-    BaseType_t result = xTaskCreate(
-        sendToApi,                // Task-Funktion
-        "SendToApiTask",          // Task-Name
-        6144,                     // Stackgröße in Bytes
-        (void*)params,            // Parameter
-        0,                        // Priorität
-        NULL                      // Task-Handle (nicht benötigt)
-    );
-
-    if (result != pdPASS) {
-        Serial.println("Failed to create vendor task!");
-        delete params;
-        vendorDoc.clear();
-        return 0;
-    }
-
     vendorDoc.clear();
-    
-    // Delay for Display Bar
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
 
-    // Wait for task completion and return the created vendor ID
-    // Note: createdVendorId will be set by sendToApi when response is received
-    while(createdVendorId == 65535) {
-        vTaskDelay(50 / portTICK_PERIOD_MS);
-    }
-    
-    return createdVendorId;
+    return requestId(API_REQUEST_VENDOR_CREATE, "POST", spoolsUrl, vendorPayload);
 }
 
-uint16_t checkVendor(const JsonDocument& payload) {
+static ApiFuture::Ptr checkVendorAsync(const SpoolTagRecord& payload) {
     oledShowProgressBar(1, 5, "New Brand", "Check Vendor");
 
-    // Check if vendor exists using task system
-    foundVendorId = 65535; // Reset to invalid value to detect when API response is received
-    
-    String vendorName = payload["b"].as<String>();
+    uint16_t cachedVendorId = brandCacheVendorId(payload.b);
+    if (cachedVendorId > 0) {
+        Serial.println("Vendor from cache: " + payload.b + " -> " + String(cachedVendorId));
+        return ApiFuture::resolved(cachedVendorId);
+    }
+
+    String vendorName = payload.b;
     vendorName.trim();
     vendorName.replace(" ", "+");
-    String spoolsUrl = spoolmanUrl + apiUrl + "/vendor?name=" + vendorName;
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/vendor?name=" + vendorName;
     Serial.print("Check vendor with URL: ");
     Serial.println(spoolsUrl);
 
-    SendToApiParams* params = new SendToApiParams();
-    if (params == nullptr) {
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        return 0;
-    }
-    params->requestType = API_REQUEST_VENDOR_CHECK;
-    params->httpType = "GET";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = ""; // Empty for GET request
-
-    // Check if API is idle before creating task
-    while (spoolmanApiState != API_IDLE)
-    {
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-    }
-    
-    // Erstelle die Task
-    BaseType_t result = xTaskCreate(
-        sendToApi,                // Task-Funktion
-        "SendToApiTask",          // Task-Name
-        6144,                     // Stackgröße in Bytes
-        (void*)params,            // Parameter
-        0,                        // Priorität
-        NULL                      // Task-Handle (nicht benötigt)
-    );
-    
-    // Wait until foundVendorId is updated by the API response (not 65535 anymore)
-    while (foundVendorId == 65535)
-    {
-        vTaskDelay(50 / portTICK_PERIOD_MS);
-    }
-
-    // Check if vendor was found
-    if (foundVendorId == 0) {
-        Serial.println("Vendor not found, creating new vendor...");
-        uint16_t vendorId = createVendor(payload);
-        if (vendorId == 0) {
-            Serial.println("Failed to create vendor, returning 0.");
-            return 0; // Failed to create vendor
-        } else {
-            Serial.println("Vendor created with ID: " + String(vendorId));
-            return vendorId;
-        }
-    } else {
-        Serial.println("Vendor found: " + payload["b"].as<String>());
-        Serial.print("Vendor ID: ");
-        Serial.println(foundVendorId);
-        return foundVendorId;
-    }
+    return requestId(API_REQUEST_VENDOR_CHECK, "GET", spoolsUrl, "")
+        ->orElse([payload]() {
+            Serial.println("Vendor not found, creating new vendor...");
+            return createVendorAsync(payload);
+        });
 }
 
-uint16_t createFilament(uint16_t vendorId, const JsonDocument& payload) {
+static ApiFuture::Ptr createFilamentAsync(uint16_t vendorId, const SpoolTagRecord& payload) {
     oledShowProgressBar(4, 5, "New Brand", "Create Filament");
 
-    // Create new filament in Spoolman database using task system
-    // Note: Due to async nature, the ID will be stored in createdFilamentId global variable
-    // Note: This function assumes that the caller has already ensured API is IDLE
-    createdFilamentId = 65535; // Reset previous value
-    
-    String spoolsUrl = spoolmanUrl + apiUrl + "/filament";
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/filament";
     Serial.print("Create filament with URL: ");
     Serial.println(spoolsUrl);
 
     // Create JSON payload for filament creation
     JsonDocument filamentDoc;
-    filamentDoc["name"] = payload["cn"].as<String>();
+    filamentDoc["name"] = payload.cn;
     filamentDoc["vendor_id"] = String(vendorId);
-    filamentDoc["material"] = payload["t"].as<String>();
-    filamentDoc["density"] = (payload["de"].is<String>() && payload["de"].as<String>().length() > 0) ? payload["de"].as<String>() : "1.24";
-    filamentDoc["diameter"] = (payload["di"].is<String>() && payload["di"].as<String>().length() > 0) ? payload["di"].as<String>() : "1.75";
+    filamentDoc["material"] = payload.t;
+    filamentDoc["density"] = (payload.de.length() > 0) ? payload.de : "1.24";
+    filamentDoc["diameter"] = (payload.di.length() > 0) ? payload.di : "1.75";
     filamentDoc["weight"] = String(weight);
-    filamentDoc["spool_weight"] = payload["sw"].as<String>();
-    filamentDoc["article_number"] = payload["an"].as<String>();
-    filamentDoc["settings_extruder_temp"] = payload["et"].is<String>() ? payload["et"].as<String>() : "";
-    filamentDoc["settings_bed_temp"] = payload["bt"].is<String>() ? payload["bt"].as<String>() : "";
+    filamentDoc["spool_weight"] = payload.sw;
+    filamentDoc["article_number"] = payload.an;
+    filamentDoc["settings_extruder_temp"] = payload.et;
+    filamentDoc["settings_bed_temp"] = payload.bt;
 
-    if (payload["an"].is<String>())
+    if (payload.an.length() > 0)
     {
-        filamentDoc["external_id"] = payload["an"].as<String>();
-        filamentDoc["comment"] = payload["u"].is<String>() ? payload["u"].as<String>() + payload["an"].as<String>() : "automatically generated";
+        filamentDoc["external_id"] = payload.an;
+        filamentDoc["comment"] = (payload.u.length() > 0) ? payload.u + payload.an : "automatically generated";
     }
     else
     {
-        filamentDoc["comment"] = payload["u"].is<String>() ? payload["u"].as<String>() : "automatically generated";
+        filamentDoc["comment"] = (payload.u.length() > 0) ? payload.u : "automatically generated";
     }
 
-    if (payload["mc"].is<String>()) {
-        filamentDoc["multi_color_hexes"] = payload["mc"].as<String>();
-        filamentDoc["multi_color_direction"] = payload["mcd"].is<String>() ? payload["mcd"].as<String>() : "";
+    if (payload.mc.length() > 0) {
+        filamentDoc["multi_color_hexes"] = payload.mc;
+        filamentDoc["multi_color_direction"] = payload.mcd;
     }
     else
     {
-        filamentDoc["color_hex"] = (payload["c"].is<String>() && payload["c"].as<String>().length() >= 6) ? payload["c"].as<String>() : "FFFFFF";
+        filamentDoc["color_hex"] = (payload.c.length() >= 6) ? payload.c : "FFFFFF";
     }
 
     String filamentPayload;
     serializeJson(filamentDoc, filamentPayload);
     Serial.print("Filament Payload: ");
     Serial.println(filamentPayload);
-
-    SendToApiParams* params = new SendToApiParams();
-    if (params == nullptr) {
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        filamentDoc.clear();
-        return 0;
-    }
-    params->requestType = API_REQUEST_FILAMENT_CREATE;
-    params->httpType = "POST";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = filamentPayload;
-
-    // Create task without additional API state check since caller ensures synchronization
-    BaseType_t result = xTaskCreate(
-        sendToApi,                // Task-Funktion
-        "SendToApiTask",          // Task-Name
-        6144,                     // Stackgröße in Bytes
-        (void*)params,            // Parameter
-        0,                        // Priorität
-        NULL                      // Task-Handle (nicht benötigt)
-    );
-
-    if (result != pdPASS) {
-        Serial.println("Failed to create filament task!");
-        delete params;
-        filamentDoc.clear();
-        return 0;
-    }
-
     filamentDoc.clear();
-    
-    // Delay for Display Bar
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
 
-    // Wait for task completion and return the created filament ID
-    // Note: createdFilamentId will be set by sendToApi when response is received
-    while(createdFilamentId == 65535) {
-        vTaskDelay(50 / portTICK_PERIOD_MS);
-    }
-    
-    return createdFilamentId;
+    return requestId(API_REQUEST_FILAMENT_CREATE, "POST", spoolsUrl, filamentPayload);
+}
+
+// createFilament stores the article number as external_id
+static String brandExternalId(const SpoolTagRecord& payload) {
+    return (payload.an.length() > 0) ? payload.an : payload.artnr;
 }
 
-uint16_t checkFilament(uint16_t vendorId, const JsonDocument& payload) {
+static ApiFuture::Ptr checkFilamentAsync(uint16_t vendorId, const SpoolTagRecord& payload) {
     oledShowProgressBar(3, 5, "New Brand", "Check Filament");
 
-    // Check if filament exists using task system
-    foundFilamentId = 65535; // Reset to invalid value to detect when API response is received
+    String externalId = brandExternalId(payload);
+    uint16_t cachedFilamentId = brandCacheFilamentId(vendorId, externalId);
+    if (cachedFilamentId > 0) {
+        Serial.println("Filament from cache: " + externalId + " -> " + String(cachedFilamentId));
+        return ApiFuture::resolved(cachedFilamentId);
+    }
 
-    String spoolsUrl = spoolmanUrl + apiUrl + "/filament?vendor.id=" + String(vendorId) + "&external_id=" + String(payload["artnr"].as<String>());
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/filament?vendor.id=" + String(vendorId) + "&external_id=" + externalId;
     Serial.print("Check filament with URL: ");
     Serial.println(spoolsUrl);
 
-    SendToApiParams* params = new SendToApiParams();
-    if (params == nullptr) {
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        return 0;
-    }
-    params->requestType = API_REQUEST_FILAMENT_CHECK;
-    params->httpType = "GET";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = ""; // Empty for GET request
-
-     // Erstelle die Task
-    BaseType_t result = xTaskCreate(
-        sendToApi,                // Task-Funktion
-        "SendToApiTask",          // Task-Name
-        6144,                     // Stackgröße in Bytes
-        (void*)params,            // Parameter
-        0,                        // Priorität
-        NULL                      // Task-Handle (nicht benötigt)
-    );
-    
-    // Wait until foundFilamentId is updated by the API response (not 65535 anymore)
-    while (foundFilamentId == 65535) {
-        vTaskDelay(50 / portTICK_PERIOD_MS);
-    }
-
-    // Check if filament was found
-    if (foundFilamentId == 0) {
-        Serial.println("Filament not found, creating new filament...");
-        uint16_t filamentId = createFilament(vendorId, payload);
-        if (filamentId == 0) {
-            Serial.println("Failed to create filament, returning 0.");
-            return 0; // Failed to create filament
-        } else {
-            Serial.println("Filament created with ID: " + String(filamentId));
-            return filamentId;
-        }
-    } else {
-        Serial.println("Filament found for vendor ID: " + String(vendorId));
-        Serial.print("Filament ID: ");
-        Serial.println(foundFilamentId);
-        return foundFilamentId;
-    }
+    return requestId(API_REQUEST_FILAMENT_CHECK, "GET", spoolsUrl, "")
+        ->orElse([vendorId, payload]() {
+            Serial.println("Filament not found, creating new filament...");
+            return createFilamentAsync(vendorId, payload);
+        });
 }
 
-uint16_t createSpool(uint16_t vendorId, uint16_t filamentId, JsonDocument& payload, String uidString) {
+static ApiFuture::Ptr createSpoolAsync(uint16_t filamentId, const SpoolTagRecord& payload, const String& uidString) {
     oledShowProgressBar(5, 5, "New Brand", "Create new Spool");
 
-    // Create new spool in Spoolman database using task system
-    // Note: Due to async nature, the ID will be stored in createdSpoolId global variable
-    // Note: This function assumes that the caller has already ensured API is IDLE
-    createdSpoolId = 65535; // Reset to invalid value to detect when API response is received
-    
-    String spoolsUrl = spoolmanUrl + apiUrl + "/spool";
+    String spoolsUrl = spoolmanBaseUrl() + apiUrl + "/spool";
     Serial.print("Create spool with URL: ");
     Serial.println(spoolsUrl);
 
@@ -968,10 +1363,10 @@ uint16_t createSpool(uint16_t vendorId, uint16_t filamentId, JsonDocument& paylo
     // Create JSON payload for spool creation
     JsonDocument spoolDoc;
     spoolDoc["filament_id"] = String(filamentId);
-    spoolDoc["initial_weight"] = weight > 10 ? String(weight - payload["sw"].as<int>()) : "1000";
-    spoolDoc["spool_weight"] = (payload["sw"].is<String>() && payload["sw"].as<String>().length() > 0) ? payload["sw"].as<String>() : "180";
+    spoolDoc["initial_weight"] = weight > 10 ? String(weight - payload.sw.toInt()) : "1000";
+    spoolDoc["spool_weight"] = (payload.sw.length() > 0) ? payload.sw : "180";
     spoolDoc["remaining_weight"] = spoolDoc["initial_weight"];
-    spoolDoc["lot_nr"] = (payload["an"].is<String>() && payload["an"].as<String>().length() > 0) ? payload["an"].as<String>() : "";
+    spoolDoc["lot_nr"] = payload.an;
     spoolDoc["comment"] = "automatically generated";
     spoolDoc["extra"]["tag"] = "\"" + tagId + "\"";
 
@@ -981,94 +1376,189 @@ uint16_t createSpool(uint16_t vendorId, uint16_t filamentId, JsonDocument& paylo
     Serial.println(spoolPayload);
     spoolDoc.clear();
 
-    SendToApiParams* params = new SendToApiParams();
-    if (params == nullptr) {
-        Serial.println("Fehler: Kann Speicher für Task-Parameter nicht allokieren.");
-        spoolDoc.clear();
-        return 0;
-    }
-    params->requestType = API_REQUEST_SPOOL_CREATE;
-    params->httpType = "POST";
-    params->spoolsUrl = spoolsUrl;
-    params->updatePayload = spoolPayload;
-
-    // Create task without additional API state check since caller ensures synchronization
-    BaseType_t result = xTaskCreate(
-        sendToApi,                // Task-Funktion
-        "SendToApiTask",          // Task-Name
-        6144,                     // Stackgröße in Bytes
-        (void*)params,            // Parameter
-        0,                        // Priorität
-        NULL                      // Task-Handle (nicht benötigt)
-    );
-
-    if (result != pdPASS) {
-        Serial.println("Failed to create spool task!");
-        delete params;
-        return 0;
-    }
-    
-    // Wait for task completion and return the created spool ID
-    // Note: createdSpoolId will be set by sendToApi when response is received
-    while(createdSpoolId == 65535) {
-        vTaskDelay(50 / portTICK_PERIOD_MS);
-    }
-    
-    // Check if spool creation was successful
-    if (createdSpoolId == 0) {
-        Serial.println("ERROR: Spool creation failed");
-        nfcReaderState = NFC_IDLE; // Reset NFC state
-        return 0;
-    }
+    ApiFuture::Ptr spool = requestId(API_REQUEST_SPOOL_CREATE, "POST", spoolsUrl, spoolPayload);
+    spool->onResolved([payload, uidString](uint16_t spoolId) {
+        if (spoolId == 0) return;
 
-    // Write data to tag with startWriteJsonToTag
-    // void startWriteJsonToTag(const bool isSpoolTag, const char* payload);
-    
-    // Create optimized JSON structure with sm_id at the beginning for fast-path detection
-    JsonDocument optimizedPayload;
-    optimizedPayload["sm_id"] = String(createdSpoolId);  // Place sm_id first for fast scanning
-    optimizedPayload["b"] = payload["b"].as<String>();
-    optimizedPayload["cn"] = payload["an"].as<String>();
-    
-    String payloadString;
-    serializeJson(optimizedPayload, payloadString);
-    
-    Serial.println("Optimized JSON with sm_id first:");
-    Serial.println(payloadString);
-    
-    optimizedPayload.clear();
-    
-    nfcReaderState = NFC_IDLE;
+        // Create optimized JSON structure with sm_id at the beginning for fast-path detection
+        JsonDocument optimizedPayload;
+        optimizedPayload["sm_id"] = String(spoolId);  // Place sm_id first for fast scanning
+        optimizedPayload["b"] = payload.b;
+        optimizedPayload["cn"] = payload.an;
 
-    // Delay for Display Bar
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
-    
-    startWriteJsonToTag(true, payloadString.c_str());
+        nfcReaderState = NFC_IDLE;
 
-    return createdSpoolId;
+        // Only the tag the spool was created for may receive its sm_id
+        startWriteJsonToTag(true, optimizedPayload.as<JsonObjectConst>(), uidString);
+    });
+    return spool;
 }
 
-bool createBrandFilament(JsonDocument& payload, String uidString) {
-    uint16_t vendorId = checkVendor(payload);
-    if (vendorId == 0) {
-        Serial.println("ERROR: Failed to create/find vendor");
+bool createBrandFilament(const SpoolTagRecord& payload, String uidString) {
+    if (brandOnboardingActive) {
+        Serial.println("Brand filament onboarding already running, tag ignored");
         return false;
     }
-    
-    uint16_t filamentId = checkFilament(vendorId, payload);
-    if (filamentId == 0) {
-        Serial.println("ERROR: Failed to create/find filament");
-        return false;
+    brandOnboardingActive = true;
+
+    // Copies only: the chain outlives the reader's tag record
+    SpoolTagRecord record = payload;
+    std::shared_ptr<uint16_t> vendorId(new uint16_t(0));
+
+    checkVendorAsync(record)
+        ->then([record, vendorId](uint16_t id) {
+            *vendorId = id;
+            return checkFilamentAsync(id, record);
+        })
+        ->then([record, uidString](uint16_t filamentId) {
+            return createSpoolAsync(filamentId, record, uidString);
+        })
+        ->onResolved([record, vendorId](uint16_t spoolId) {
+            if (spoolId == 0) {
+                // The cached ids may point to something deleted in Spoolman meanwhile
+                if (*vendorId > 0) brandCacheForgetFilament(*vendorId, brandExternalId(record));
+                brandCacheForgetVendor(record.b);
+                Serial.println("ERROR: Failed to create brand filament spool");
+                nfcReaderState = NFC_IDLE;
+            } else {
+                Serial.println("SUCCESS: Brand filament created with Spool ID: " + String(spoolId));
+            }
+            brandOnboardingActive = false;
+        });
+
+    return true;
+}
+
+// #### Spoolman extra fields
+// Fields FilaMan needs in Spoolman. A verified schema is remembered in NVS as a
+// fingerprint of URL, Spoolman version and these definitions, so boot and reconnect
+// skip the field check until one of them changes.
+static const char* const spoolExtra[] = {
+    "tag"
+};
+
+static const char* const spoolExtraFields[] = {
+    "{\"name\": \"Tag\","
+    "\"key\": \"tag\","
+    "\"field_type\": \"text\"}"
+};
+
+static const char* const filamentExtra[] = {
+    "nozzle_temperature",
+    "price_meter",
+    "price_gramm"
+};
+
+static const char* const filamentExtraFields[] = {
+    "{\"name\": \"Nozzle Temp\","
+    "\"unit\": \"°C\","
+    "\"field_type\": \"integer_range\","
+    "\"default_value\": \"[190,230]\","
+    "\"key\": \"nozzle_temperature\"}",
+
+    "{\"name\": \"Price/m\","
+    "\"unit\": \"€\","
+    "\"field_type\": \"float\","
+    "\"key\": \"price_meter\"}",
+
+    "{\"name\": \"Price/g\","
+    "\"unit\": \"€\","
+    "\"field_type\": \"float\","
+    "\"key\": \"price_gramm\"}"
+};
+
+// Restored from NVS, the server version has not been confirmed since boot
+static bool spoolmanSchemaVersionVerified = false;
+
+// FNV-1a including the terminating zero, so "ab"+"c" and "a"+"bc" differ
+static uint32_t fnv1a(uint32_t hash, const char* data) {
+    do {
+        hash ^= (uint8_t)*data;
+        hash *= 16777619UL;
+    } while (*data++);
+    return hash;
+}
+
+static String extraFieldsFingerprint(const String& baseUrl, const String& version) {
+    uint32_t hash = 2166136261UL;
+    hash = fnv1a(hash, baseUrl.c_str());
+    hash = fnv1a(hash, version.c_str());
+    for (const char* field : spoolExtraFields) hash = fnv1a(hash, field);
+    for (const char* field : filamentExtraFields) hash = fnv1a(hash, field);
+    char fp[9];
+    snprintf(fp, sizeof(fp), "%08lx", (unsigned long)hash);
+    return String(fp);
+}
+
+static void storeExtraFieldsFingerprint(const String& version, const String& fingerprint) {
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE_API, false);
+    preferences.putString(NVS_KEY_SPOOLMAN_FIELDS_VERSION, version);
+    preferences.putString(NVS_KEY_SPOOLMAN_FIELDS_FP, fingerprint);
+    preferences.end();
+}
+
+static void clearExtraFieldsFingerprint() {
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE_API, false);
+    preferences.remove(NVS_KEY_SPOOLMAN_FIELDS_VERSION);
+    preferences.remove(NVS_KEY_SPOOLMAN_FIELDS_FP);
+    preferences.end();
+}
+
+// Trust a schema verified on an earlier boot for this URL. The version it was
+// verified on is confirmed later by a single background /info request.
+static void restoreExtraFieldsFingerprint(const String& url) {
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE_API, true);
+    String version = preferences.getString(NVS_KEY_SPOOLMAN_FIELDS_VERSION, "");
+    String stored = preferences.getString(NVS_KEY_SPOOLMAN_FIELDS_FP, "");
+    preferences.end();
+
+    spoolmanSchemaVersionVerified = false;
+    spoolmanExtraFieldsChecked = version.length() > 0 && stored == extraFieldsFingerprint(url, version);
+    if (spoolmanExtraFieldsChecked) {
+        Serial.println("Extrafelder aus NVS übernommen (Spoolman " + version + ")");
     }
-    
-    uint16_t spoolId = createSpool(vendorId, filamentId, payload, uidString);
-    if (spoolId == 0) {
-        Serial.println("ERROR: Failed to create spool");
-        return false;
+}
+
+static String fetchSpoolmanVersion(HTTPClient& http) {
+    String version = "";
+    http.begin(spoolmanBaseUrl() + apiUrl + "/info");
+    int httpCode = http.GET();
+    if (httpCode == HTTP_CODE_OK) {
+        JsonDocument filter;
+        filter["version"] = true;
+        JsonDocument doc;
+        if (!deserializeResponse(http, doc, filter) && doc["version"].is<const char*>()) {
+            version = doc["version"].as<String>();
+        }
     }
-    
-    Serial.println("SUCCESS: Brand filament created with Spool ID: " + String(spoolId));
-    return true;
+    http.end();
+    return version;
+}
+
+// Background check of the stored schema: only a different server version forces the full check
+static void verifySpoolmanSchemaVersion() {
+    String infoUrl = spoolmanBaseUrl() + apiUrl + "/info";
+    enqueueApiJob(API_REQUEST_SERVER_INFO, "GET", infoUrl, "",
+        [](bool success, int httpCode, JsonDocument& response) {
+            if (!success || !response["version"].is<const char*>()) return;
+
+            Preferences preferences;
+            preferences.begin(NVS_NAMESPACE_API, true);
+            String version = preferences.getString(NVS_KEY_SPOOLMAN_FIELDS_VERSION, "");
+            preferences.end();
+
+            if (version == response["version"].as<String>()) {
+                spoolmanSchemaVersionVerified = true;
+                return;
+            }
+            Serial.println("Spoolman version changed (" + version + " -> " + response["version"].as<String>() + "), checking extra fields");
+            clearExtraFieldsFingerprint();
+            spoolmanExtraFieldsChecked = false;
+            spoolmanReachablePending = true;
+        }, "", "serverInfo");
 }
 
 // #### Spoolman init
@@ -1079,46 +1569,15 @@ bool checkSpoolmanExtraFields() {
         http.setReuse(false);
         http.setTimeout(10000);
         String checkUrls[] = {
-            spoolmanUrl + apiUrl + "/field/spool",
-            spoolmanUrl + apiUrl + "/field/filament"
-        };
-
-        String spoolExtra[] = {
-            "tag"
-        };
-
-        String filamentExtra[] = {
-            "nozzle_temperature",
-            "price_meter",
-            "price_gramm"
-        };
-
-        String spoolExtraFields[] = {
-            "{\"name\": \"Tag\","
-            "\"key\": \"tag\","
-            "\"field_type\": \"text\"}"
-        };
-
-        String filamentExtraFields[] = {
-            "{\"name\": \"Nozzle Temp\","
-            "\"unit\": \"°C\","
-            "\"field_type\": \"integer_range\","
-            "\"default_value\": \"[190,230]\","
-            "\"key\": \"nozzle_temperature\"}",
-
-            "{\"name\": \"Price/m\","
-            "\"unit\": \"€\","
-            "\"field_type\": \"float\","
-            "\"key\": \"price_meter\"}",
-            
-            "{\"name\": \"Price/g\","
-            "\"unit\": \"€\","
-            "\"field_type\": \"float\","
-            "\"key\": \"price_gramm\"}"
+            spoolmanBaseUrl() + apiUrl + "/field/spool",
+            spoolmanBaseUrl() + apiUrl + "/field/filament"
         };
 
         Serial.println("Überprüfe Extrafelder...");
 
+        String version = fetchSpoolmanVersion(http);
+        bool allChecked = true;
+
         int urlLength = sizeof(checkUrls) / sizeof(checkUrls[0]);
 
         for (uint8_t i = 0; i < urlLength; i++) {
@@ -1128,12 +1587,13 @@ bool checkSpoolmanExtraFields() {
             int httpCode = http.GET();
         
             if (httpCode == HTTP_CODE_OK) {
-                String payload = http.getString();
+                JsonDocument filter;
+                filter[0]["key"] = true;
                 JsonDocument doc;
-                DeserializationError error = deserializeJson(doc, payload);
+                DeserializationError error = deserializeResponse(http, doc, filter);
                 if (!error) {
-                    String* extraFields;
-                    String* extraFieldData;
+                    const char* const* extraFields;
+                    const char* const* extraFieldData;
                     u16_t extraLength;
 
                     if (i == 0) {
@@ -1150,13 +1610,13 @@ bool checkSpoolmanExtraFields() {
                         bool found = false;
                         for (JsonObject field : doc.as<JsonArray>()) {
                             if (field["key"].is<String>() && field["key"] == extraFields[s]) {
-                                Serial.println("Feld gefunden: " + extraFields[s]);
+                                Serial.println("Feld gefunden: " + String(extraFields[s]));
                                 found = true;
                                 break;
                             }
                         }
                         if (!found) {
-                            Serial.println("Feld nicht gefunden: " + extraFields[s]);
+                            Serial.println("Feld nicht gefunden: " + String(extraFields[s]));
 
                             // Extrafeld hinzufügen
                             http.begin(checkUrls[i] + "/" + extraFields[s]);
@@ -1178,12 +1638,16 @@ bool checkSpoolmanExtraFields() {
                                 return false;
                             }
                             //http.end();
+                            yield();
+                            vTaskDelay(100 / portTICK_PERIOD_MS);
                         }
-                        yield();
-                        vTaskDelay(100 / portTICK_PERIOD_MS);
                     }
+                } else {
+                    allChecked = false;
                 }
                 doc.clear();
+            } else {
+                allChecked = false;
             }
         }
         
@@ -1193,13 +1657,41 @@ bool checkSpoolmanExtraFields() {
         http.end();
 
         spoolmanExtraFieldsChecked = true;
+        // Remember only a complete check on a known version
+        if (allChecked && version.length() > 0) {
+            storeExtraFieldsFingerprint(version, extraFieldsFingerprint(spoolmanUrl, version));
+            spoolmanSchemaVersionVerified = true;
+        }
         return true;
     }else{
         return true;
     }
 }
 
+// Follow-up work whenever Spoolman answered: extra fields, flush the offline log, warm the lookup cache
+static void onSpoolmanReachable() {
+    // Normally done by initSpoolman() already, only runs once per URL
+    if (!checkSpoolmanExtraFields()) {
+        Serial.println("Fehler beim Überprüfen der Extrafelder.");
+        return;
+    }
+    if (!spoolmanSchemaVersionVerified) {
+        verifySpoolmanSchemaVersion();
+    }
+    if (offlineLogPendingCount() > 0) {
+        replayOfflineLog();
+    }
+    warmBrandCache();
+}
+
 bool checkSpoolmanInstance() {
+    // A live event connection already proves Spoolman is up, no need to poll /health
+    if (spoolmanEventsConnected() && spoolmanExtraFieldsChecked) {
+        setSpoolmanConnected(true);
+        onSpoolmanReachable();
+        return true;
+    }
+
     // Check heap before attempting SSL connection - HTTPS needs ~50-80KB
     uint32_t freeHeap = ESP.getFreeHeap();
     if (freeHeap < 60000) {
@@ -1213,63 +1705,111 @@ bool checkSpoolmanInstance() {
         return spoolmanConnected;
     }
 
+    // Breaker open: known to be down, do not block the caller for another timeout
+    if (!upstreamAllow(UPSTREAM_SPOOLMAN)) {
+        setSpoolmanConnected(false);
+        return false;
+    }
+
     spoolmanApiState = API_TRANSMITTING;
     
+    uint16_t timeoutMs = upstreamTimeoutMs(UPSTREAM_SPOOLMAN);
     HTTPClient http;
-    http.setReuse(false);
-    http.setTimeout(10000);
+    http.setConnectTimeout(timeoutMs);
+    http.setTimeout(timeoutMs);
     bool returnValue = false;
 
-    String targetUrl = (spoolmanInternalUrl != "") ? spoolmanInternalUrl : spoolmanUrl;
-    String healthUrl = targetUrl + apiUrl + "/health";
+    String healthUrl = spoolmanBaseUrl() + apiUrl + "/health";
 
     Serial.printf("Checking spoolman instance: %s (heap: %u)\n", healthUrl.c_str(), freeHeap);
 
-    http.begin(healthUrl);
+    WiFiClient* lease = nullptr;
+    httpPoolBegin(http, healthUrl, lease);
+    unsigned long requestStart = millis();
     int httpCode = http.GET();
+    uint32_t elapsed = millis() - requestStart;
+    upstreamRecord(UPSTREAM_SPOOLMAN, httpCode > 0 && httpCode < 500, elapsed);
+    spoolmanEndpointRecord(healthUrl, httpCode > 0 && httpCode < 500, elapsed);
 
     if (httpCode > 0) {
         if (httpCode == HTTP_CODE_OK) {
-            String payload = http.getString();
+            JsonDocument filter;
+            filter["status"] = true;
             JsonDocument doc;
-            DeserializationError error = deserializeJson(doc, payload);
+            DeserializationError error = deserializeResponse(http, doc, filter);
             if (!error && doc["status"].is<String>()) {
                 const char* status = doc["status"];
-                http.end();
+                httpPoolEnd(http, lease, true);
 
                 if (!checkSpoolmanExtraFields()) {
                     Serial.println("Fehler beim Überprüfen der Extrafelder.");
                     oledShowMessage("Spoolman Error creating Extrafields");
                     vTaskDelay(2000 / portTICK_PERIOD_MS);
-                    spoolmanApiState = API_IDLE;
+                    apiUpdateIdleState();
                     return false;
                 }
 
-                spoolmanApiState = API_IDLE;
+                apiUpdateIdleState();
                 oledShowTopRow();
-                spoolmanConnected = true;
+                setSpoolmanConnected(true);
                 returnValue = strcmp(status, "healthy") == 0;
             } else {
-                spoolmanConnected = false;
-                http.end();
+                setSpoolmanConnected(false);
+                httpPoolEnd(http, lease, false);
             }
             doc.clear();
         } else {
-            spoolmanConnected = false;
-            http.end();
+            setSpoolmanConnected(false);
+            httpPoolEnd(http, lease, false);
         }
     } else {
-        spoolmanConnected = false;
+        setSpoolmanConnected(false);
         Serial.println("Error contacting spoolman instance! HTTP Code: " + String(httpCode));
-        http.end();
+        httpPoolEnd(http, lease, false);
     }
     
-    spoolmanApiState = API_IDLE;
+    apiUpdateIdleState();
     Serial.println("Healthcheck completed!");
+
+    if (spoolmanConnected) {
+        onSpoolmanReachable();
+    }
     return returnValue;
 }
 
-bool saveSpoolmanUrl(const String& url, bool octoOn, const String& octo_url, const String& octoTk) {
+// Periodic variant for loop(): the request runs on the API worker behind any
+// interactive job instead of blocking the caller and the queue. Endpoints that
+// answered real requests recently are not probed, force probes all of them.
+void scheduleSpoolmanHealthCheck(bool force) {
+    // A live event connection already proves Spoolman is up
+    if (spoolmanEventsConnected() && spoolmanExtraFieldsChecked) {
+        setSpoolmanConnected(true);
+        spoolmanReachablePending = true;
+        return;
+    }
+
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < 60000) {
+        Serial.printf("Skipping Spoolman check due to low heap: %u\n", freeHeap);
+        return;
+    }
+
+    // Every configured URL is probed: keeps the RTT of the idle one current and
+    // brings a failed one back into the rotation
+    for (uint8_t i = 0; i < spoolmanEndpointCount(); i++) {
+        if (!force && !spoolmanEndpointIdle(i, SPOOLMAN_HEALTH_IDLE_MS)) continue;
+
+        // Connected state follows from the outcome in runApiJob()
+        String healthUrl = spoolmanEndpointBaseUrl(i) + apiUrl + "/health";
+        enqueueApiJob(API_REQUEST_HEALTH_CHECK, "GET", healthUrl, "",
+            [](bool success, int httpCode, JsonDocument& response) {
+                // Retry a failed replay or cache warm-up
+                if (success && response["status"].is<const char*>()) spoolmanReachablePending = true;
+            }, "", "health:" + String(i));
+    }
+}
+
+bool saveSpoolmanUrl(const String& url, bool octoOn, const String& octo_url, const String& octoTk, const String& octoToolName) {
     Preferences preferences;
     preferences.begin(NVS_NAMESPACE_API, false); // false = readwrite
     preferences.putString(NVS_KEY_SPOOLMAN_URL, url);
@@ -1279,14 +1819,22 @@ bool saveSpoolmanUrl(const String& url, bool octoOn, const String& octo_url, con
     preferences.putBool(NVS_KEY_OCTOPRINT_ENABLED, octoOn);
     preferences.putString(NVS_KEY_OCTOPRINT_URL, octo_url);
     preferences.putString(NVS_KEY_OCTOPRINT_TOKEN, octoTk);
+    preferences.putString(NVS_KEY_OCTOPRINT_TOOL, octoToolName);
     preferences.end();
 
-    //TBD: This could be handled nicer in the future
-    spoolmanExtraFieldsChecked = false;
+    brandCacheWarmed = false;
     spoolmanUrl = url;
+    // Another server needs its own check, the same one keeps the verified schema
+    restoreExtraFieldsFingerprint(spoolmanUrl);
+    spoolmanEndpointsConfigure(spoolmanUrl, spoolmanInternalUrl);
+    spoolmanEventsReconnect();
     octoEnabled = octoOn;
     octoUrl = octo_url;
     octoToken = octoTk;
+    octoTool = octoToolName;
+    // New servers, old response times and failures no longer apply
+    upstreamReset(UPSTREAM_SPOOLMAN);
+    upstreamReset(UPSTREAM_OCTOPRINT);
 
     return checkSpoolmanInstance();
 }
@@ -1301,15 +1849,26 @@ String loadSpoolmanUrl() {
     {
         octoUrl = preferences.getString(NVS_KEY_OCTOPRINT_URL, "");
         octoToken = preferences.getString(NVS_KEY_OCTOPRINT_TOKEN, "");
+        octoTool = preferences.getString(NVS_KEY_OCTOPRINT_TOOL, OCTOPRINT_DEFAULT_TOOL);
     }
     preferences.end();
+    spoolmanEndpointsConfigure(spoolmanUrl, spoolmanInternalUrl);
     return spoolmanUrl;
 }
 
 bool initSpoolman() {
     oledShowProgressBar(3, 7, DISPLAY_BOOT_TEXT, "Spoolman init");
+    initUpstreams();
+    initSpoolmanEndpoints();
+    initHttpPool();
     spoolmanUrl = loadSpoolmanUrl();
-    
+    restoreExtraFieldsFingerprint(spoolmanUrl);
+    initOfflineStore();
+    initSpoolCache();
+    initBrandCache();
+    ensureApiWorker();
+    initSpoolmanEvents();
+
     bool success = checkSpoolmanInstance();
     if (!success) {
         Serial.println("Spoolman not available");
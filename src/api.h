@@ -6,6 +6,7 @@
 #include "website.h"
 #include "display.h"
 #include <ArduinoJson.h>
+#include "spool_tag.h"
 typedef enum {
     API_INIT,
     API_IDLE,
@@ -22,7 +23,12 @@ typedef enum {
     API_REQUEST_VENDOR_CHECK,
     API_REQUEST_FILAMENT_CHECK,
     API_REQUEST_FILAMENT_CREATE,
-    API_REQUEST_SPOOL_CREATE
+    API_REQUEST_SPOOL_CREATE,
+    API_REQUEST_SPOOL_FETCH,
+    API_REQUEST_VENDOR_LIST,
+    API_REQUEST_FILAMENT_LIST,
+    API_REQUEST_HEALTH_CHECK,
+    API_REQUEST_SERVER_INFO
 } SpoolmanApiRequestType;
 
 extern volatile spoolmanApiStateType spoolmanApiState;
@@ -30,23 +36,28 @@ extern bool spoolman_connected;
 extern String spoolmanUrl;
 extern String spoolmanInternalUrl;
 extern bool octoEnabled;
-extern bool sendOctoUpdate;
 extern String octoUrl;
 extern String octoToken;
+extern String octoTool; // Tool, für das das Spoolman Octoprint Plugin die Spule auswählt
 extern bool spoolmanConnected;
-extern uint16_t updateOctoSpoolId;
 
 bool checkSpoolmanInstance();
-bool saveSpoolmanUrl(const String& url, bool octoOn, const String& octoWh, const String& octoTk);
+void scheduleSpoolmanHealthCheck(bool force = false); // Health check als Hintergrund-Job des API Workers
+uint32_t spoolmanHealthVersion(); // Zählt Wechsel von spoolmanConnected, zum Veröffentlichen im Loop
+bool apiForegroundBusy(); // Interaktiver Job (z.B. Wiegen) wartet oder läuft
+bool saveSpoolmanUrl(const String& url, bool octoOn, const String& octoWh, const String& octoTk, const String& octoToolName);
 String loadSpoolmanUrl(); // Neue Funktion zum Laden der URL
 bool checkSpoolmanExtraFields(); // Neue Funktion zum Überprüfen der Extrafelder
 JsonDocument fetchSingleSpoolInfo(int spoolId); // API-Funktion für die Webseite
-bool updateSpoolTagId(String uidString, const char* payload); // Neue Funktion zum Aktualisieren eines Spools
+bool prefetchSpoolInfo(int spoolId); // Spool in den Cache laden, ohne zu warten
+void refreshSpoolCache(); // Veraltete Cache-Einträge im Hintergrund aktualisieren
+bool updateSpoolTagId(String uidString, const String& spoolId); // Neue Funktion zum Aktualisieren eines Spools
 uint8_t updateSpoolWeight(String spoolId, uint16_t weight); // Neue Funktion zum Aktualisieren des Gewichts
 uint8_t updateSpoolLocation(String spoolId, String location);
 bool initSpoolman(); // Neue Funktion zum Initialisieren von Spoolman
 bool updateSpoolBambuData(String payload); // Neue Funktion zum Aktualisieren der Bambu-Daten
-bool updateSpoolOcto(int spoolId); // Neue Funktion zum Aktualisieren der Octo-Daten
-bool createBrandFilament(JsonDocument& payload, String uidString);
+bool updateSpoolOcto(int spoolId); // Spule in Octoprint für alle konfigurierten Tools auswählen
+bool createBrandFilament(const SpoolTagRecord& payload, String uidString);
+String getApiQueueStatsJson(); // Queue/coalescing counters of the API worker
 
 #endif
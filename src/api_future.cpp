@@ -0,0 +1,124 @@
+#include "api_future.h"
+#include <vector>
+
+// Futures waiting for a result, checked against their deadline by apiFutureSweep()
+static std::vector<ApiFuture::Ptr> pendingFutures;
+static SemaphoreHandle_t futureMutex = NULL;
+
+static void lockFutures() {
+    if (futureMutex == NULL) futureMutex = xSemaphoreCreateRecursiveMutex();
+    xSemaphoreTakeRecursive(futureMutex, portMAX_DELAY);
+}
+
+static void unlockFutures() {
+    xSemaphoreGiveRecursive(futureMutex);
+}
+
+ApiFuture::Ptr ApiFuture::create(uint32_t timeoutMs) {
+    Ptr future(new ApiFuture(millis() + timeoutMs));
+    if (timeoutMs > 0) {
+        lockFutures();
+        pendingFutures.push_back(future);
+        unlockFutures();
+    }
+    return future;
+}
+
+ApiFuture::Ptr ApiFuture::resolved(uint16_t id) {
+    Ptr future(new ApiFuture(millis()));
+    future->resolvedFlag = true;
+    future->value = id;
+    return future;
+}
+
+void ApiFuture::resolve(uint16_t id) {
+    std::vector<Continuation> done;
+    lockFutures();
+    if (resolvedFlag) {
+        unlockFutures();
+        return;
+    }
+    resolvedFlag = true;
+    value = id;
+    done.swap(continuations);
+    for (size_t i = 0; i < pendingFutures.size(); i++) {
+        if (pendingFutures[i].get() == this) {
+            pendingFutures.erase(pendingFutures.begin() + i);
+            break;
+        }
+    }
+    unlockFutures();
+
+    // Outside the lock, a continuation may start the next step
+    for (Continuation& next : done) {
+        if (next) next(id);
+    }
+}
+
+void ApiFuture::onResolved(Continuation done) {
+    lockFutures();
+    if (!resolvedFlag) {
+        continuations.push_back(done);
+        unlockFutures();
+        return;
+    }
+    uint16_t id = value;
+    unlockFutures();
+    done(id);
+}
+
+// Chained futures need no deadline of their own: this future and the one returned
+// by step both have one, so the chained one is always resolved eventually.
+ApiFuture::Ptr ApiFuture::then(Step step) {
+    Ptr chained = create(0);
+
+    onResolved([chained, step](uint16_t id) {
+        if (id == 0) {
+            chained->resolve(0);
+            return;
+        }
+        Ptr next = step(id);
+        if (!next) {
+            chained->resolve(0);
+            return;
+        }
+        next->onResolved([chained](uint16_t nextId) { chained->resolve(nextId); });
+    });
+    return chained;
+}
+
+ApiFuture::Ptr ApiFuture::orElse(Fallback fallback) {
+    Ptr chained = create(0);
+
+    onResolved([chained, fallback](uint16_t id) {
+        if (id > 0) {
+            chained->resolve(id);
+            return;
+        }
+        Ptr next = fallback();
+        if (!next) {
+            chained->resolve(0);
+            return;
+        }
+        next->onResolved([chained](uint16_t nextId) { chained->resolve(nextId); });
+    });
+    return chained;
+}
+
+void apiFutureSweep() {
+    if (futureMutex == NULL) return;
+
+    std::vector<ApiFuture::Ptr> expired;
+    unsigned long now = millis();
+
+    lockFutures();
+    for (const ApiFuture::Ptr& future : pendingFutures) {
+        if ((long)(now - future->deadline()) >= 0) expired.push_back(future);
+    }
+    unlockFutures();
+
+    for (const ApiFuture::Ptr& future : expired) {
+        Serial.println("API: step timed out");
+        future->resolve(0);
+    }
+}
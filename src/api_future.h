@@ -0,0 +1,50 @@
+#ifndef API_FUTURE_H
+#define API_FUTURE_H
+
+#include <Arduino.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Result of an asynchronous Spoolman step that yields an id (vendor, filament, spool).
+// An id of 0 means the step failed. Continuations run on the task that resolves the
+// future, normally the API worker. Every request future has a deadline and resolves to 0
+// on the next sweep after it, so a chain of steps can never hang.
+class ApiFuture {
+public:
+    typedef std::shared_ptr<ApiFuture> Ptr;
+    typedef std::function<void(uint16_t id)> Continuation;
+    typedef std::function<Ptr(uint16_t id)> Step;
+    typedef std::function<Ptr()> Fallback;
+
+    // timeoutMs 0 = no own deadline (only for futures fed by other futures)
+    static Ptr create(uint32_t timeoutMs);
+    static Ptr resolved(uint16_t id);
+
+    // First call wins, later calls are ignored
+    void resolve(uint16_t id);
+    // Runs done once the future is resolved (immediately if it already is). Several
+    // continuations may be registered, they run in the order they were added.
+    void onResolved(Continuation done);
+    // Runs step with the id on success; the returned future resolves with the step's result.
+    // A failure skips step and propagates 0.
+    Ptr then(Step step);
+    // Runs fallback if this future resolved to 0, e.g. create after a failed lookup
+    Ptr orElse(Fallback fallback);
+
+    bool isResolved() const { return resolvedFlag; }
+    unsigned long deadline() const { return deadlineMs; }
+
+private:
+    explicit ApiFuture(unsigned long deadline) : deadlineMs(deadline) {}
+
+    bool resolvedFlag = false;
+    uint16_t value = 0;
+    unsigned long deadlineMs;
+    std::vector<Continuation> continuations;
+};
+
+// Resolve expired futures with 0, called periodically by the API worker
+void apiFutureSweep();
+
+#endif
@@ -12,6 +12,7 @@
 #include "led.h"
 #include <Preferences.h>
 #include "mqtt_helpers.h"
+#include "ams_merge.h"
 
 #ifndef ASYNC_MQTT
 #include <PubSubClient.h>
@@ -61,6 +62,7 @@ bool removeBambuCredentials() {
     preferences.remove(NVS_KEY_BAMBU_ACCESSCODE);
     preferences.remove(NVS_KEY_BAMBU_AUTOSEND_ENABLE);
     preferences.remove(NVS_KEY_BAMBU_AUTOSEND_TIME);
+    preferences.remove(NVS_KEY_BAMBU_PERSISTENT);
     preferences.end();
 
     // Löschen der globalen Variablen
@@ -69,6 +71,7 @@ bool removeBambuCredentials() {
     bambuCredentials.accesscode = "";
     bambuCredentials.autosend_enable = false;
     bambuCredentials.autosend_time = BAMBU_DEFAULT_AUTOSEND_TIME;
+    bambuCredentials.persistent_session = false;
 
     autoSetToBambuSpoolId = 0;
     ams_count = 0;
@@ -79,7 +82,7 @@ bool removeBambuCredentials() {
     return true;
 }
 
-bool saveBambuCredentials(const String& ip, const String& serialnr, const String& accesscode, bool autoSend, const String& autoSendTime) {
+bool saveBambuCredentials(const String& ip, const String& serialnr, const String& accesscode, bool autoSend, const String& autoSendTime, bool persistentSession) {
     if (BambuMqttTask) {
         vTaskDelete(BambuMqttTask);
         BambuMqttTask = NULL;
@@ -90,6 +93,7 @@ bool saveBambuCredentials(const String& ip, const String& serialnr, const String
     bambuCredentials.accesscode = accesscode.c_str();
     bambuCredentials.autosend_enable = autoSend;
     bambuCredentials.autosend_time = autoSendTime.toInt();
+    bambuCredentials.persistent_session = persistentSession;
 
     Preferences preferences;
     preferences.begin(NVS_NAMESPACE_BAMBU, false); // false = readwrite
@@ -98,6 +102,7 @@ bool saveBambuCredentials(const String& ip, const String& serialnr, const String
     preferences.putString(NVS_KEY_BAMBU_ACCESSCODE, bambuCredentials.accesscode);
     preferences.putBool(NVS_KEY_BAMBU_AUTOSEND_ENABLE, bambuCredentials.autosend_enable);
     preferences.putInt(NVS_KEY_BAMBU_AUTOSEND_TIME, bambuCredentials.autosend_time);
+    preferences.putBool(NVS_KEY_BAMBU_PERSISTENT, bambuCredentials.persistent_session);
     preferences.end();
 
     vTaskDelay(100 / portTICK_PERIOD_MS);
@@ -114,6 +119,7 @@ bool loadBambuCredentials() {
     String code = preferences.getString(NVS_KEY_BAMBU_ACCESSCODE, "");
     bool autosendEnable = preferences.getBool(NVS_KEY_BAMBU_AUTOSEND_ENABLE, false);
     int autosendTime = preferences.getInt(NVS_KEY_BAMBU_AUTOSEND_TIME, BAMBU_DEFAULT_AUTOSEND_TIME);
+    bool persistentSession = preferences.getBool(NVS_KEY_BAMBU_PERSISTENT, false);
     preferences.end();
 
     if(ip != ""){
@@ -122,6 +128,7 @@ bool loadBambuCredentials() {
         bambuCredentials.accesscode = code.c_str();
         bambuCredentials.autosend_enable = autosendEnable;
         bambuCredentials.autosend_time = autosendTime;
+        bambuCredentials.persistent_session = persistentSession;
 
         Serial.println("credentials loaded loadCredentials!");
         Serial.println(bambuCredentials.ip);
@@ -129,6 +136,7 @@ bool loadBambuCredentials() {
         Serial.println(bambuCredentials.accesscode);
         Serial.println(String(bambuCredentials.autosend_enable));
         Serial.println(String(bambuCredentials.autosend_time));
+        Serial.println(String(bambuCredentials.persistent_session));
 
         return true;
     }
@@ -340,14 +348,14 @@ bool setBambuSpool(String payload) {
     return true;
 }
 
-void autoSetSpool(int spoolId, uint8_t trayId) {
+void autoSetSpool(int spoolId, uint8_t amsId, uint8_t trayId) {
     // wenn neue spule erkannt und autoSetToBambu > 0
     JsonDocument spoolInfo = fetchSingleSpoolInfo(spoolId);
 
     if (!spoolInfo.isNull())
     {
         // AMS und TRAY id ergänzen
-        spoolInfo["amsId"] = 0;
+        spoolInfo["amsId"] = amsId;
         spoolInfo["trayId"] = trayId;
 
         Serial.println("Auto set spool");
@@ -520,75 +528,10 @@ void checkTrayFilled(uint8_t amsId, uint8_t trayId, bool isBambuSpool) {
 
 // ============= End Empty Tray Functions =============
 
-void updateAmsWsData(JsonDocument& doc, JsonArray& amsArray, int& ams_count, JsonObject& vtTray) {
-    // Fortfahren mit der bestehenden Verarbeitung, da Änderungen gefunden wurden
-    int normalAms = amsArray.size();
-    if (normalAms > MAX_AMS - 1) {
-        normalAms = MAX_AMS - 1; // Reserve one slot for the optional external spool
-    }
-    ams_count = normalAms;
-        
-    for (int i = 0; i < ams_count; i++) {
-        JsonObject amsObj = amsArray[i];
-        JsonArray trayArray = amsObj["tray"].as<JsonArray>();
-
-        // ams_data[i].ams_id = i; // Setze die AMS-ID
-        ams_data[i].ams_id = amsObj["id"].as<uint8_t>(); // Use the ID from JSON
-        
-        Serial.print("Processing AMS ID: ");
-        Serial.println(ams_data[i].ams_id);
-
-        for (int j = 0; j < trayArray.size() && j < 4; j++) { // Annahme: Maximal 4 Trays pro AMS
-            JsonObject trayObj = trayArray[j];
-
-            ams_data[i].trays[j].id = trayObj["id"].as<uint8_t>();
-            ams_data[i].trays[j].tray_info_idx = trayObj["tray_info_idx"].as<String>();
-            ams_data[i].trays[j].tray_type = trayObj["tray_type"].as<String>();
-            ams_data[i].trays[j].tray_sub_brands = trayObj["tray_sub_brands"].as<String>();
-            ams_data[i].trays[j].tray_color = trayObj["tray_color"].as<String>();
-            ams_data[i].trays[j].nozzle_temp_min = trayObj["nozzle_temp_min"].as<int>();
-            ams_data[i].trays[j].nozzle_temp_max = trayObj["nozzle_temp_max"].as<int>();
-            if (trayObj["tray_type"].as<String>() == "") ams_data[i].trays[j].setting_id = "";
-            ams_data[i].trays[j].cali_idx = trayObj["cali_idx"].as<String>();
-            ams_data[i].trays[j].remain = trayObj["remain"].as<int>();
-            ams_data[i].trays[j].tray_uuid = trayObj["tray_uuid"].as<String>();
-            String uid = trayObj["tag_uid"].as<String>();
-            if (uid == "null") uid = "";
-            ams_data[i].trays[j].tag_uid = uid;
-            Serial.print("Tray "); Serial.print(j); Serial.print(" Tag UID: "); Serial.println(ams_data[i].trays[j].tag_uid);
-        }
-    }
-    
-    // Wenn externe Spule vorhanden, füge sie hinzu
-    if (doc["print"]["vt_tray"].is<JsonObject>() && ams_count < MAX_AMS) {
-        int extIdx = ams_count;  // Index für externe Spule
-        ams_data[extIdx].ams_id = 255;  // Spezielle ID für externe Spule
-        ams_data[extIdx].trays[0].id = 254;  // Spezielle ID für externes Tray
-        ams_data[extIdx].trays[0].tray_info_idx = vtTray["tray_info_idx"].as<String>();
-        ams_data[extIdx].trays[0].tray_type = vtTray["tray_type"].as<String>();
-        ams_data[extIdx].trays[0].tray_sub_brands = vtTray["tray_sub_brands"].as<String>();
-        ams_data[extIdx].trays[0].tray_color = vtTray["tray_color"].as<String>();
-        ams_data[extIdx].trays[0].nozzle_temp_min = vtTray["nozzle_temp_min"].as<int>();
-        ams_data[extIdx].trays[0].nozzle_temp_max = vtTray["nozzle_temp_max"].as<int>();
-        ams_data[extIdx].trays[0].remain = vtTray["remain"].as<int>();
-        ams_data[extIdx].trays[0].tray_uuid = vtTray["tray_uuid"].as<String>();
-        String uid = vtTray["tag_uid"].as<String>();
-        if (uid == "null") uid = "";
-        ams_data[extIdx].trays[0].tag_uid = uid;
-
-        if (doc["print"]["vt_tray"]["tray_type"].as<String>() != "")
-        {
-            //ams_data[extIdx].trays[0].setting_id = vtTray["setting_id"].as<String>();
-            ams_data[extIdx].trays[0].cali_idx = vtTray["cali_idx"].as<String>();
-        }
-        else
-        {
-            ams_data[extIdx].trays[0].setting_id = "";
-            ams_data[extIdx].trays[0].cali_idx = "";
-        }
-        ams_count++;  // Erhöhe ams_count für die externe Spule
-    }
+// Persistent session: an AMS unit that showed up in a delta needs a pushall
+static volatile bool mqttResyncRequested = false;
 
+static void publishAmsData() {
     // Erstelle JSON für WebSocket-Clients
     JsonDocument wsDoc;
     JsonArray wsArray = wsDoc.to<JsonArray>();
@@ -614,6 +557,7 @@ void updateAmsWsData(JsonDocument& doc, JsonArray& amsArray, int& ams_count, Jso
             trayObj["remain"] = ams_data[i].trays[j].remain;
             trayObj["tray_uuid"] = ams_data[i].trays[j].tray_uuid;
             trayObj["tag_uid"] = ams_data[i].trays[j].tag_uid;
+            trayObj["version"] = ams_data[i].trays[j].version;
         }
     }
 
@@ -647,19 +591,14 @@ void mqtt_callback(char* topic, byte* payload, unsigned int length) {
         Serial.println("  [REQUEST topic] This is an echo/ack of our request");
     }
 
-    static uint32_t lastMqttProcessTime = 0;
-    // Always process if we don't have data yet, otherwise throttle
-    if (ams_count > 0 && millis() - lastMqttProcessTime < 5000) {
-        return;  // Throttle within a poll session
-    }
-    
+    // No throttling: reports are filtered on parse and merged field by field,
+    // a skipped delta would never be sent again
     if (ESP.getFreeHeap() < 15000) {
         Serial.printf("Low memory (%u), skipping MQTT processing\n", ESP.getFreeHeap());
         return;
     }
 
     Serial.println("Processing MQTT message...");
-    lastMqttProcessTime = millis();
 
     // Filter definieren, um Speicher zu sparen
     static JsonDocument filter;
@@ -728,110 +667,35 @@ void mqtt_callback(char* topic, byte* payload, unsigned int length) {
     if (doc["print"]["upgrade_state"].is<JsonObject>() || (doc["print"]["command"].is<String>() && doc["print"]["command"] == "push_status") || doc["print"]["ams"].is<JsonObject>()) 
     {
         // Prüfen ob AMS-Daten vorhanden sind
-        if (!doc["print"]["ams"].is<JsonObject>() || !doc["print"]["ams"]["ams"].is<JsonArray>()) 
+        if (!doc["print"]["ams"]["ams"].is<JsonArray>() && !doc["print"]["vt_tray"].is<JsonObject>()) 
         {
             return;
         }
 
-        JsonArray amsArray = doc["print"]["ams"]["ams"].as<JsonArray>();
-
-        // Prüfe ob sich die AMS-Daten geändert haben
-        bool hasChanges = false;
-        
-        // Vergleiche jedes AMS und seine Trays
-        for (int i = 0; i < amsArray.size() && !hasChanges; i++) {
-            JsonObject amsObj = amsArray[i];
-            int amsId = amsObj["id"].as<uint8_t>();
-            JsonArray trayArray = amsObj["tray"].as<JsonArray>();
-            
-            // Finde das entsprechende AMS in unseren Daten
-            int storedIndex = -1;
-            for (int k = 0; k < ams_count; k++) {
-                if (ams_data[k].ams_id == amsId) {
-                    storedIndex = k;
-                    break;
-                }
-            }
-            
-            if (storedIndex == -1) {
-                hasChanges = true;
-                break;
-            }
-
-            // Vergleiche die Trays
-            for (int j = 0; j < trayArray.size() && j < 4 && !hasChanges; j++) {
-                JsonObject trayObj = trayArray[j];
+        bool hadData = ams_count > 0;
+        AmsMergeResult result = amsMergeReport(doc["print"].as<JsonObject>());
 
-                if (trayObj["setting_id"].isNull()) trayObj["setting_id"] = "";
-                
-                // Check if tray was empty and is now filled (for pending tray assignment)
-                String oldTrayType = ams_data[storedIndex].trays[j].tray_type;
-                String newTrayType = trayObj["tray_type"].as<String>();
-                bool wasEmpty = (oldTrayType == "" || oldTrayType.length() == 0);
-                bool isNowFilled = (newTrayType != "" && newTrayType.length() > 0);
-                
-                if (wasEmpty && isNowFilled && hasPendingTrayAssignment()) {
-                    // Check if this is a Bambu spool (has valid tag_uid or tray_uuid)
-                    String newTagUid = trayObj["tag_uid"].as<String>();
-                    String newTrayUuid = trayObj["tray_uuid"].as<String>();
-                    bool isBambuSpool = (newTagUid != "" && newTagUid != "0000000000000000") ||
-                                        (newTrayUuid != "" && newTrayUuid != "00000000000000000000000000000000");
-                    
-                    Serial.printf("Tray filled detected: AMS %d Tray %d, type=%s, isBambu=%d\n", 
-                        amsId, trayObj["id"].as<uint8_t>(), newTrayType.c_str(), isBambuSpool);
-                    
-                    checkTrayFilled(amsId, trayObj["id"].as<uint8_t>(), isBambuSpool);
-                }
-                
-                if (trayObj["tray_info_idx"].as<String>() != ams_data[storedIndex].trays[j].tray_info_idx ||
-                    trayObj["tray_type"].as<String>() != ams_data[storedIndex].trays[j].tray_type ||
-                    trayObj["tray_color"].as<String>() != ams_data[storedIndex].trays[j].tray_color ||
-                    trayObj["setting_id"].as<String>() != ams_data[storedIndex].trays[j].setting_id ||
-                    trayObj["cali_idx"].as<String>() != ams_data[storedIndex].trays[j].cali_idx ||
-                    trayObj["remain"].as<int>() != ams_data[storedIndex].trays[j].remain ||
-                    trayObj["tray_uuid"].as<String>() != ams_data[storedIndex].trays[j].tray_uuid ||
-                    trayObj["tag_uid"].as<String>() != ams_data[storedIndex].trays[j].tag_uid) {
-                    hasChanges = true;
-
-                    if (bambuCredentials.autosend_enable && autoSetToBambuSpoolId > 0 && hasChanges)
-                    {
-                        autoSetSpool(autoSetToBambuSpoolId, ams_data[storedIndex].trays[j].id);
-                    }
-
-                    break;
-                }
+        for (const AmsTrayChange& change : result.changes) {
+            // Check if tray was empty and is now filled (for pending tray assignment)
+            if (change.filled && change.amsId != 255 && hasPendingTrayAssignment()) {
+                Serial.printf("Tray filled detected: AMS %d Tray %d, isBambu=%d\n", 
+                    change.amsId, change.trayId, change.isBambuSpool);
+                checkTrayFilled(change.amsId, change.trayId, change.isBambuSpool);
             }
         }
 
-        // Prüfe die externe Spule
-        JsonObject vtTray = doc["print"]["vt_tray"];
-        if (doc["print"]["vt_tray"].is<JsonObject>()) {
-            for (int i = 0; i < ams_count; i++) {
-                if (ams_data[i].ams_id == 255) {
-                    if (vtTray["setting_id"].isNull()) vtTray["setting_id"] = "";
-                    if (vtTray["tray_info_idx"].as<String>() != ams_data[i].trays[0].tray_info_idx ||
-                        vtTray["tray_type"].as<String>() != ams_data[i].trays[0].tray_type ||
-                        vtTray["tray_color"].as<String>() != ams_data[i].trays[0].tray_color ||
-                        vtTray["setting_id"].as<String>() != ams_data[i].trays[0].setting_id ||
-                        (vtTray["tray_type"].as<String>() != "" && vtTray["cali_idx"].as<String>() != ams_data[i].trays[0].cali_idx) ||
-                        vtTray["remain"].as<int>() != ams_data[i].trays[0].remain ||
-                        vtTray["tray_uuid"].as<String>() != ams_data[i].trays[0].tray_uuid ||
-                        vtTray["tag_uid"].as<String>() != ams_data[i].trays[0].tag_uid) {
-                        hasChanges = true;
-
-                        if (bambuCredentials.autosend_enable && autoSetToBambuSpoolId > 0 && hasChanges)
-                        {
-                            autoSetSpool(autoSetToBambuSpoolId, 254);
-                        }
-                    }
-                    break;
-                }
-            }
+        // Only a tray that got another spool takes the weighed one, not every remain tick.
+        // autoSetSpool() resets autoSetToBambuSpoolId, so one spool goes to one tray.
+        for (const AmsTrayChange& change : result.changes) {
+            if (!change.spoolChanged || !bambuCredentials.autosend_enable || autoSetToBambuSpoolId == 0) continue;
+            autoSetSpool(autoSetToBambuSpoolId, change.amsId, change.trayId);
         }
 
-        if (!hasChanges) return;
+        // A delta may have brought the new unit only partially
+        if (bambuCredentials.persistent_session && result.newAms && hadData) mqttResyncRequested = true;
 
-        updateAmsWsData(doc, amsArray, ams_count, vtTray);
+        if (result.changes.empty() && !result.newAms) return;
+        publishAmsData();
     }
     
     // Neue Bedingung für ams_filament_setting
@@ -840,29 +704,10 @@ void mqtt_callback(char* topic, byte* payload, unsigned int length) {
         int trayId = doc["print"]["tray_id"].as<int>();
         String settingId = (doc["print"]["setting_id"].is<String>()) ? doc["print"]["setting_id"].as<String>() : "";
 
-        // Finde das entsprechende AMS und Tray
-        for (int i = 0; i < ams_count; i++) {
-            if (ams_data[i].ams_id == amsId) {
-                if (trayId == 254)
-                {
-                    // Suche AMS mit ID 255 (externe Spule)
-                    for (int j = 0; j < ams_count; j++) {
-                        if (ams_data[j].ams_id == 255) {
-                            ams_data[j].trays[0].setting_id = settingId;
-                            break;
-                        }
-                    }
-                }
-                else
-                {
-                    ams_data[i].trays[trayId].setting_id = settingId;
-                }
-               
-                // Sende an WebSocket Clients
-                Serial.println("Filament setting updated");
-                sendAmsData(nullptr);
-                break;
-            }
+        if (amsMergeSetting(amsId, trayId, settingId)) {
+            // Sende an WebSocket Clients
+            Serial.println("Filament setting updated");
+            publishAmsData();
         }
     }
 }
@@ -985,8 +830,83 @@ bool reconnect() {
 #define MQTT_POLL_INTERVAL 60000
 // How long to stay connected waiting for data (30 seconds max - Bambu can be slow)
 #define MQTT_CONNECT_TIMEOUT 30000
+// Persistent session: full report as a safety net, and the minimum spacing of
+// resyncs requested by the callback (pushall is expensive on P1/A1 printers)
+#define MQTT_RESYNC_INTERVAL 1800000
+#define MQTT_RESYNC_MIN_INTERVAL 30000
+
+static void requestPushall() {
+    JsonDocument doc;
+    doc["pushing"]["sequence_id"] = "0";
+    doc["pushing"]["command"] = "pushall";
+    doc["pushing"]["version"] = 1;
+    String output;
+    serializeJson(doc, output);
+    sendMqttMessage(output);
+}
+
+// Stay connected, the printer pushes push_status deltas as they happen and
+// mqtt_callback merges them. pushall only after (re)connecting or on resync.
+static void mqttSessionLoop() {
+    Serial.println("Bambu MQTT Task gestartet (Session Mode)");
+    unsigned long lastResync = millis();  // setupMqtt sent pushall already
+    bool wasConnected = client.connected();
+
+    for(;;) {
+        if (pauseBambuMqttTask) {
+            if (client.connected()) {
+                Serial.println("MQTT: Pausing - disconnecting");
+                client.disconnect();
+            }
+            wasConnected = false;
+            for (int i = 0; i < 20 && pauseBambuMqttTask; ++i) {
+                esp_task_wdt_reset();
+                vTaskDelay(500 / portTICK_PERIOD_MS);
+            }
+            continue;
+        }
+
+        if (!client.connected()) {
+            if (wasConnected) {
+                Serial.printf("MQTT Session: Connection lost (state=%d:%s)\n", client.state(), mqttStateToString(client.state()));
+                bambu_connected = false;
+                oledShowTopRow();
+            }
+            if (!reconnect()) {
+                Serial.println("Exiting MQTT task after failed reconnection attempts");
+                BambuMqttTask = NULL;
+                vTaskDelete(NULL);
+                return;
+            }
+            // Deltas sent while we were gone are lost
+            requestPushall();
+            lastResync = millis();
+            mqttResyncRequested = false;
+        }
+        wasConnected = true;
+
+        client.loop();
+
+        unsigned long now = millis();
+        if ((mqttResyncRequested && now - lastResync >= MQTT_RESYNC_MIN_INTERVAL) ||
+            now - lastResync >= MQTT_RESYNC_INTERVAL) {
+            Serial.println("MQTT Session: Resync (pushall)");
+            requestPushall();
+            lastResync = now;
+            mqttResyncRequested = false;
+        }
+
+        esp_task_wdt_reset();
+        vTaskDelay(100 / portTICK_PERIOD_MS);
+    }
+}
 
 void mqtt_loop(void * parameter) {
+    if (bambuCredentials.persistent_session) {
+        mqttSessionLoop();
+        return;
+    }
+
     Serial.println("Bambu MQTT Task gestartet (Poll Mode)");
     static unsigned long lastPollTime = 0;
     static unsigned long connectStartTime = 0;
@@ -1036,13 +956,7 @@ void mqtt_loop(void * parameter) {
                 
                 if (client.connected()) {
                     // Request data
-                    JsonDocument doc;
-                    doc["pushing"]["sequence_id"] = "0";
-                    doc["pushing"]["command"] = "pushall";
-                    doc["pushing"]["version"] = 1;
-                    String output;
-                    serializeJson(doc, output);
-                    sendMqttMessage(output);
+                    requestPushall();
                     
                     connectStartTime = now;
                     waitingForData = true;
@@ -1183,13 +1097,7 @@ bool setupMqtt() {
             Serial.println("MQTT-Client initialisiert");
 
             // Request full data
-            JsonDocument doc;
-            doc["pushing"]["sequence_id"] = "0";
-            doc["pushing"]["command"] = "pushall";
-            doc["pushing"]["version"] = 1;
-            String output;
-            serializeJson(doc, output);
-            sendMqttMessage(output);
+            requestPushall();
 
             oledShowMessage("Bambu Connected");
             bambu_connected = true;
@@ -17,6 +17,7 @@ struct TrayData {
     int remain;
     String tray_uuid;
     String tag_uid;
+    uint32_t version;   // Zählt Änderungen durch MQTT-Reports (ams_merge)
 };
 
 struct BambuCredentials {
@@ -25,6 +26,7 @@ struct BambuCredentials {
     String accesscode;
     bool autosend_enable;
     int autosend_time;
+    bool persistent_session; // Verbindung halten und Deltas übernehmen statt alle 60 s pollen
 };
 
 #define MAX_AMS 17  // 16 normale AMS + 1 externe Spule
@@ -62,7 +64,7 @@ extern BambuCredentials bambuCredentials;
 
 bool removeBambuCredentials();
 bool loadBambuCredentials();
-bool saveBambuCredentials(const String& bambu_ip, const String& bambu_serialnr, const String& bambu_accesscode, const bool autoSend, const String& autoSendTime);
+bool saveBambuCredentials(const String& bambu_ip, const String& bambu_serialnr, const String& bambu_accesscode, const bool autoSend, const String& autoSendTime, const bool persistentSession);
 bool setupMqtt();
 void mqtt_loop(void * parameter);
 bool setBambuSpool(String payload);
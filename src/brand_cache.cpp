@@ -0,0 +1,154 @@
+#include "brand_cache.h"
+#include "commonFS.h"
+#include "config.h"
+
+// {"v": {"<vendor name>": id}, "f": {"<vendor id>:<external id>": id}}
+static JsonDocument brandCache;
+static SemaphoreHandle_t brandCacheMutex = NULL;
+static uint32_t brandCacheHits = 0;
+static uint32_t brandCacheMisses = 0;
+
+class BrandCacheLock {
+public:
+    BrandCacheLock() { if (brandCacheMutex) xSemaphoreTake(brandCacheMutex, portMAX_DELAY); }
+    ~BrandCacheLock() { if (brandCacheMutex) xSemaphoreGive(brandCacheMutex); }
+};
+
+// Vendor names from tags and from Spoolman differ in case and spacing
+static String vendorKey(const String& name) {
+    String key = name;
+    key.trim();
+    key.toLowerCase();
+    return key;
+}
+
+static String filamentKey(uint16_t vendorId, const String& externalId) {
+    String external = externalId;
+    external.trim();
+    return String(vendorId) + ":" + external;
+}
+
+// Caller holds the lock
+static bool saveLocked() {
+    return saveJsonValue(BRAND_CACHE_FILE, brandCache);
+}
+
+void initBrandCache() {
+    if (brandCacheMutex == NULL) brandCacheMutex = xSemaphoreCreateMutex();
+
+    BrandCacheLock lock;
+    if (!LittleFS.exists(BRAND_CACHE_FILE) || !loadJsonValue(BRAND_CACHE_FILE, brandCache) || !brandCache.is<JsonObject>()) {
+        brandCache.to<JsonObject>();
+    }
+    if (!brandCache["v"].is<JsonObject>()) brandCache["v"].to<JsonObject>();
+    if (!brandCache["f"].is<JsonObject>()) brandCache["f"].to<JsonObject>();
+
+    Serial.printf("Brand cache: %u vendors, %u filaments\n",
+                  brandCache["v"].size(), brandCache["f"].size());
+}
+
+uint16_t brandCacheVendorId(const String& name) {
+    BrandCacheLock lock;
+    uint16_t vendorId = brandCache["v"][vendorKey(name)] | 0;
+    if (vendorId > 0) brandCacheHits++;
+    else brandCacheMisses++;
+    return vendorId;
+}
+
+uint16_t brandCacheFilamentId(uint16_t vendorId, const String& externalId) {
+    if (externalId.length() == 0) return 0;
+
+    BrandCacheLock lock;
+    uint16_t filamentId = brandCache["f"][filamentKey(vendorId, externalId)] | 0;
+    if (filamentId > 0) brandCacheHits++;
+    else brandCacheMisses++;
+    return filamentId;
+}
+
+void brandCacheStoreVendor(const String& name, uint16_t vendorId, bool persist) {
+    if (name.length() == 0 || vendorId == 0) return;
+
+    BrandCacheLock lock;
+    JsonObject vendors = brandCache["v"];
+    String key = vendorKey(name);
+    if ((vendors[key] | 0) == vendorId) return;
+    if (!vendors[key].is<uint16_t>() && vendors.size() >= BRAND_CACHE_MAX_ENTRIES) return;
+
+    vendors[key] = vendorId;
+    if (persist) saveLocked();
+}
+
+void brandCacheStoreFilament(uint16_t vendorId, const String& externalId, uint16_t filamentId, bool persist) {
+    if (vendorId == 0 || externalId.length() == 0 || filamentId == 0) return;
+
+    BrandCacheLock lock;
+    JsonObject filaments = brandCache["f"];
+    String key = filamentKey(vendorId, externalId);
+    if ((filaments[key] | 0) == filamentId) return;
+    if (!filaments[key].is<uint16_t>() && filaments.size() >= BRAND_CACHE_MAX_ENTRIES) return;
+
+    filaments[key] = filamentId;
+    if (persist) saveLocked();
+}
+
+void brandCacheForgetVendor(const String& name) {
+    BrandCacheLock lock;
+    brandCache["v"].remove(vendorKey(name));
+    saveLocked();
+}
+
+void brandCacheForgetFilament(uint16_t vendorId, const String& externalId) {
+    BrandCacheLock lock;
+    brandCache["f"].remove(filamentKey(vendorId, externalId));
+    saveLocked();
+}
+
+// Caller holds the lock. Returns the number of removed entries.
+static size_t removeByValue(JsonObject map, uint16_t id) {
+    size_t removed = 0;
+    for (JsonObject::iterator it = map.begin(); it != map.end();) {
+        if ((it->value() | 0) == id) {
+            String key = it->key().c_str();
+            map.remove(key);
+            it = map.begin();
+            removed++;
+        } else {
+            ++it;
+        }
+    }
+    return removed;
+}
+
+void brandCacheForgetVendorId(uint16_t vendorId) {
+    if (vendorId == 0) return;
+
+    BrandCacheLock lock;
+    if (removeByValue(brandCache["v"], vendorId) > 0) saveLocked();
+}
+
+void brandCacheForgetFilamentId(uint16_t filamentId) {
+    if (filamentId == 0) return;
+
+    BrandCacheLock lock;
+    if (removeByValue(brandCache["f"], filamentId) > 0) saveLocked();
+}
+
+bool brandCacheSave() {
+    BrandCacheLock lock;
+    return saveLocked();
+}
+
+String getBrandCacheStatsJson() {
+    JsonDocument doc;
+    {
+        BrandCacheLock lock;
+        doc["vendors"] = brandCache["v"].size();
+        doc["filaments"] = brandCache["f"].size();
+    }
+    doc["hits"] = brandCacheHits;
+    doc["misses"] = brandCacheMisses;
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
@@ -0,0 +1,26 @@
+#ifndef BRAND_CACHE_H
+#define BRAND_CACHE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Persistent lookup for brand filament onboarding:
+//   vendor name               -> Spoolman vendor id
+//   (vendor id, external_id)  -> Spoolman filament id
+// Warmed from Spoolman at startup, updated whenever a check or create returns an id
+// and kept in sync with vendor/filament change events.
+
+void initBrandCache();
+uint16_t brandCacheVendorId(const String& name);
+uint16_t brandCacheFilamentId(uint16_t vendorId, const String& externalId);
+void brandCacheStoreVendor(const String& name, uint16_t vendorId, bool persist = true);
+void brandCacheStoreFilament(uint16_t vendorId, const String& externalId, uint16_t filamentId, bool persist = true);
+void brandCacheForgetVendor(const String& name);
+void brandCacheForgetFilament(uint16_t vendorId, const String& externalId);
+// By Spoolman id, for renamed or deleted vendors/filaments
+void brandCacheForgetVendorId(uint16_t vendorId);
+void brandCacheForgetFilamentId(uint16_t filamentId);
+bool brandCacheSave();
+String getBrandCacheStatsJson();
+
+#endif
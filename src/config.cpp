@@ -63,4 +63,10 @@ uint8_t mqttTaskPrio = 1;
 
 uint8_t scaleTaskCore = 0;
 uint8_t scaleTaskPrio = 1;
+
+uint8_t apiTaskCore = 1;
+uint8_t apiTaskPrio = 1;
+
+uint8_t spoolmanEventsTaskCore = 1;
+uint8_t spoolmanEventsTaskPrio = 1;
 // ***** Task Prios
@@ -8,9 +8,13 @@
 #define NVS_NAMESPACE_API                   "api"
 #define NVS_KEY_SPOOLMAN_URL                "spoolmanUrl"
 #define NVS_KEY_SPOOLMAN_INTERNAL_URL       "spoolmanIntUrl"
+#define NVS_KEY_SPOOLMAN_FIELDS_VERSION     "fieldsVer"     // Spoolman version the extra fields were verified on
+#define NVS_KEY_SPOOLMAN_FIELDS_FP          "fieldsFp"      // fingerprint of URL, version and field definitions
 #define NVS_KEY_OCTOPRINT_ENABLED           "octoEnabled"
 #define NVS_KEY_OCTOPRINT_URL               "octoUrl"
 #define NVS_KEY_OCTOPRINT_TOKEN             "octoToken"
+#define NVS_KEY_OCTOPRINT_TOOL              "octoTool"
+#define OCTOPRINT_DEFAULT_TOOL              "tool0"
 
 #define NVS_NAMESPACE_BAMBU                 "bambu"
 #define NVS_KEY_BAMBU_IP                    "bambuIp"
@@ -18,6 +22,18 @@
 #define NVS_KEY_BAMBU_SERIAL                "bambuSerial"
 #define NVS_KEY_BAMBU_AUTOSEND_ENABLE       "autosendEnable"
 #define NVS_KEY_BAMBU_AUTOSEND_TIME         "autosendTime"
+#define NVS_KEY_BAMBU_PERSISTENT            "persistent"    // stay connected instead of polling
+
+#define NVS_NAMESPACE_NFC                   "nfc"
+#define NVS_KEY_RC522_SPI_CLOCK             "spiClock"
+#define NVS_KEY_NFC_IDLE_POLL               "idlePoll"
+#define NVS_KEY_NFC_DETECT_TIMEOUT          "detectTimeout"
+#define NVS_KEY_NFC_SETTLE                  "settle"
+#define NVS_KEY_NFC_REMOVAL_POLL            "removalPoll"
+#define NVS_KEY_NFC_REMOVAL_MISSES          "removalMisses"
+#define NVS_KEY_NFC_SUSPEND_POLL            "suspendPoll"
+#define NVS_KEY_NFC_MIGRATE_DWELL           "migrateDwell"
+#define NVS_KEY_NFC_MIGRATE_MODE            "migrateMode"
 
 #define NVS_NAMESPACE_SCALE                 "scale"
 #define NVS_KEY_CALIBRATION                 "cal_value"
@@ -37,6 +53,75 @@
 #define WIFI_CHECK_INTERVAL                 60000U
 #define DISPLAY_UPDATE_INTERVAL             1000U
 #define SPOOLMAN_HEALTHCHECK_INTERVAL       60000U
+#define SPOOLMAN_HEALTH_IDLE_MS             45000UL // probe /health only without an answer for this long
+
+// Spoolman/OctoPrint API worker
+#define API_JOB_QUEUE_LENGTH                16U
+#define API_JOB_INTERACTIVE_RESERVE         4U      // queue slots only interactive jobs may use
+#define API_JOB_AGING_MS                    10000UL // a waiting job moves up one priority class per interval
+#define API_DEADLINE_INTERACTIVE_MS         30000UL
+#define API_DEADLINE_NORMAL_MS              300000UL
+#define API_DEADLINE_BACKGROUND_MS          60000UL
+#define API_BACKGROUND_TIMEOUT_MS           5000U   // single attempt for background requests
+#define API_CONNECTION_SLOTS                2U      // keep-alive pool: Spoolman + OctoPrint
+#define HTTP_POOL_MAX_HOSTS                 4U      // hosts with handshake statistics
+#define HTTP_POOL_IDLE_TIMEOUT_MS           60000UL // below the usual proxy keep-alive timeout (nginx: 75 s)
+#define HTTP_POOL_MIN_HEAP                  60000U  // close idle connections before a handshake below this
+#define API_JOB_MAX_ATTEMPTS                3U
+#define API_RETRY_DELAY_MS                  1000U
+#define API_FAILURE_DISPLAY_MS              2000U   // failure message stays up, the worker does not wait
+#define API_FUTURE_SWEEP_MS                 500U
+
+// Per upstream (Spoolman, OctoPrint): request timeout from the smoothed RTT, circuit breaker
+#define UPSTREAM_TIMEOUT_DEFAULT_MS         10000U  // until the first response has been timed
+#define UPSTREAM_TIMEOUT_MIN_MS             2500U   // a fresh TLS handshake must still fit
+#define UPSTREAM_TIMEOUT_MAX_MS             10000U
+
+// Per workflow step: the interactive queue deadline plus one job that started just before it,
+// every attempt with connect and response timeout and the pauses in between
+#define API_JOB_MAX_RUN_MS                  (API_JOB_MAX_ATTEMPTS * 2UL * UPSTREAM_TIMEOUT_MAX_MS + \
+                                             (API_JOB_MAX_ATTEMPTS - 1) * (unsigned long)API_RETRY_DELAY_MS)
+#define API_STEP_TIMEOUT_MS                 (API_DEADLINE_INTERACTIVE_MS + API_JOB_MAX_RUN_MS + 5000UL)
+#define UPSTREAM_BREAKER_FAILURES           3U      // consecutive failed attempts that open the breaker
+#define UPSTREAM_BREAKER_OPEN_MS            15000UL // first cool-down, doubled after each failed probe
+#define UPSTREAM_BREAKER_OPEN_MAX_MS        120000UL
+#define SPOOLMAN_ENDPOINT_MAX               2U      // internal + external URL
+#define SPOOLMAN_ENDPOINT_HYSTERESIS_PCT    25U     // switch only to an endpoint this much faster
+
+// Offline mode: write-ahead log of Spoolman updates and local spool mirror (LittleFS)
+#define OFFLINE_LOG_FILE                    "/spoolman_wal.jsonl"
+#define OFFLINE_MIRROR_FILE                 "/spool_mirror.json"
+#define OFFLINE_LOG_MAX_ENTRIES             256U
+#define OFFLINE_MIRROR_MAX_SPOOLS           64U
+
+// Spool cache for AMS assignment and weighing
+#define SPOOL_CACHE_SIZE                    16U
+#define SPOOL_CACHE_REFRESH_MS              300000UL
+#define SPOOL_WEIGHT_TOLERANCE_G            2U
+
+// Vendor/filament lookup for brand filament onboarding
+#define BRAND_CACHE_FILE                    "/brand_cache.json"
+#define BRAND_CACHE_MAX_ENTRIES             256U
+#define BRAND_CACHE_PAGE_SIZE               50U
+
+// Spoolman change events (websocket), replaces /health polling while connected
+#define SPOOLMAN_EVENTS_RECONNECT_MS        10000U
+#define SPOOLMAN_EVENTS_PING_MS             15000U
+#define SPOOLMAN_EVENTS_PONG_TIMEOUT_MS     5000U
+#define SPOOLMAN_EVENTS_MIN_HEAP            60000U  // same margin as the HTTPS health check
+
+// NFC scan state machine defaults (overridable in NVS, namespace "nfc")
+#define NFC_SCAN_IDLE_POLL_MS               50U
+#define NFC_SCAN_DETECT_TIMEOUT_MS          250U
+#define NFC_SCAN_SETTLE_MS                  20U
+#define NFC_SCAN_REMOVAL_POLL_MS            100U
+#define NFC_SCAN_REMOVAL_MISSES             2U
+#define NFC_SCAN_SUSPEND_POLL_MS            250U
+#define NFC_MIGRATE_DWELL_MS                1500U
+#define NFC_RETRY_BACKOFF_MS                3000UL  // tag left on the reader after a failed API call, doubled per retry
+#define NFC_RETRY_MAX                       3U      // then it is only processed again after removal
+#define NFC_MIGRATE_RETRY_MS                600000UL
+#define NFC_MIGRATE_HISTORY                 8
 
 extern const uint8_t PN532_IRQ;
 extern const uint8_t PN532_RESET;
@@ -44,6 +129,10 @@ extern const uint8_t PN532_RESET;
 #ifdef USE_RC522
 extern const uint8_t RC522_SS_PIN;
 extern const uint8_t RC522_RST_PIN;
+
+#define RC522_SPI_CLOCK_DEFAULT             4000000UL   // MFRC522 library default
+#define RC522_SPI_CLOCK_MIN                 1000000UL
+#define RC522_SPI_CLOCK_MAX                 10000000UL  // RC522 datasheet limit
 #endif
 
 extern const uint8_t LOADCELL_DOUT_PIN;
@@ -86,5 +175,11 @@ extern uint8_t mqttTaskPrio;
 extern uint8_t scaleTaskCore;
 extern uint8_t scaleTaskPrio;
 
+extern uint8_t apiTaskCore;
+extern uint8_t apiTaskPrio;
+
+extern uint8_t spoolmanEventsTaskCore;
+extern uint8_t spoolmanEventsTaskPrio;
+
 extern uint16_t defaultScaleCalibrationValue;
 #endif
\ No newline at end of file
@@ -6,6 +6,7 @@
 bool wifiOn = false;
 bool iconToggle = false;
 bool displayInitialized = false;
+static volatile unsigned long messageHeldUntil = 0;
 void setupDisplay() {
     // Stub
 }
@@ -36,3 +37,9 @@ void oledShowTopRow() {
 void oledShowIcon(const char* icon) {
     // Stub
 }
+void oledHoldMessage(uint32_t durationMs) {
+    messageHeldUntil = millis() + durationMs;
+}
+bool oledMessageHeld() {
+    return messageHeldUntil != 0 && (long)(millis() - messageHeldUntil) < 0;
+}
@@ -19,5 +19,8 @@ void oledShowWeight(uint16_t weight);
 void oledShowMessage(const String &message, uint8_t size = 2);
 void oledShowTopRow();
 void oledShowIcon(const char* icon);
+// Keeps the current message up for durationMs, the main loop redraws the weight afterwards
+void oledHoldMessage(uint32_t durationMs);
+bool oledMessageHeld();
 
 #endif
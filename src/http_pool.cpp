@@ -0,0 +1,243 @@
+#include "http_pool.h"
+#include <WiFiClientSecure.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+// The connection is opened here instead of inside HTTPClient so the handshake
+// can be timed; HTTPClient then finds it connected and reuses it.
+//
+// Note: TLS session resumption would also save the handshake after the server
+// closed an idle connection, but WiFiClientSecure does not expose the mbedTLS
+// session, so keep-alive is the only lever we have.
+
+struct PooledConnection {
+    String origin;          // scheme://host:port
+    WiFiClient* client;
+    bool busy;
+    unsigned long lastUsed;
+};
+
+struct HostHandshakeStats {
+    String origin;
+    uint32_t handshakes;
+    uint32_t failures;
+    uint32_t reused;
+    uint32_t lastMs;
+    uint32_t maxMs;
+    uint32_t totalMs;
+};
+
+static PooledConnection pool[API_CONNECTION_SLOTS];
+static HostHandshakeStats hostStats[HTTP_POOL_MAX_HOSTS];
+static uint8_t nextHostStatsSlot = 0;
+static uint32_t poolFallbacks = 0;
+static SemaphoreHandle_t poolMutex = NULL;
+
+class PoolLock {
+public:
+    PoolLock() { if (poolMutex) xSemaphoreTake(poolMutex, portMAX_DELAY); }
+    ~PoolLock() { if (poolMutex) xSemaphoreGive(poolMutex); }
+};
+
+// Once at startup, before the first request leases a connection
+void initHttpPool() {
+    if (poolMutex == NULL) poolMutex = xSemaphoreCreateMutex();
+}
+
+static String originOf(const String& url) {
+    int schemeEnd = url.indexOf("://");
+    if (schemeEnd == -1) return url;
+    int pathStart = url.indexOf('/', schemeEnd + 3);
+    return (pathStart == -1) ? url : url.substring(0, pathStart);
+}
+
+static bool parseOrigin(const String& origin, String& host, uint16_t& port) {
+    int schemeEnd = origin.indexOf("://");
+    if (schemeEnd == -1) return false;
+    bool secure = origin.startsWith("https://");
+
+    String authority = origin.substring(schemeEnd + 3);
+    int colon = authority.lastIndexOf(':');
+    if (colon != -1) {
+        host = authority.substring(0, colon);
+        port = authority.substring(colon + 1).toInt();
+    } else {
+        host = authority;
+        port = secure ? 443 : 80;
+    }
+    return host.length() > 0 && port > 0;
+}
+
+// Caller holds the lock
+static HostHandshakeStats& statsFor(const String& origin) {
+    for (uint8_t i = 0; i < HTTP_POOL_MAX_HOSTS; i++) {
+        if (hostStats[i].origin == origin) return hostStats[i];
+    }
+    HostHandshakeStats& stats = hostStats[nextHostStatsSlot];
+    nextHostStatsSlot = (nextHostStatsSlot + 1) % HTTP_POOL_MAX_HOSTS;
+    stats = HostHandshakeStats();
+    stats.origin = origin;
+    return stats;
+}
+
+// Idle slot for the origin, otherwise a free or least recently used idle slot
+// that gets a new client. Caller holds the lock.
+static PooledConnection* acquireSlot(const String& origin) {
+    PooledConnection* victim = nullptr;
+    for (uint8_t i = 0; i < API_CONNECTION_SLOTS; i++) {
+        PooledConnection& slot = pool[i];
+        if (slot.busy) continue;
+        if (slot.client != nullptr && slot.origin == origin) {
+            slot.busy = true;
+            return &slot;
+        }
+        if (victim == nullptr || slot.client == nullptr ||
+            (victim->client != nullptr && slot.lastUsed < victim->lastUsed)) {
+            victim = &slot;
+        }
+    }
+    if (victim == nullptr) return nullptr;
+
+    if (victim->client != nullptr) {
+        Serial.println("HTTP pool: closing connection to " + victim->origin);
+        victim->client->stop();
+        delete victim->client;
+    }
+    if (origin.startsWith("https://")) {
+        WiFiClientSecure* secureClient = new WiFiClientSecure();
+        secureClient->setInsecure();
+        victim->client = secureClient;
+    } else {
+        victim->client = new WiFiClient();
+    }
+    victim->origin = origin;
+    victim->busy = true;
+    return victim;
+}
+
+// Each idle TLS connection holds its buffers, make room before the next handshake
+static void closeIdleConnections(const WiFiClient* except) {
+    PoolLock lock;
+    for (uint8_t i = 0; i < API_CONNECTION_SLOTS; i++) {
+        if (!pool[i].busy && pool[i].client != nullptr && pool[i].client != except && pool[i].client->connected()) {
+            pool[i].client->stop();
+        }
+    }
+}
+
+bool httpPoolBegin(HTTPClient& http, const String& url, WiFiClient*& lease) {
+    String origin = originOf(url);
+    String host;
+    uint16_t port = 0;
+    lease = nullptr;
+
+    if (parseOrigin(origin, host, port)) {
+        PoolLock lock;
+        PooledConnection* slot = acquireSlot(origin);
+        if (slot != nullptr) lease = slot->client;
+    }
+
+    if (lease == nullptr) {
+        poolFallbacks++;
+        http.setReuse(false);
+        return http.begin(url);
+    }
+
+    if (lease->connected()) {
+        PoolLock lock;
+        statsFor(origin).reused++;
+    } else {
+        bool secure = origin.startsWith("https://");
+        if (secure && ESP.getFreeHeap() < HTTP_POOL_MIN_HEAP) closeIdleConnections(lease);
+
+        unsigned long start = millis();
+        bool connected = lease->connect(host.c_str(), port);
+        uint32_t elapsed = millis() - start;
+
+        PoolLock lock;
+        HostHandshakeStats& stats = statsFor(origin);
+        if (connected) {
+            stats.handshakes++;
+            stats.lastMs = elapsed;
+            stats.totalMs += elapsed;
+            if (elapsed > stats.maxMs) stats.maxMs = elapsed;
+            Serial.printf("HTTP pool: %s to %s in %u ms\n", secure ? "TLS handshake" : "connected",
+                          origin.c_str(), elapsed);
+        } else {
+            // HTTPClient retries the connect and reports the error to the caller
+            stats.failures++;
+        }
+    }
+
+    http.setReuse(true);
+    if (!http.begin(*lease, url)) {
+        httpPoolEnd(http, lease, false);
+        lease = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void httpPoolEnd(HTTPClient& http, WiFiClient* lease, bool keep) {
+    http.end();
+    if (lease == nullptr) return;
+
+    PoolLock lock;
+    for (uint8_t i = 0; i < API_CONNECTION_SLOTS; i++) {
+        if (pool[i].client != lease) continue;
+        if (!keep) lease->stop();
+        pool[i].busy = false;
+        pool[i].lastUsed = millis();
+        return;
+    }
+}
+
+void httpPoolSweep() {
+    PoolLock lock;
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < API_CONNECTION_SLOTS; i++) {
+        PooledConnection& slot = pool[i];
+        if (slot.busy || slot.client == nullptr || !slot.client->connected()) continue;
+        if (now - slot.lastUsed >= HTTP_POOL_IDLE_TIMEOUT_MS) {
+            Serial.println("HTTP pool: closing idle connection to " + slot.origin);
+            slot.client->stop();
+        }
+    }
+}
+
+String getHttpPoolStatsJson() {
+    JsonDocument doc;
+    unsigned long now = millis();
+    {
+        PoolLock lock;
+        doc["fallbacks"] = poolFallbacks;
+
+        JsonArray slots = doc["slots"].to<JsonArray>();
+        for (uint8_t i = 0; i < API_CONNECTION_SLOTS; i++) {
+            if (pool[i].client == nullptr) continue;
+            JsonObject slot = slots.add<JsonObject>();
+            slot["origin"] = pool[i].origin;
+            slot["connected"] = (bool)pool[i].client->connected();
+            slot["busy"] = pool[i].busy;
+            slot["idleMs"] = now - pool[i].lastUsed;
+        }
+
+        JsonArray hosts = doc["hosts"].to<JsonArray>();
+        for (uint8_t i = 0; i < HTTP_POOL_MAX_HOSTS; i++) {
+            const HostHandshakeStats& stats = hostStats[i];
+            if (stats.origin.length() == 0) continue;
+            JsonObject host = hosts.add<JsonObject>();
+            host["origin"] = stats.origin;
+            host["handshakes"] = stats.handshakes;
+            host["failures"] = stats.failures;
+            host["reused"] = stats.reused;
+            host["lastMs"] = stats.lastMs;
+            host["avgMs"] = stats.handshakes > 0 ? stats.totalMs / stats.handshakes : 0;
+            host["maxMs"] = stats.maxMs;
+        }
+    }
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
@@ -0,0 +1,21 @@
+#ifndef HTTP_POOL_H
+#define HTTP_POOL_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+
+// Keep-alive connections to Spoolman/OctoPrint, shared by all tasks. A TLS
+// handshake costs more than a second and ~40 KB of heap, so every origin keeps
+// its connection open between requests. Handshake times are tracked per host.
+
+void initHttpPool();
+// Prepares http for url on a pooled connection, or on a one-shot connection if
+// every slot is busy. lease must be handed back to httpPoolEnd().
+bool httpPoolBegin(HTTPClient& http, const String& url, WiFiClient*& lease);
+// keep = false drops the connection (transport error, error status, body not read to the end)
+void httpPoolEnd(HTTPClient& http, WiFiClient* lease, bool keep);
+// Close connections that have been idle for HTTP_POOL_IDLE_TIMEOUT_MS
+void httpPoolSweep();
+String getHttpPoolStatsJson();
+
+#endif
@@ -136,6 +136,8 @@ int16_t lastWeight = 0;
 unsigned long lastWifiCheckTime = 0;
 unsigned long lastTopRowUpdateTime = 0;
 unsigned long lastSpoolmanHealcheckTime = 0;
+uint32_t lastSpoolmanHealthVersion = 0;
+unsigned long lastSpoolCacheRefreshTime = 0;
 
 // Button debounce variables
 unsigned long lastButtonPress = 0;
@@ -167,17 +169,31 @@ void loop() {
     oledShowTopRow();
   }
 
-  // Periodic spoolman health check
+  // Spoolman health changes come from the API worker, publish them here
+  if (spoolmanHealthVersion() != lastSpoolmanHealthVersion)
+  {
+    lastSpoolmanHealthVersion = spoolmanHealthVersion();
+    oledShowTopRow();
+    sendSpoolmanHealth();
+  }
+
+  // Periodic spoolman health check (probe only, skipped while requests are answered)
   if (intervalElapsed(currentMillis, lastSpoolmanHealcheckTime, SPOOLMAN_HEALTHCHECK_INTERVAL)) 
   {
     // Only check Spoolman if we are not desperately trying to connect to Bambu
     if (bambuDisabled || bambu_connected) {
-      checkSpoolmanInstance();
+      scheduleSpoolmanHealthCheck();
     } else {
       Serial.println("Skipping Spoolman check while Bambu is reconnecting");
     }
   }
 
+  // Background refresh of cached spools (AMS auto-assign reads from the cache)
+  if (intervalElapsed(currentMillis, lastSpoolCacheRefreshTime, SPOOL_CACHE_REFRESH_MS / 4)) 
+  {
+    refreshSpoolCache();
+  }
+
   // Periodic Bambu health check - Restart task if it died (e.g. due to WiFi loss)
   static unsigned long lastBambuCheckTime = 0;
   if (intervalElapsed(currentMillis, lastBambuCheckTime, 30000)) 
@@ -246,8 +262,8 @@ void loop() {
   else 
   {
     // Ausgabe der Waage auf Display
-    // Block weight display during NFC write operations
-    if(pauseMainTask == 0 && !nfcWriteInProgress)
+    // Block weight display during NFC write operations and while a failure is shown
+    if(pauseMainTask == 0 && !nfcWriteInProgress && !oledMessageHeld())
     {
       // Use filtered weight for smooth display, but still check API weight for significant changes
       int16_t displayWeight = getFilteredDisplayWeight();
@@ -289,7 +305,7 @@ void loop() {
     lastWeight = weight;
 
     // Wenn ein Tag mit SM id erkannte wurde und der Waage Counter anspricht an SM Senden
-    if (activeSpoolId != "" && weightCounterToApi > 3 && weightSend == 0 && nfcReaderState == NFC_READ_SUCCESS && tagProcessed == false && spoolmanApiState == API_IDLE) 
+    if (activeSpoolId != "" && weightCounterToApi > 3 && weightSend == 0 && nfcReaderState == NFC_READ_SUCCESS && tagProcessed == false && !apiForegroundBusy()) 
     {
       // set the current tag as processed to prevent it beeing processed again
       tagProcessed = true;
@@ -303,10 +319,6 @@ void loop() {
         {
           autoSetToBambuSpoolId = activeSpoolId.toInt();
         }
-        if (octoEnabled) 
-        {
-          updateOctoSpoolId = activeSpoolId.toInt();
-        }
       }
       else
       {
@@ -316,7 +328,7 @@ void loop() {
     }
 
     // Handle successful tag write: Send weight to Spoolman but NEVER auto-send to Bambu
-    if (activeSpoolId != "" && weightCounterToApi > 3 && weightSend == 0 && nfcReaderState == NFC_WRITE_SUCCESS && tagProcessed == false && spoolmanApiState == API_IDLE) 
+    if (activeSpoolId != "" && weightCounterToApi > 3 && weightSend == 0 && nfcReaderState == NFC_WRITE_SUCCESS && tagProcessed == false && !apiForegroundBusy()) 
     {
       // set the current tag as processed to prevent it beeing processed again
       tagProcessed = true;
@@ -333,12 +345,6 @@ void loop() {
         vTaskDelay(2000 / portTICK_PERIOD_MS);
       }
     }
-
-    if(octoEnabled && sendOctoUpdate && spoolmanApiState == API_IDLE)
-    {
-      updateSpoolOcto(updateOctoSpoolId);
-      sendOctoUpdate = false;
-    }
   }
   
   esp_task_wdt_reset();
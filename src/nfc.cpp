@@ -9,6 +9,7 @@
 #define PN532_MIFARE_ISO14443A 0x00
 #endif
 #include <ArduinoJson.h>
+#include <Preferences.h>
 #include <deque>
 #include "config.h"
 #include "website.h"
@@ -17,6 +18,7 @@
 #include "scale.h"
 #include "bambu.h"
 #include "main.h"
+#include "spool_tag.h"
 
 namespace {
 constexpr bool kNfcDiagnosticsEnabled = false; // set true when debugging NFC; keep false to let MQTT logs show
@@ -39,6 +41,49 @@ static bool rc522Verbose = kNfcDiagnosticsEnabled;
 static bool rc522MeasureTiming = kNfcDiagnosticsEnabled;
 // Count consecutive invalid VersionReg readings before forcing hardware recovery
 static int rc522ConsecutiveInvalid = 0;
+
+// ***** SPI clock
+// Read by the MFRC522 library on every SPI transaction (MFRC522_SPICLOCK in platformio.ini).
+volatile uint32_t rc522SpiClockHz = RC522_SPI_CLOCK_DEFAULT;
+
+// Fallback ladder: the configured clock is snapped to the highest step not above it,
+// and the driver walks down one step whenever the transfer error rate gets too high.
+// After a run of error-free windows it walks back up, at most to the configured clock.
+static const uint32_t rc522ClockSteps[] = { 10000000UL, 8000000UL, 6000000UL, 4000000UL, 2000000UL, 1000000UL };
+static const uint8_t RC522_CLOCK_STEP_COUNT = sizeof(rc522ClockSteps) / sizeof(rc522ClockSteps[0]);
+static const uint16_t RC522_CLOCK_WINDOW = 32;          // transfers per evaluation window
+static const uint8_t RC522_CLOCK_MAX_ERROR_PERCENT = 20; // step down above this error rate
+static const uint8_t RC522_CLOCK_CLEAN_WINDOWS = 8;      // error-free windows before stepping up again
+
+struct Rc522ClockStats {
+  uint32_t transfers;
+  uint32_t crcErrors;
+  uint32_t collisions;
+  uint32_t timeouts;
+};
+
+static Rc522ClockStats rc522ClockStats[RC522_CLOCK_STEP_COUNT];
+static uint32_t rc522ConfiguredClockHz = RC522_SPI_CLOCK_DEFAULT;
+static uint8_t rc522ClockStep = 3;
+static uint16_t rc522WindowTransfers = 0;
+static uint16_t rc522WindowErrors = 0;
+static uint8_t rc522CleanWindows = 0;
+
+static uint8_t rc522ClockStepFor(uint32_t clockHz) {
+  for (uint8_t i = 0; i < RC522_CLOCK_STEP_COUNT; i++) {
+    if (rc522ClockSteps[i] <= clockHz) return i;
+  }
+  return RC522_CLOCK_STEP_COUNT - 1;
+}
+
+static void rc522ApplyClockStep(uint8_t step) {
+  rc522ClockStep = step;
+  rc522SpiClockHz = rc522ClockSteps[step];
+  rc522WindowTransfers = 0;
+  rc522WindowErrors = 0;
+  rc522CleanWindows = 0;
+}
+// ***** SPI clock
 #endif
 
 class Rc522Nfc {
@@ -46,7 +91,8 @@ class Rc522Nfc {
     void begin() {
       // AMSPlusCore approach: Initialize SPI first, then RC522 module.
       // Use explicit pins: CLK=18, MISO=19, MOSI=23, SS=RC522_SS_PIN
-      Serial.println("RC522: Initializing SPI (CLK=18, MISO=19, MOSI=23, SS=5)...");
+      loadSpiClock();
+      Serial.printf("RC522: Initializing SPI (CLK=18, MISO=19, MOSI=23, SS=5) at %lu Hz...\n", (unsigned long)rc522SpiClockHz);
       SPI.begin(18, 19, 23, RC522_SS_PIN);
       delay(100);  // Allow time for SPI to stabilize
       
@@ -94,6 +140,67 @@ class Rc522Nfc {
       Serial.println("RC522 initialization complete");
     }
 
+    void loadSpiClock() {
+      Preferences preferences;
+      preferences.begin(NVS_NAMESPACE_NFC, true);
+      uint32_t clockHz = preferences.getULong(NVS_KEY_RC522_SPI_CLOCK, RC522_SPI_CLOCK_DEFAULT);
+      preferences.end();
+
+      rc522ConfiguredClockHz = constrain(clockHz, RC522_SPI_CLOCK_MIN, RC522_SPI_CLOCK_MAX);
+      rc522ApplyClockStep(rc522ClockStepFor(rc522ConfiguredClockHz));
+    }
+
+    // Book-keeping for the SPI clock fallback. "recovered" tells whether a failed
+    // first attempt succeeded on retry: a timeout that persists is a tag leaving
+    // the field, a timeout that recovers points at a marginal link.
+    void noteTransferStatus(MFRC522::StatusCode firstStatus, bool recovered) {
+      Rc522ClockStats& stats = rc522ClockStats[rc522ClockStep];
+      stats.transfers++;
+      rc522WindowTransfers++;
+
+      bool linkError = false;
+      switch (firstStatus) {
+        case MFRC522::STATUS_CRC_WRONG:
+          stats.crcErrors++;
+          linkError = true;
+          break;
+        case MFRC522::STATUS_COLLISION:
+          stats.collisions++;
+          linkError = true;
+          break;
+        case MFRC522::STATUS_TIMEOUT:
+          stats.timeouts++;
+          linkError = recovered;
+          break;
+        default:
+          break;
+      }
+      if (linkError) rc522WindowErrors++;
+
+      if (rc522WindowTransfers < RC522_CLOCK_WINDOW) return;
+
+      bool tooManyErrors = (uint32_t)rc522WindowErrors * 100U > (uint32_t)rc522WindowTransfers * RC522_CLOCK_MAX_ERROR_PERCENT;
+      if (tooManyErrors && rc522ClockStep + 1 < RC522_CLOCK_STEP_COUNT) {
+        Serial.printf("RC522: %u/%u transfer errors at %lu Hz, stepping SPI clock down to %lu Hz\n",
+                      rc522WindowErrors, rc522WindowTransfers,
+                      (unsigned long)rc522ClockSteps[rc522ClockStep], (unsigned long)rc522ClockSteps[rc522ClockStep + 1]);
+        rc522ApplyClockStep(rc522ClockStep + 1);
+        return;
+      }
+
+      // A burst of errors (tag pulled mid-read) must not pin the clock low until reboot
+      rc522CleanWindows = (rc522WindowErrors == 0) ? rc522CleanWindows + 1 : 0;
+      if (rc522CleanWindows >= RC522_CLOCK_CLEAN_WINDOWS && rc522ClockStep > rc522ClockStepFor(rc522ConfiguredClockHz)) {
+        Serial.printf("RC522: %u clean windows at %lu Hz, stepping SPI clock up to %lu Hz\n",
+                      rc522CleanWindows, (unsigned long)rc522ClockSteps[rc522ClockStep], (unsigned long)rc522ClockSteps[rc522ClockStep - 1]);
+        rc522ApplyClockStep(rc522ClockStep - 1);
+        return;
+      }
+      if (rc522CleanWindows >= RC522_CLOCK_CLEAN_WINDOWS) rc522CleanWindows = 0;
+      rc522WindowTransfers = 0;
+      rc522WindowErrors = 0;
+    }
+
     void dumpRegisters(const char* ctx) {
       // Print a small set of RC522 registers for diagnostics
       MFRC522::PCD_Register regs[] = { MFRC522::VersionReg, MFRC522::CommandReg, MFRC522::ErrorReg, MFRC522::FIFOLevelReg, MFRC522::CollReg, MFRC522::DivIrqReg, MFRC522::ComIEnReg };
@@ -248,6 +355,7 @@ class Rc522Nfc {
       uint8_t tmp[18];
       uint8_t size = sizeof(tmp);
       MFRC522::StatusCode status = rfid.MIFARE_Read(page, tmp, &size);
+      const MFRC522::StatusCode firstStatus = status;
       
       // Simple retry logic if read fails
       if (status != MFRC522::STATUS_OK) {
@@ -259,8 +367,10 @@ class Rc522Nfc {
              // Serial.println("Card re-selected during read retry");
         }
 
+        size = sizeof(tmp);
         status = rfid.MIFARE_Read(page, tmp, &size);
       }
+      noteTransferStatus(firstStatus, status == MFRC522::STATUS_OK);
       
       if (status != MFRC522::STATUS_OK) {
         Serial.print("NTAG read error on page ");
@@ -276,6 +386,24 @@ class Rc522Nfc {
       return true;
     }
 
+    // One READ command returns 4 pages. Single attempt, the caller decides how to recover.
+    bool ntag2xx_ReadBlock(uint8_t page, uint8_t* buffer) {
+      if (rfid.uid.size == 0) {
+        return false;
+      }
+
+      uint8_t tmp[18];
+      uint8_t size = sizeof(tmp);
+      MFRC522::StatusCode status = rfid.MIFARE_Read(page, tmp, &size);
+      noteTransferStatus(status, false);
+      if (status != MFRC522::STATUS_OK) {
+        return false;
+      }
+
+      memcpy(buffer, tmp, 16);
+      return true;
+    }
+
     bool ntag2xx_WritePage(uint8_t page, uint8_t* data) {
       // Ensure a card is selected before writing. If the UID buffer is empty,
       // attempt to read the serial once. Avoid calling PICC_IsNewCardPresent().
@@ -286,6 +414,7 @@ class Rc522Nfc {
       }
       
       MFRC522::StatusCode status = rfid.MIFARE_Ultralight_Write(page, data, 4);
+      const MFRC522::StatusCode firstStatus = status;
       
       // Simple retry logic if write fails
       if (status != MFRC522::STATUS_OK) {
@@ -299,6 +428,7 @@ class Rc522Nfc {
 
         status = rfid.MIFARE_Ultralight_Write(page, data, 4);
       }
+      noteTransferStatus(firstStatus, status == MFRC522::STATUS_OK);
 
       if (status != MFRC522::STATUS_OK) {
         Serial.print("NTAG write error on page ");
@@ -347,14 +477,292 @@ class Rc522Nfc {
 };
 
 Rc522Nfc nfc;
+
+uint32_t getRc522SpiClock() {
+  return rc522SpiClockHz;
+}
+
+bool saveRc522SpiClock(uint32_t clockHz) {
+  if (clockHz < RC522_SPI_CLOCK_MIN || clockHz > RC522_SPI_CLOCK_MAX) {
+    Serial.printf("RC522: SPI clock %lu Hz out of range\n", (unsigned long)clockHz);
+    return false;
+  }
+
+  Preferences preferences;
+  preferences.begin(NVS_NAMESPACE_NFC, false);
+  preferences.putULong(NVS_KEY_RC522_SPI_CLOCK, clockHz);
+  preferences.end();
+
+  // Takes effect with the next SPI transaction
+  rc522ConfiguredClockHz = clockHz;
+  rc522ApplyClockStep(rc522ClockStepFor(clockHz));
+  Serial.printf("RC522: SPI clock set to %lu Hz\n", (unsigned long)rc522SpiClockHz);
+  return true;
+}
+
+String getRc522SpiClockStatsJson() {
+  JsonDocument doc;
+  doc["configured"] = rc522ConfiguredClockHz;
+  doc["active"] = (uint32_t)rc522SpiClockHz;
+  JsonArray steps = doc["steps"].to<JsonArray>();
+  for (uint8_t i = 0; i < RC522_CLOCK_STEP_COUNT; i++) {
+    const Rc522ClockStats& stats = rc522ClockStats[i];
+    if (stats.transfers == 0) continue;
+    JsonObject step = steps.add<JsonObject>();
+    step["clock"] = rc522ClockSteps[i];
+    step["transfers"] = stats.transfers;
+    step["crc"] = stats.crcErrors;
+    step["collision"] = stats.collisions;
+    step["timeout"] = stats.timeouts;
+  }
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
 #endif
 
 TaskHandle_t RfidReaderTask;
 
+// Complete page image of an NDEF message (TLV + MIME record + terminator) as it
+// goes to the tag starting at page 4. Built once when a write is queued.
+struct NdefImage {
+  uint8_t* data;       // padded to whole pages
+  uint16_t length;     // multiple of 4
+  uint16_t tlvLength;  // bytes the message needs on the tag (without padding)
+};
+
+struct NdefCapacityClass {
+  const char* name;
+  uint16_t userBytes;
+};
+
+static const NdefCapacityClass ndefCapacityClasses[] = {
+  { "NTAG213", 144 },
+  { "NTAG215", 504 },
+  { "NTAG216", 888 },
+};
+
+static const char* ndefCapacityClassName(uint16_t tlvLength) {
+  for (const NdefCapacityClass& cls : ndefCapacityClasses) {
+    if (tlvLength <= cls.userBytes) {
+      return cls.name;
+    }
+  }
+  return "none";
+}
+
+static uint16_t ndefMaxCapacity() {
+  return ndefCapacityClasses[(sizeof(ndefCapacityClasses) / sizeof(ndefCapacityClasses[0])) - 1].userBytes;
+}
+
+// Payload checksum, stored as NDEF record ID "C" + 4 hex digits (CRC-16/CCITT-FALSE)
+static const char NDEF_CRC_ID_PREFIX = 'C';
+static const uint8_t NDEF_CRC_ID_LENGTH = 5;
+
+static uint16_t ndefCrc16(const uint8_t* data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+// Position of the first record of the NDEF message TLV inside a buffer that starts at page 4
+struct NdefRecordLayout {
+  uint16_t recordOffset;   // record header
+  uint16_t typeOffset;
+  uint8_t typeLength;
+  uint16_t payloadOffset;
+  uint32_t payloadLength;
+  uint16_t messageEnd;     // first byte after the NDEF message (terminator TLV)
+  bool hasCrc;
+  uint16_t crc;
+};
+
+// Offset of the NDEF message TLV, skipping NULL and lock/memory control TLVs
+// in front of it. -1 if not found within the first 16 bytes.
+static int ndefFindMessageTlv(const uint8_t* data, uint16_t available) {
+  uint16_t i = 0;
+  while (i < available && i < 16) {
+    if (data[i] == 0x03) return i;
+    if (data[i] == 0x00) {
+      i++;
+      continue;
+    }
+    if (data[i] == 0xFE || i + 1 >= available) return -1;
+    i += 2 + data[i + 1];
+  }
+  return -1;
+}
+
+// Bytes from page 4 up to and including the terminator TLV, 0 if the TLV header is not readable yet
+static uint16_t ndefMessageSpan(const uint8_t* data, uint16_t available) {
+  int tlvOffset = ndefFindMessageTlv(data, available);
+  if (tlvOffset < 0 || tlvOffset + 4 > available) {
+    return 0;
+  }
+  if (data[tlvOffset + 1] != 0xFF) {
+    return tlvOffset + 2 + data[tlvOffset + 1] + 1;
+  }
+  return tlvOffset + 4 + ((data[tlvOffset + 2] << 8) | data[tlvOffset + 3]) + 1;
+}
+
+// Parses TLV and record header. Returns false if the header is malformed or not yet
+// complete within `available` bytes. The payload itself may still be incomplete.
+static bool parseNdefRecordHeader(const uint8_t* data, uint16_t available, NdefRecordLayout& layout) {
+  int tlvOffset = ndefFindMessageTlv(data, available);
+  if (tlvOffset < 0 || tlvOffset + 4 > available) {
+    return false;
+  }
+
+  uint16_t messageLength;
+  if (data[tlvOffset + 1] == 0xFF) {
+    messageLength = (data[tlvOffset + 2] << 8) | data[tlvOffset + 3];
+    layout.recordOffset = tlvOffset + 4;
+  } else {
+    messageLength = data[tlvOffset + 1];
+    layout.recordOffset = tlvOffset + 2;
+  }
+  layout.messageEnd = layout.recordOffset + messageLength;
+  if (layout.recordOffset >= available) {
+    return false;
+  }
+
+  const uint8_t header = data[layout.recordOffset];
+  const bool shortRecord = header & 0x10;
+  const bool hasIdLength = header & 0x08;
+  uint16_t offset = layout.recordOffset + 1;
+  if (offset + 1 + (shortRecord ? 1 : 4) + (hasIdLength ? 1 : 0) > available) {
+    return false;
+  }
+
+  layout.typeLength = data[offset++];
+  if (shortRecord) {
+    layout.payloadLength = data[offset++];
+  } else {
+    layout.payloadLength = ((uint32_t)data[offset] << 24) | ((uint32_t)data[offset + 1] << 16) |
+                           ((uint32_t)data[offset + 2] << 8) | data[offset + 3];
+    offset += 4;
+  }
+  uint8_t idLength = hasIdLength ? data[offset++] : 0;
+
+  layout.typeOffset = offset;
+  uint16_t idOffset = offset + layout.typeLength;
+  layout.payloadOffset = idOffset + idLength;
+  if (layout.payloadOffset > layout.messageEnd || layout.payloadLength > (uint32_t)(layout.messageEnd - layout.payloadOffset)) {
+    return false;
+  }
+
+  layout.hasCrc = false;
+  layout.crc = 0;
+  if (idLength == NDEF_CRC_ID_LENGTH && idOffset + idLength <= available && data[idOffset] == NDEF_CRC_ID_PREFIX) {
+    char hex[5];
+    memcpy(hex, &data[idOffset + 1], 4);
+    hex[4] = '\0';
+    char* end = NULL;
+    unsigned long crc = strtoul(hex, &end, 16);
+    if (end == hex + 4) {
+      layout.hasCrc = true;
+      layout.crc = (uint16_t)crc;
+    }
+  }
+  return true;
+}
+
+// Header and payload lie completely within `available` bytes. Corrupted TLV or
+// payload lengths must not send the CRC check past the end of the buffer.
+static bool parseNdefRecordLayout(const uint8_t* data, uint16_t available, NdefRecordLayout& layout) {
+  if (!parseNdefRecordHeader(data, available, layout)) {
+    return false;
+  }
+  return layout.payloadOffset <= available && layout.payloadLength <= (uint32_t)(available - layout.payloadOffset);
+}
+
+static bool ndefPayloadCrcValid(const uint8_t* data, const NdefRecordLayout& layout) {
+  return ndefCrc16(&data[layout.payloadOffset], layout.payloadLength) == layout.crc;
+}
+
+// Builds the NDEF page image for a JSON payload. Payloads above 255 bytes use a
+// long record (4 byte payload length), above 254 record bytes the 3 byte TLV length.
+// The record ID holds the payload CRC.
+// Returns false if the message does not fit on the largest supported tag; the
+// required size is reported in tlvLength either way.
+static bool buildNdefImage(const String& json, NdefImage& image) {
+  static const char mimeType[] = "application/json";
+  const uint8_t mimeTypeLen = sizeof(mimeType) - 1;
+  const uint32_t payloadLen = json.length();
+
+  const bool shortRecord = payloadLen <= 0xFF;
+  const uint32_t recordSize = 2 + (shortRecord ? 1 : 4) + 1 + mimeTypeLen + NDEF_CRC_ID_LENGTH + payloadLen;
+  const uint8_t tlvHeaderSize = (recordSize < 0xFF) ? 2 : 4;
+  const uint32_t tlvLength = tlvHeaderSize + recordSize + 1; // +1 terminator TLV
+
+  image.data = NULL;
+  image.length = 0;
+  image.tlvLength = (tlvLength > 0xFFFF) ? 0xFFFF : (uint16_t)tlvLength;
+
+  if (tlvLength > ndefMaxCapacity()) {
+    return false;
+  }
+
+  image.length = (uint16_t)((tlvLength + 3) & ~3U);
+  image.data = (uint8_t*)calloc(image.length, 1);
+  if (image.data == NULL) {
+    image.length = 0;
+    return false;
+  }
+
+  uint16_t offset = 0;
+  image.data[offset++] = 0x03; // NDEF Message TLV
+  if (tlvHeaderSize == 2) {
+    image.data[offset++] = (uint8_t)recordSize;
+  } else {
+    image.data[offset++] = 0xFF;
+    image.data[offset++] = (uint8_t)(recordSize >> 8);
+    image.data[offset++] = (uint8_t)(recordSize & 0xFF);
+  }
+
+  if (shortRecord) {
+    image.data[offset++] = 0xDA; // MB + ME + SR + IL, TNF=0x2 (MIME Media)
+    image.data[offset++] = mimeTypeLen;
+    image.data[offset++] = (uint8_t)payloadLen;
+  } else {
+    image.data[offset++] = 0xCA; // MB + ME + IL, TNF=0x2 (MIME Media), long record
+    image.data[offset++] = mimeTypeLen;
+    image.data[offset++] = (uint8_t)(payloadLen >> 24);
+    image.data[offset++] = (uint8_t)(payloadLen >> 16);
+    image.data[offset++] = (uint8_t)(payloadLen >> 8);
+    image.data[offset++] = (uint8_t)(payloadLen & 0xFF);
+  }
+  image.data[offset++] = NDEF_CRC_ID_LENGTH;
+
+  memcpy(&image.data[offset], mimeType, mimeTypeLen);
+  offset += mimeTypeLen;
+
+  // Record ID carries the payload CRC so readers can validate in one pass
+  char crcId[NDEF_CRC_ID_LENGTH + 1];
+  snprintf(crcId, sizeof(crcId), "%c%04X", NDEF_CRC_ID_PREFIX,
+           ndefCrc16((const uint8_t*)json.c_str(), payloadLen));
+  memcpy(&image.data[offset], crcId, NDEF_CRC_ID_LENGTH);
+  offset += NDEF_CRC_ID_LENGTH;
+
+  memcpy(&image.data[offset], json.c_str(), payloadLen);
+  offset += payloadLen;
+  image.data[offset] = 0xFE; // Terminator TLV, rest of the last page stays 0x00
+
+  return true;
+}
+
 struct WriteQueueEntry {
   bool isSpoolTag;
-  char* payload;
+  NdefImage image;
   String spoolId;
+  bool cloneCopy;     // raw image from clone mode, no Spoolman update
+  String skipUid;     // tag that must not be written (clone source)
+  String onlyUid;     // if set, only this tag may be written (new brand spool)
 };
 
 static std::deque<WriteQueueEntry*> writeQueue;
@@ -368,8 +776,137 @@ static unsigned long amsReadWatchdogStartMs = 0;
 static unsigned long lastAmsSpoolReadEventMs = 0;
 static bool amsReadWatchdogArmed = false;
 
+// ***** Scan state machine
+typedef enum {
+  NFC_SCAN_IDLE,           // polling for a tag
+  NFC_SCAN_PRESENT,        // tag detected, RF field settling
+  NFC_SCAN_READING,        // fast-path or full read and decode
+  NFC_SCAN_PROCESSED,      // result published, tag released
+  NFC_SCAN_AWAIT_REMOVAL   // same UID is ignored until it leaves the field
+} nfcScanStateType;
+
+struct NfcScanTimings {
+  uint16_t idlePollMs;       // pause between detections while no tag is present
+  uint16_t detectTimeoutMs;  // readPassiveTargetID timeout per detection
+  uint16_t settleMs;         // RF settle time between detection and first page read
+  uint16_t removalPollMs;    // presence poll interval while awaiting removal
+  uint16_t removalMisses;    // consecutive misses before a tag counts as removed
+  uint16_t suspendPollMs;    // poll interval while reading is suspended
+  uint16_t migrateDwellMs;   // time a legacy tag has to rest on the reader before it is rewritten
+};
+
+static NfcScanTimings nfcScanTimings = {
+  NFC_SCAN_IDLE_POLL_MS,
+  NFC_SCAN_DETECT_TIMEOUT_MS,
+  NFC_SCAN_SETTLE_MS,
+  NFC_SCAN_REMOVAL_POLL_MS,
+  NFC_SCAN_REMOVAL_MISSES,
+  NFC_SCAN_SUSPEND_POLL_MS,
+  NFC_MIGRATE_DWELL_MS
+};
+
+struct NfcScanTimingKey {
+  const char* key;
+  uint16_t NfcScanTimings::*field;
+  uint16_t minValue;
+  uint16_t maxValue;
+};
+
+static const NfcScanTimingKey nfcScanTimingKeys[] = {
+  { NVS_KEY_NFC_IDLE_POLL,      &NfcScanTimings::idlePollMs,      10, 2000 },
+  { NVS_KEY_NFC_DETECT_TIMEOUT, &NfcScanTimings::detectTimeoutMs, 50, 2000 },
+  { NVS_KEY_NFC_SETTLE,         &NfcScanTimings::settleMs,        0,  1000 },
+  { NVS_KEY_NFC_REMOVAL_POLL,   &NfcScanTimings::removalPollMs,   10, 2000 },
+  { NVS_KEY_NFC_REMOVAL_MISSES, &NfcScanTimings::removalMisses,   1,  10   },
+  { NVS_KEY_NFC_SUSPEND_POLL,   &NfcScanTimings::suspendPollMs,   50, 5000 },
+  { NVS_KEY_NFC_MIGRATE_DWELL,  &NfcScanTimings::migrateDwellMs,  500, 30000 },
+};
+
+static nfcScanStateType nfcScanState = NFC_SCAN_IDLE;
+static volatile bool nfcScanHandoverPending = false;
+static String nfcScanHandoverUid = "";
+// ***** Scan state machine
+
+// ***** Retry after a failed API call
+// A failure resets nfcReaderState to NFC_IDLE while the tag may still be on the
+// reader. It is processed again after a growing pause, at most NFC_RETRY_MAX times.
+static String nfcRetryUid = "";
+static uint8_t nfcRetryCount = 0;
+static bool nfcRetryScheduled = false;
+static unsigned long nfcRetryAtMs = 0;
+
+static void clearTagRetry() {
+  nfcRetryUid = "";
+  nfcRetryCount = 0;
+  nfcRetryScheduled = false;
+}
+
+// True once a retry for the tag still on the reader is due
+static bool tagRetryDue(const String& uidString) {
+  if (nfcRetryUid != uidString) {
+    clearTagRetry();
+    nfcRetryUid = uidString;
+  }
+  if (nfcRetryCount >= NFC_RETRY_MAX) return false;
+
+  unsigned long now = millis();
+  if (!nfcRetryScheduled) {
+    nfcRetryAtMs = now + (NFC_RETRY_BACKOFF_MS << nfcRetryCount);
+    nfcRetryScheduled = true;
+    Serial.printf("Tag %s: retry %u/%u in %lu ms\n", uidString.c_str(), nfcRetryCount + 1,
+                  NFC_RETRY_MAX, NFC_RETRY_BACKOFF_MS << nfcRetryCount);
+  }
+  if ((long)(now - nfcRetryAtMs) < 0) return false;
+
+  nfcRetryCount++;
+  nfcRetryScheduled = false;
+  if (nfcRetryCount == NFC_RETRY_MAX) {
+    Serial.println("Last retry for this tag, remove it to try again");
+  }
+  return true;
+}
+
+// ***** Legacy tag migration
+struct NfcMigrateAttempt {
+  String uid;
+  unsigned long lastAttemptMs;
+};
+
+static nfcMigrateModeType nfcMigrateMode = NFC_MIGRATE_OFF;
+static NfcMigrateAttempt nfcMigrateHistory[NFC_MIGRATE_HISTORY];
+static String nfcMigrateUid = "";        // tag of the last full read that needs a rewrite
+static String nfcMigrateJson = "";       // its content in the target layout
+static String nfcMigrateOriginal = "";   // its content as read, for restoring on failure
+static unsigned long nfcMigrateReadyMs = 0;
+// Payload of the last decoded record as stored on the tag. nfcJsonData drops bytes
+// outside 0x20-0x7E on tags without CRC, a rewrite must never be built from that.
+static String nfcRawPayload = "";
+static bool nfcRawPayloadLossy = false;
+static uint16_t nfcMigrateDone = 0;
+static uint16_t nfcMigrateFailed = 0;
+// ***** Legacy tag migration
+
+// ***** Clone mode
+typedef enum {
+  NFC_CLONE_OFF,
+  NFC_CLONE_AWAIT_SOURCE,  // next tag is read as the source image
+  NFC_CLONE_ACTIVE         // every blank tag presented gets a copy of the image
+} nfcCloneStateType;
+
+static volatile nfcCloneStateType nfcCloneState = NFC_CLONE_OFF;
+// Owned by the scan task: start/stop only request its release, the scan task may
+// be copying from it in enqueueCloneCopy at the same time
+static NdefImage nfcCloneImage = { NULL, 0, 0 };
+static volatile bool nfcCloneReleasePending = false;
+static String nfcCloneSourceUid = "";
+static uint32_t nfcCloneReadMs = 0;
+static uint16_t nfcCloneCopies = 0;
+static uint16_t nfcCloneFailures = 0;
+static uint32_t nfcCloneBytes = 0;
+static uint32_t nfcCloneWriteMs = 0;
+// ***** Clone mode
+
 static void ensureWriteQueueInit();
-static String extractSmId(const char* payload);
 static size_t getWriteQueueSize();
 static String peekWriteQueueSmId();
 static void updateQueueLedState();
@@ -384,6 +921,8 @@ static bool handleAmsReadTimeout();
 static void tryQueueTagForAmsTray();
 
 JsonDocument rfidData;
+// Decoded content of the last tag read, shared by the whole read pipeline
+static SpoolTagRecord lastTagRecord;
 String activeSpoolId = "";
 String lastSpoolId = "";
 String nfcJsonData = "";
@@ -395,7 +934,11 @@ volatile bool nfcWriteInProgress = false; // Prevent any tag operations during w
 
 struct NfcWriteParameterType {
   bool tagType;
-  char* payload;
+  NdefImage image;
+  String spoolId;
+  bool cloneCopy;
+  String skipUid;
+  String onlyUid;
 };
 
 volatile nfcReaderStateType nfcReaderState = NFC_IDLE;
@@ -415,65 +958,25 @@ static void tryQueueTagForAmsTray() {
         Serial.println("tryQueueTagForAmsTray: No tag data available");
         return;
     }
-    
-    // Parse the JSON to extract filament data
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, nfcJsonData);
-    if (error) {
-        Serial.println("tryQueueTagForAmsTray: Failed to parse tag JSON");
-        return;
-    }
-    
-    // Extract filament information from tag
-    String manufacturer = "";  // Vendor/manufacturer (Bambu Lab, Sunlu, etc.)
-    String material = "";      // Material type (PLA, PETG, etc.)
-    String brandName = "";     // Product brand name (PLA Basic, Rapid PETG, etc.)
-    String color = "";
-    int dryingTemp = 0;
-    int dryingTime = 0;
-    int nozzle_temp_min = 0;
-    int nozzle_temp_max = 0;
+    const SpoolTagRecord& tag = lastTagRecord;
     
     // Format 1: Standard Filaman format with type, color_hex, brand, min_temp, max_temp
-    if (doc["type"].is<String>()) {
-        material = doc["type"].as<String>();
-    }
-    if (doc["color_hex"].is<String>()) {
-        color = doc["color_hex"].as<String>();
-        // Remove # prefix if present and ensure proper format
-        if (color.startsWith("#")) {
-            color = color.substring(1);
-        }
-    }
-    if (doc["brand"].is<String>()) {
-        manufacturer = doc["brand"].as<String>();  // In standard format, "brand" is manufacturer
-    }
-    if (doc["brand_name"].is<String>()) {
-        brandName = doc["brand_name"].as<String>();
-    }
-    if (doc["min_temp"].is<int>()) {
-        nozzle_temp_min = doc["min_temp"].as<int>();
-    }
-    if (doc["max_temp"].is<int>()) {
-        nozzle_temp_max = doc["max_temp"].as<int>();
-    }
-    if (doc["drying_temp"].is<int>()) {
-        dryingTemp = doc["drying_temp"].as<int>();
-    }
-    if (doc["drying_time"].is<int>()) {
-        dryingTime = doc["drying_time"].as<int>();
+    String manufacturer = tag.brand;   // Vendor/manufacturer (Bambu Lab, Sunlu, etc.)
+    String material = tag.type;        // Material type (PLA, PETG, etc.)
+    String color = tag.colorHex;
+    // Remove # prefix if present and ensure proper format
+    if (color.startsWith("#")) {
+        color = color.substring(1);
     }
     
     // Format 2: Brand filament format with b (brand), an (article name), etc.
-    if (material.length() == 0 && doc["an"].is<String>()) {
-        material = doc["an"].as<String>();  // article name might contain material type
+    if (material.length() == 0) {
+        material = tag.an;  // article name might contain material type
     }
-    if (manufacturer.length() == 0 && doc["b"].is<String>()) {
-        manufacturer = doc["b"].as<String>();
+    if (manufacturer.length() == 0) {
+        manufacturer = tag.b;
     }
     
-    doc.clear();
-    
     // Need at least material type to proceed
     if (material.length() == 0) {
         Serial.println("tryQueueTagForAmsTray: No material type found in tag data");
@@ -482,10 +985,10 @@ static void tryQueueTagForAmsTray() {
     
     // Queue the tag for AMS tray assignment
     Serial.println("Attempting to queue tag for AMS tray assignment:");
-    Serial.printf("  Manufacturer: %s, Material: %s, BrandName: %s\n", manufacturer.c_str(), material.c_str(), brandName.c_str());
-    Serial.printf("  Color: %s, Temps: %d-%d\n", color.c_str(), nozzle_temp_min, nozzle_temp_max);
+    Serial.printf("  Manufacturer: %s, Material: %s, BrandName: %s\n", manufacturer.c_str(), material.c_str(), tag.brandName.c_str());
+    Serial.printf("  Color: %s, Temps: %d-%d\n", color.c_str(), tag.minTemp, tag.maxTemp);
     
-    queueTagForTrayAssignment(nfcJsonData, manufacturer, material, brandName, color, dryingTemp, dryingTime, nozzle_temp_min, nozzle_temp_max);
+    queueTagForTrayAssignment(nfcJsonData, manufacturer, material, tag.brandName, color, tag.dryingTemp, tag.dryingTime, tag.minTemp, tag.maxTemp);
 }
 
 // ##### Funktionen für RFID #####
@@ -591,6 +1094,100 @@ bool robustPageRead(uint8_t page, uint8_t* buffer) {
     return false;
 }
 
+// Reads 4 pages with a single READ command and no retries
+static bool readTagBlock(uint8_t page, uint8_t* buffer) {
+#ifdef USE_RC522
+  return nfc.ntag2xx_ReadBlock(page, buffer);
+#else
+  uint8_t command[2] = { 0x30, page }; // NTAG READ
+  uint8_t response[32];
+  uint8_t responseLength = sizeof(response);
+  if (!nfc.inDataExchange(command, sizeof(command), response, &responseLength) || responseLength < 16) {
+    return false;
+  }
+  memcpy(buffer, response, 16);
+  return true;
+#endif
+}
+
+// Bytes still needed after `bytesRead` bytes of the message area have been read
+static uint16_t ndefBytesNeeded(const uint8_t* data, uint16_t bytesRead, uint16_t tagSize, uint8_t step) {
+  uint16_t span = ndefMessageSpan(data, bytesRead);
+  if (span == 0) {
+    // TLV header not complete yet: keep reading while it can still show up
+    span = (bytesRead < 16 || ndefFindMessageTlv(data, bytesRead) >= 0) ? bytesRead + step : bytesRead;
+  }
+  return min(span, tagSize);
+}
+
+// Reads the NDEF message area from page 4 on into a new buffer (caller frees).
+// First pass uses block reads without retries and is accepted when the payload
+// CRC matches, or the tag carries none. A failed transfer or CRC mismatch falls
+// back to one page-by-page pass with robustPageRead.
+static uint8_t* readNdefMessage(uint16_t tagSize, uint16_t& length) {
+  length = 0;
+  if (tagSize == 0) {
+    return NULL;
+  }
+
+  uint8_t* data = (uint8_t*)calloc((tagSize + 15) & ~15U, 1);
+  if (data == NULL) {
+    Serial.println("Could not allocate memory for tag read");
+    return NULL;
+  }
+
+  unsigned long readStart = millis();
+  uint16_t bytesRead = 0;
+  uint16_t needed = 16;
+  bool fastPassOk = true;
+  while (bytesRead < needed) {
+    if (!readTagBlock(4 + bytesRead / 4, data + bytesRead)) {
+      fastPassOk = false;
+      break;
+    }
+    bytesRead += 16;
+    needed = ndefBytesNeeded(data, bytesRead, tagSize, 16);
+  }
+
+  if (fastPassOk) {
+    NdefRecordLayout layout;
+    bool parsed = parseNdefRecordLayout(data, bytesRead, layout);
+    if (parsed && (!layout.hasCrc || ndefPayloadCrcValid(data, layout))) {
+      Serial.printf("NDEF read: %u bytes in %lu ms (block read%s)\n", bytesRead, millis() - readStart,
+                    layout.hasCrc ? ", CRC ok" : "");
+      length = bytesRead;
+      return data;
+    }
+    Serial.println(parsed ? "NDEF block read: payload CRC mismatch - re-reading page by page"
+                          : "NDEF block read: no complete record - re-reading page by page");
+  } else {
+    Serial.println("NDEF block read failed - re-reading page by page");
+  }
+
+  memset(data, 0, (tagSize + 15) & ~15U);
+  bytesRead = 0;
+  needed = 4;
+  while (bytesRead < needed) {
+    if (handleAmsReadTimeout() || !robustPageRead(4 + bytesRead / 4, data + bytesRead)) {
+      Serial.printf("Failed to read page %d after retries, stopping\n", 4 + bytesRead / 4);
+      break;
+    }
+    bytesRead += 4;
+    needed = ndefBytesNeeded(data, bytesRead, tagSize, 4);
+
+    yield();
+    esp_task_wdt_reset();
+  }
+
+  if (bytesRead == 0) {
+    free(data);
+    return NULL;
+  }
+  Serial.printf("NDEF read: %u bytes in %lu ms (page read)\n", bytesRead, millis() - readStart);
+  length = bytesRead;
+  return data;
+}
+
 String detectNtagType()
 {
   // Read capability container from page 3 to determine exact NTAG type
@@ -657,56 +1254,6 @@ String detectNtagType()
   return tagType;
 }
 
-uint16_t getAvailableUserDataSize()
-{
-  String tagType = detectNtagType();
-  uint16_t userDataSize = 0;
-  
-  if (tagType == "NTAG213") {
-    // NTAG213: User data from page 4-39 (36 pages * 4 bytes = 144 bytes)
-    userDataSize = 144;
-    Serial.println("NTAG213 confirmed - 144 bytes user data available");
-  } else if (tagType == "NTAG215") {
-    // NTAG215: User data from page 4-129 (126 pages * 4 bytes = 504 bytes)
-    userDataSize = 504;
-    Serial.println("NTAG215 confirmed - 504 bytes user data available");
-  } else if (tagType == "NTAG216") {
-    // NTAG216: User data from page 4-225 (222 pages * 4 bytes = 888 bytes)
-    userDataSize = 888;
-    Serial.println("NTAG216 confirmed - 888 bytes user data available");
-  } else {
-    // Unknown tag type, use conservative estimate
-    uint16_t tagSize = readTagSize();
-    userDataSize = tagSize - 60; // Reserve 60 bytes for headers/config
-    Serial.print("Unknown NTAG type, using conservative estimate: ");
-    Serial.println(userDataSize);
-  }
-  
-  return userDataSize;
-}
-
-uint16_t getMaxUserDataPages()
-{
-  String tagType = detectNtagType();
-  uint16_t maxPages = 0;
-  
-  if (tagType == "NTAG213") {
-    maxPages = 39; // Pages 4-39 are user data
-  } else if (tagType == "NTAG215") {
-    maxPages = 129; // Pages 4-129 are user data
-  } else if (tagType == "NTAG216") {
-    maxPages = 225; // Pages 4-225 are user data
-  } else {
-    // Conservative fallback
-    maxPages = 39;
-    Serial.println("Unknown tag type, using NTAG213 page limit as fallback");
-  }
-  
-  Serial.print("Maximum writable page: ");
-  Serial.println(maxPages);
-  return maxPages;
-}
-
 bool initializeNdefStructure() {
     // Write minimal NDEF structure without destroying the tag
     // This creates a clean slate while preserving tag functionality
@@ -784,736 +1331,99 @@ bool clearUserDataArea() {
     return initializeNdefStructure();
 }
 
-uint8_t ntag2xx_WriteNDEF(const char *payload) {
-  // Determine exact tag type and capabilities first
-  String tagType = detectNtagType();
-  uint16_t tagSize = readTagSize();
-  uint16_t availableUserData = getAvailableUserDataSize();
-  uint16_t maxWritablePage = getMaxUserDataPages();
-  
-  Serial.println("=== NFC TAG ANALYSIS ===");
-  Serial.print("Tag Type: ");Serial.println(tagType);
-  Serial.print("Total Tag Size: ");Serial.println(tagSize);
-  Serial.print("Available User Data: ");Serial.println(availableUserData);
-  Serial.print("Max Writable Page: ");Serial.println(maxWritablePage);
-  Serial.println("========================");
-
-  // Perform additional tag validation by testing write boundaries
-  Serial.println("=== TAG VALIDATION ===");
-  uint8_t testBuffer[4] = {0x00, 0x00, 0x00, 0x00};
-  
-  // Test if we can actually read the max page
-  if (!nfc.ntag2xx_ReadPage(maxWritablePage, testBuffer)) {
-    Serial.print("WARNING: Cannot read declared max page ");
-    Serial.println(maxWritablePage);
-    
-    // Find actual maximum writable page by testing backwards with optimized approach
-    uint16_t actualMaxPage = maxWritablePage;
-    Serial.println("Searching for actual maximum writable page...");
-    
-    // Use binary search approach for faster page limit detection
-    uint16_t lowPage = 4;
-    uint16_t highPage = maxWritablePage;
-    uint16_t testAttempts = 0;
-    const uint16_t maxTestAttempts = 15; // Limit search attempts
-    
-    while (lowPage <= highPage && testAttempts < maxTestAttempts) {
-      uint16_t midPage = (lowPage + highPage) / 2;
-      testAttempts++;
-      
-      Serial.print("Testing page ");
-      Serial.print(midPage);
-      Serial.print(" (attempt ");
-      Serial.print(testAttempts);
-      Serial.print("/");
-      Serial.print(maxTestAttempts);
-      Serial.print(")... ");
-      
-      if (nfc.ntag2xx_ReadPage(midPage, testBuffer)) {
-        Serial.println("✓");
-        actualMaxPage = midPage;
-        lowPage = midPage + 1; // Search higher
-      } else {
-        Serial.println("❌");
-        highPage = midPage - 1; // Search lower
-      }
-      
-      // Small delay to prevent interface overload
-      vTaskDelay(5 / portTICK_PERIOD_MS);
-      yield();
-    }
-    
-    Serial.print("Found actual max readable page: ");
-    Serial.println(actualMaxPage);
-    Serial.print("Search completed in ");
-    Serial.print(testAttempts);
-    Serial.println(" attempts");
-    
-    maxWritablePage = actualMaxPage;
-  } else {
-    Serial.print("✓ Max page ");Serial.print(maxWritablePage);Serial.println(" is readable");
-  }
-  
-  // Calculate maximum available user data based on actual writable pages
-  uint16_t actualUserDataSize = (maxWritablePage - 3) * 4; // -3 because pages 0-3 are header
-  availableUserData = actualUserDataSize;
-  
-  Serial.print("Actual available user data: ");
-  Serial.print(actualUserDataSize);
-  Serial.println(" bytes");
-  Serial.println("========================");
-
-  uint8_t pageBuffer[4] = {0, 0, 0, 0};
-  Serial.println("Beginne mit dem Schreiben der NDEF-Nachricht...");
-  
-  // Figure out how long the string is
-  uint16_t payloadLen = strlen(payload);
-  Serial.print("Länge der Payload: ");
-  Serial.println(payloadLen);
-  
-  Serial.print("Payload: ");Serial.println(payload);
-
-  // MIME type for JSON
-  const char mimeType[] = "application/json";
-  uint8_t mimeTypeLen = strlen(mimeType);
-  
-  // Calculate NDEF record size
-  uint8_t ndefRecordHeaderSize = 3; // Header byte + Type Length + Payload Length (short record)
-  uint16_t ndefRecordSize = ndefRecordHeaderSize + mimeTypeLen + payloadLen;
-  
-  // Calculate TLV size - need to check if we need extended length format
-  uint8_t tlvHeaderSize;
-  uint16_t totalTlvSize;
-  
-  if (ndefRecordSize <= 254) {
-    // Standard TLV format: Tag (1) + Length (1) + Value (ndefRecordSize)
-    tlvHeaderSize = 2;
-    totalTlvSize = tlvHeaderSize + ndefRecordSize + 1; // +1 for terminator TLV
-  } else {
-    // Extended TLV format: Tag (1) + 0xFF + Length (2) + Value (ndefRecordSize)  
-    tlvHeaderSize = 4;
-    totalTlvSize = tlvHeaderSize + ndefRecordSize + 1; // +1 for terminator TLV
+uint8_t ntag2xx_WriteNDEF(const NdefImage& image) {
+  // The image was built and size-checked at enqueue time, here only the tag's own
+  // capacity from the capability container is compared before the pages go out.
+  uint8_t ccBuffer[4] = {0, 0, 0, 0};
+  if (!robustPageRead(3, ccBuffer)) {
+    Serial.println("FEHLER: Capability Container (Seite 3) nicht lesbar");
+    oledShowMessage("Tag read error");
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    return 0;
   }
 
-  Serial.print("NDEF Record Size: ");
-  Serial.println(ndefRecordSize);
-  Serial.print("Total TLV Size: ");
-  Serial.println(totalTlvSize);
+  uint16_t tagCapacity = ccBuffer[2] * 8;
+  Serial.printf("Tag capacity (CC): %u bytes, NDEF image: %u bytes (%s)\n",
+                tagCapacity, image.tlvLength, ndefCapacityClassName(image.tlvLength));
 
-  // Check if the message fits in the available user data space
-  if (totalTlvSize > availableUserData) {
-    Serial.println();
+  if (image.tlvLength > tagCapacity) {
     Serial.println("!!!!!!!!!!!!!!!!!!!!!!!!");
-    Serial.println("FEHLER: Payload zu groß für diesen Tag-Typ!");
-    Serial.print("Tag-Typ: ");Serial.println(tagType);
-    Serial.print("Benötigt: ");Serial.print(totalTlvSize);Serial.println(" Bytes");
-    Serial.print("Verfügbar: ");Serial.print(availableUserData);Serial.println(" Bytes");
-    Serial.print("Überschuss: ");Serial.print(totalTlvSize - availableUserData);Serial.println(" Bytes");
-    
-    if (tagType == "NTAG213") {
-      Serial.println("EMPFEHLUNG: Verwenden Sie einen NTAG215 (504 Bytes) oder NTAG216 (888 Bytes) Tag!");
-      Serial.println("Oder kürzen Sie die Payload um mindestens " + String(totalTlvSize - availableUserData) + " Bytes.");
-    }
+    Serial.println("FEHLER: Payload zu groß für diesen Tag!");
+    Serial.printf("Benötigt: %u Bytes, Verfügbar: %u Bytes, Überschuss: %u Bytes\n",
+                  image.tlvLength, tagCapacity, image.tlvLength - tagCapacity);
+    Serial.printf("EMPFEHLUNG: Mindestens %s verwenden\n", ndefCapacityClassName(image.tlvLength));
     Serial.println("!!!!!!!!!!!!!!!!!!!!!!!!");
-    Serial.println();
-    
     oledShowMessage("Tag zu klein für Payload");
     vTaskDelay(3000 / portTICK_PERIOD_MS);
     return 0;
   }
 
-  Serial.println("✓ Payload passt in den Tag - Schreibvorgang wird fortgesetzt");
+  uint16_t pageCount = image.length / 4;
+  unsigned long writeStart = millis();
+  Serial.printf("Schreibe %u Bytes in %u Seiten (4-%u)...\n", image.length, pageCount, 3 + pageCount);
 
-  // STEP 1: NFC Interface Reset and Reinitialization
-  Serial.println();
-  Serial.println("=== SCHRITT 1: NFC-INTERFACE RESET UND NEUINITIALISIERUNG ===");
-  
-  // First, check if the NFC interface is working at all
-  Serial.println("Teste aktuellen NFC-Interface-Zustand...");
-  
-  // Try to read capability container (which worked during detection)
-  uint8_t ccTest[4];
-  bool ccReadable = nfc.ntag2xx_ReadPage(3, ccTest);
-  Serial.print("Capability Container (Seite 3) lesbar: ");
-  Serial.println(ccReadable ? "✓" : "❌");
-  
-  if (!ccReadable) {
-    Serial.println("❌ NFC-Interface ist nicht funktionsfähig - führe Reset durch");
-    
-    // Perform NFC interface reset and reinitialization
-    Serial.println("Führe NFC-Interface Reset durch...");
-    
-    // Step 1: Try to reinitialize the NFC interface completely
-    Serial.println("1. Neuinitialisierung des PN532...");
-    
-    // Reinitialize the PN532
-    nfc.begin();
-    vTaskDelay(500 / portTICK_PERIOD_MS); // Give it time to initialize
-    
-    // Check firmware version to ensure communication is working
-    uint32_t versiondata = nfc.getFirmwareVersion();
-    if (versiondata) {
-      Serial.print("PN532 Firmware Version: 0x");
-      Serial.println(versiondata, HEX);
-      Serial.println("✓ PN532 Kommunikation wiederhergestellt");
-    } else {
-      Serial.println("❌ PN532 Kommunikation fehlgeschlagen");
-      oledShowMessage("NFC Reset failed");
-      vTaskDelay(3000 / portTICK_PERIOD_MS);
-      return 0;
-    }
-    
-    // Step 2: Reconfigure SAM
-    Serial.println("2. SAM-Konfiguration...");
-    nfc.SAMConfig();
-    vTaskDelay(200 / portTICK_PERIOD_MS);
-    
-    // Step 3: Re-detect the tag
-    Serial.println("3. Tag-Wiedererkennung...");
-    uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };
-    uint8_t uidLength;
-    bool tagRedetected = false;
-    
-    for (int attempts = 0; attempts < 5; attempts++) {
-      Serial.print("Tag-Erkennungsversuch ");
-      Serial.print(attempts + 1);
-      Serial.print("/5... ");
-      
-      if (nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 1000)) {
-        Serial.println("✓");
-        tagRedetected = true;
-        break;
-      } else {
-        Serial.println("❌");
-        vTaskDelay(300 / portTICK_PERIOD_MS);
-      }
-    }
-    
-    if (!tagRedetected) {
-      Serial.println("❌ Tag konnte nach Reset nicht wiedererkannt werden");
-      oledShowMessage("Tag lost after reset");
-      vTaskDelay(3000 / portTICK_PERIOD_MS);
-      return 0;
-    }
-    
-    Serial.println("✓ Tag erfolgreich wiedererkannt");
-    
-    // Step 4: Test basic page reading
-    Serial.println("4. Test der Grundfunktionalität...");
-    vTaskDelay(200 / portTICK_PERIOD_MS); // Give interface time to stabilize
-    
-    ccReadable = nfc.ntag2xx_ReadPage(3, ccTest);
-    Serial.print("Capability Container nach Reset lesbar: ");
-    Serial.println(ccReadable ? "✓" : "❌");
-    
-    if (!ccReadable) {
-      Serial.println("❌ NFC-Interface funktioniert nach Reset immer noch nicht");
-      oledShowMessage("NFC still broken");
-      vTaskDelay(3000 / portTICK_PERIOD_MS);
-      return 0;
-    }
-    
-    Serial.println("✓ NFC-Interface erfolgreich wiederhergestellt");
-  } else {
-    Serial.println("✓ NFC-Interface ist funktionsfähig");
-  }
-  
-  // Display CC content for debugging
-  if (ccReadable) {
-    Serial.print("CC Inhalt: ");
-    for (int i = 0; i < 4; i++) {
-      if (ccTest[i] < 0x10) Serial.print("0");
-      Serial.print(ccTest[i], HEX);
-      Serial.print(" ");
-    }
-    Serial.println();
-  }
-  
-  Serial.println("=== SCHRITT 2: INTERFACE-FUNKTIONSTEST ===");
-  
-  // Test a few critical pages to ensure stable operation
-  uint8_t testData[4];
-  bool basicPagesReadable = true;
-  
-  for (uint8_t testPage = 0; testPage <= 6; testPage++) {
-    bool readable = nfc.ntag2xx_ReadPage(testPage, testData);
-    Serial.print("Seite ");
-    Serial.print(testPage);
-    Serial.print(": ");
-    if (readable) {
-      Serial.print("✓ - ");
-      for (int i = 0; i < 4; i++) {
-        if (testData[i] < 0x10) Serial.print("0");
-        Serial.print(testData[i], HEX);
-        Serial.print(" ");
-      }
-      Serial.println();
-    } else {
-      Serial.println("❌ - Nicht lesbar");
-      if (testPage >= 3 && testPage <= 6) { // Critical pages for NDEF
-        basicPagesReadable = false;
-      }
-    }
-    vTaskDelay(10 / portTICK_PERIOD_MS); // Small delay between reads
-  }
-  
-  if (!basicPagesReadable) {
-    Serial.println("❌ KRITISCHER FEHLER: Grundlegende NDEF-Seiten nicht lesbar!");
-    Serial.println("Tag oder Interface ist defekt");
-    oledShowMessage("Tag/Interface defect");
-    vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  Serial.println("✓ Alle kritischen Seiten sind lesbar");
-  Serial.println("===================================================");
-
-  Serial.println();
-  Serial.println("=== SCHRITT 3: SCHREIBBEREITSCHAFTSTEST ===");
-  
-  // Test write capabilities before attempting the full write
-  Serial.println("Teste Schreibfähigkeiten des Tags...");
-  
-  uint8_t testPage[4] = {0xAA, 0xBB, 0xCC, 0xDD}; // Test pattern
-  uint8_t originalPage[4]; // Store original content
-  
-  // First, read original content of test page
-  if (!nfc.ntag2xx_ReadPage(10, originalPage)) {
-    Serial.println("FEHLER: Kann Testseite nicht lesen für Backup");
-    oledShowMessage("Test page read error");
-    vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  Serial.print("Original Inhalt Seite 10: ");
-  for (int i = 0; i < 4; i++) {
-    if (originalPage[i] < 0x10) Serial.print("0");
-    Serial.print(originalPage[i], HEX);
-    Serial.print(" ");
-  }
-  Serial.println();
-  
-  // Perform write test
-  if (!nfc.ntag2xx_WritePage(10, testPage)) {
-    Serial.println("FEHLER: Schreibtest fehlgeschlagen!");
-    Serial.println("Tag ist möglicherweise schreibgeschützt oder defekt");
-    
-    // Additional diagnostics
-    Serial.println("=== ERWEITERTE SCHREIBTEST-DIAGNOSE ===");
-    
-    // Check if tag is still present
-    uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };
-    uint8_t uidLength;
-    bool tagStillPresent = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 1000);
-    Serial.print("Tag noch erkannt: ");
-    Serial.println(tagStillPresent ? "✓" : "❌");
-    
-    if (!tagStillPresent) {
-      Serial.println("URSACHE: Tag wurde während Schreibtest entfernt!");
-      oledShowMessage("Tag removed");
-    } else {
-      Serial.println("URSACHE: Tag ist vorhanden aber nicht beschreibbar");
-      Serial.println("Möglicherweise: Schreibschutz, Defekt, oder Interface-Problem");
-      oledShowMessage("Tag write protected?");
-    }
-    Serial.println("==========================================");
-    
-    vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  // Verify test write
-  uint8_t readBack[4];
-  vTaskDelay(20 / portTICK_PERIOD_MS); // Wait for write to complete
-  
-  if (!nfc.ntag2xx_ReadPage(10, readBack)) {
-    Serial.println("FEHLER: Kann Testdaten nicht zurücklesen!");
-    oledShowMessage("Test verify failed");
-    vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  bool testSuccess = true;
-  for (int i = 0; i < 4; i++) {
-    if (readBack[i] != testPage[i]) {
-      testSuccess = false;
-      break;
-    }
-  }
-  
-  if (!testSuccess) {
-    Serial.println("FEHLER: Schreibtest fehlgeschlagen - Daten stimmen nicht überein!");
-    Serial.print("Geschrieben: ");
-    for (int i = 0; i < 4; i++) {
-      Serial.print(testPage[i], HEX); Serial.print(" ");
-    }
-    Serial.println();
-    Serial.print("Gelesen: ");
-    for (int i = 0; i < 4; i++) {
-      Serial.print(readBack[i], HEX); Serial.print(" ");
-    }
-    Serial.println();
-    return 0;
-  }
-  
-  // Restore original content
-  Serial.println("Stelle ursprünglichen Inhalt wieder her...");
-  if (!nfc.ntag2xx_WritePage(10, originalPage)) {
-    Serial.println("WARNUNG: Konnte ursprünglichen Inhalt nicht wiederherstellen!");
-  } else {
-    Serial.println("✓ Ursprünglicher Inhalt wiederhergestellt");
-  }
-  
-  Serial.println("✓ Schreibtest erfolgreich - Tag ist voll funktionsfähig");
-  Serial.println("======================================================");
-
-  // STEP 4: NDEF initialization with verification
-  Serial.println();
-  Serial.println("=== SCHRITT 4: NDEF-INITIALISIERUNG ===");
-  if (!initializeNdefStructure()) {
-    Serial.println("FEHLER: Konnte NDEF-Struktur nicht initialisieren!");
-    oledShowMessage("NDEF init failed");
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  // Verify NDEF initialization
-  uint8_t ndefCheck[8];
-  bool ndefVerified = true;
-  for (uint8_t page = 4; page < 6; page++) {
-    if (!nfc.ntag2xx_ReadPage(page, &ndefCheck[(page-4)*4])) {
-      ndefVerified = false;
-      break;
-    }
-  }
-  
-  if (ndefVerified) {
-    Serial.print("NDEF-Header nach Initialisierung: ");
-    for (int i = 0; i < 8; i++) {
-      if (ndefCheck[i] < 0x10) Serial.print("0");
-      Serial.print(ndefCheck[i], HEX);
-      Serial.print(" ");
-    }
-    Serial.println();
-  }
-  
-  Serial.println("✓ NDEF-Struktur initialisiert und verifiziert");
-  Serial.println("==========================================");
-
-  // STEP 5: Allow interface to stabilize before major write operation
-  Serial.println();
-  Serial.println("=== SCHRITT 5: NFC-INTERFACE STABILISIERUNG ===");
-  Serial.println("Stabilisiere NFC-Interface vor Hauptschreibvorgang...");
-  
-  // Give the interface time to fully settle after NDEF initialization
-  vTaskDelay(200 / portTICK_PERIOD_MS);
-  
-  // Test interface stability with a simple read
-  uint8_t stabilityTest[4];
-  bool interfaceStable = false;
-  for (int attempts = 0; attempts < 3; attempts++) {
-    if (nfc.ntag2xx_ReadPage(4, stabilityTest)) {
-      Serial.print("Interface stability test ");
-      Serial.print(attempts + 1);
-      Serial.println("/3: ✓");
-      interfaceStable = true;
-      break;
-    } else {
-      Serial.print("Interface stability test ");
-      Serial.print(attempts + 1);
-      Serial.println("/3: ❌");
-      vTaskDelay(100 / portTICK_PERIOD_MS);
-    }
-  }
-  
-  if (!interfaceStable) {
-    Serial.println("FEHLER: NFC-Interface ist nicht stabil genug für Schreibvorgang");
-    oledShowMessage("NFC Interface unstable");
-    vTaskDelay(3000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-  
-  Serial.println("✓ NFC-Interface ist stabil - Schreibvorgang kann beginnen");
-  Serial.println("=========================================================");
-
-  // Allocate memory for the complete TLV structure
-  uint8_t* tlvData = (uint8_t*) malloc(totalTlvSize);
-  if (tlvData == NULL) {
-    Serial.println("Fehler: Nicht genug Speicher für TLV-Daten vorhanden.");
-    oledShowMessage("Memory error");
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
-    return 0;
-  }
-
-  // Build TLV structure
-  uint16_t offset = 0;
-  
-  // TLV Header
-  tlvData[offset++] = 0x03; // NDEF Message TLV Tag
-  
-  if (ndefRecordSize <= 254) {
-    // Standard length format
-    tlvData[offset++] = (uint8_t)ndefRecordSize;
-  } else {
-    // Extended length format
-    tlvData[offset++] = 0xFF;
-    tlvData[offset++] = (uint8_t)(ndefRecordSize >> 8);  // High byte
-    tlvData[offset++] = (uint8_t)(ndefRecordSize & 0xFF); // Low byte
-  }
-
-  // NDEF Record Header
-  tlvData[offset++] = 0xD2; // NDEF Record Header (TNF=0x2:MIME Media + SR + ME + MB)
-  tlvData[offset++] = mimeTypeLen; // Type Length
-  tlvData[offset++] = (uint8_t)payloadLen; // Payload Length (short record format)
-
-  // MIME Type
-  memcpy(&tlvData[offset], mimeType, mimeTypeLen);
-  offset += mimeTypeLen;
-
-  // JSON Payload
-  memcpy(&tlvData[offset], payload, payloadLen);
-  offset += payloadLen;
-
-  // Terminator TLV
-  tlvData[offset] = 0xFE;
-
-  Serial.print("Gesamt-TLV-Länge: ");
-  Serial.println(offset + 1);
-
-  // Debug: Print first 64 bytes of TLV data
-  Serial.println("TLV Daten (erste 64 Bytes):");
-  for (int i = 0; i < min((int)(offset + 1), 64); i++) {
-    if (tlvData[i] < 0x10) Serial.print("0");
-    Serial.print(tlvData[i], HEX);
-    Serial.print(" ");
-    if ((i + 1) % 16 == 0) Serial.println();
-  }
-  Serial.println();
-
-  // Write data to tag pages (starting from page 4)
-  uint16_t bytesWritten = 0;
-  uint8_t pageNumber = 4;
-  uint16_t totalBytes = offset + 1;
-
-  Serial.println();
-  Serial.println("=== SCHRITT 6: SCHREIBE NEUE NDEF-DATEN ===");
-  Serial.print("Schreibe ");
-  Serial.print(totalBytes);
-  Serial.print(" Bytes in ");
-  Serial.print((totalBytes + 3) / 4); // Round up division
-  Serial.println(" Seiten...");
-
-  while (bytesWritten < totalBytes && pageNumber <= maxWritablePage) {
-    // Additional safety check before writing each page
-    if (pageNumber > maxWritablePage) {
-      Serial.print("STOP: Reached maximum writable page ");
-      Serial.println(maxWritablePage);
-      break;
-    }
-    
-    // Clear page buffer
-    memset(pageBuffer, 0, 4);
-    
-    // Calculate how many bytes to write to this page
-    uint16_t bytesToWrite = min(4, (int)(totalBytes - bytesWritten));
-    
-    // Copy data to page buffer
-    memcpy(pageBuffer, &tlvData[bytesWritten], bytesToWrite);
+  for (uint16_t i = 0; i < pageCount; i++) {
+    uint8_t pageNumber = 4 + i;
+    const uint8_t* pageBuffer = &image.data[i * 4];
 
     // Write page to tag with retry mechanism
     bool writeSuccess = false;
     for (int writeAttempt = 0; writeAttempt < 3; writeAttempt++) {
-      if (nfc.ntag2xx_WritePage(pageNumber, pageBuffer)) {
+      if (nfc.ntag2xx_WritePage(pageNumber, (uint8_t*)pageBuffer)) {
         writeSuccess = true;
         break;
-      } else {
-        Serial.print("Schreibversuch ");
-        Serial.print(writeAttempt + 1);
-        Serial.print("/3 für Seite ");
-        Serial.print(pageNumber);
-        Serial.println(" fehlgeschlagen");
-        
-        if (writeAttempt < 2) {
-          vTaskDelay(50 / portTICK_PERIOD_MS); // Wait before retry
-        }
+      }
+      Serial.printf("Schreibversuch %d/3 für Seite %u fehlgeschlagen\n", writeAttempt + 1, pageNumber);
+      if (writeAttempt < 2) {
+        vTaskDelay(50 / portTICK_PERIOD_MS); // Wait before retry
       }
     }
 
     if (!writeSuccess) {
       Serial.print("FEHLER beim Schreiben der Seite ");
       Serial.println(pageNumber);
-      Serial.print("Möglicherweise Page-Limit erreicht für ");
-      Serial.println(tagType);
-      Serial.print("Erwartetes Maximum: ");
-      Serial.println(maxWritablePage);
-      Serial.print("Tatsächliches Maximum scheint niedriger zu sein!");
-      
-      // Update max page for future operations
-      if (pageNumber > 4) {
-        Serial.print("Setze neues Maximum auf Seite ");
-        Serial.println(pageNumber - 1);
-      }
-      
-      free(tlvData);
       return 0;
     }
 
-    // IMMEDIATE verification after each write - this is critical!
-    Serial.print("Verifiziere Seite ");
-    Serial.print(pageNumber);
-    Serial.print("... ");
-    
+    // Verify every page right after writing it
     uint8_t verifyBuffer[4];
-    vTaskDelay(20 / portTICK_PERIOD_MS); // Increased delay before verification
-    
-    // Verification with retry mechanism
     bool verifySuccess = false;
     for (int verifyAttempt = 0; verifyAttempt < 3; verifyAttempt++) {
-      if (nfc.ntag2xx_ReadPage(pageNumber, verifyBuffer)) {
-        bool writeMatches = true;
-        for (int i = 0; i < bytesToWrite; i++) {
-          if (verifyBuffer[i] != pageBuffer[i]) {
-            writeMatches = false;
-            Serial.println();
-            Serial.print("VERIFIKATIONSFEHLER bei Byte ");
-            Serial.print(i);
-            Serial.print(" - Erwartet: 0x");
-            Serial.print(pageBuffer[i], HEX);
-            Serial.print(", Gelesen: 0x");
-            Serial.println(verifyBuffer[i], HEX);
-            break;
-          }
-        }
-        
-        if (writeMatches) {
-          verifySuccess = true;
-          break;
-        } else if (verifyAttempt < 2) {
-          Serial.print("Verifikationsversuch ");
-          Serial.print(verifyAttempt + 1);
-          Serial.println("/3 fehlgeschlagen, wiederhole...");
-          vTaskDelay(30 / portTICK_PERIOD_MS);
-        }
-      } else {
-        Serial.print("Verifikations-Read-Versuch ");
-        Serial.print(verifyAttempt + 1);
-        Serial.println("/3 fehlgeschlagen");
-        if (verifyAttempt < 2) {
-          vTaskDelay(30 / portTICK_PERIOD_MS);
-        }
+      if (nfc.ntag2xx_ReadPage(pageNumber, verifyBuffer) && memcmp(verifyBuffer, pageBuffer, 4) == 0) {
+        verifySuccess = true;
+        break;
+      }
+      Serial.printf("Verifikationsversuch %d/3 für Seite %u fehlgeschlagen\n", verifyAttempt + 1, pageNumber);
+      if (verifyAttempt < 2) {
+        vTaskDelay(30 / portTICK_PERIOD_MS);
       }
     }
-    
+
     if (!verifySuccess) {
       Serial.println("❌ SCHREIBVORGANG/VERIFIKATION FEHLGESCHLAGEN!");
-      free(tlvData);
       return 0;
-    } else {
-      Serial.println("✓");
-    }
-
-    Serial.print("Seite ");
-    Serial.print(pageNumber);
-    Serial.print(" ✓: ");
-    for (int i = 0; i < 4; i++) {
-      if (pageBuffer[i] < 0x10) Serial.print("0");
-      Serial.print(pageBuffer[i], HEX);
-      Serial.print(" ");
     }
-    Serial.println();
 
-    bytesWritten += bytesToWrite;
-    pageNumber++;
-    
+    esp_task_wdt_reset();
     yield();
-    vTaskDelay(10 / portTICK_PERIOD_MS); // Slightly increased delay between page writes
   }
 
-  free(tlvData);
-  
-  if (bytesWritten < totalBytes) {
-    Serial.println("WARNUNG: Nicht alle Daten konnten geschrieben werden!");
-    Serial.print("Geschrieben: ");
-    Serial.print(bytesWritten);
-    Serial.print(" von ");
-    Serial.print(totalBytes);
-    Serial.println(" Bytes");
-    Serial.print("Gestoppt bei Seite: ");
-    Serial.println(pageNumber - 1);
-    return 0;
-  }
-  
-  Serial.println();
   Serial.println("✓ NDEF-Nachricht erfolgreich geschrieben!");
-  Serial.print("✓ Tag-Typ: ");Serial.println(tagType);
-  Serial.print("✓ Insgesamt ");Serial.print(bytesWritten);Serial.println(" Bytes geschrieben");
-  Serial.print("✓ Verwendete Seiten: 4-");Serial.println(pageNumber - 1);
-  Serial.print("✓ Speicher-Auslastung: ");
-  Serial.print((bytesWritten * 100) / availableUserData);
-  Serial.println("%");
-  Serial.println("✓ Bestehende Daten wurden überschrieben");
-  
-  // CRITICAL: Allow NFC interface to stabilize after write operation
-  Serial.println();
-  Serial.println("=== SCHRITT 7: NFC-INTERFACE STABILISIERUNG NACH SCHREIBVORGANG ===");
-  Serial.println("Stabilisiere NFC-Interface nach Schreibvorgang...");
-  
-  // Give the tag and interface time to settle after write operation
-  vTaskDelay(300 / portTICK_PERIOD_MS); // Increased stabilization time
-  
-  // Test if the interface is still responsive
-  uint8_t postWriteTest[4];
-  bool interfaceResponsive = false;
-  
-  for (int stabilityAttempt = 0; stabilityAttempt < 5; stabilityAttempt++) {
-    Serial.print("Post-write interface test ");
-    Serial.print(stabilityAttempt + 1);
-    Serial.print("/5... ");
-    
-    if (nfc.ntag2xx_ReadPage(3, postWriteTest)) { // Read capability container
-      Serial.println("✓");
-      interfaceResponsive = true;
-      break;
-    } else {
-      Serial.println("❌");
-      
-      if (stabilityAttempt < 4) {
-        Serial.println("Warte und versuche Interface zu stabilisieren...");
-        vTaskDelay(200 / portTICK_PERIOD_MS);
-        
-        // Try to re-establish communication with a simple tag presence check
-        uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };
-        uint8_t uidLength;
-        bool tagStillPresent = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 1000);
-        Serial.print("Tag presence check: ");
-        Serial.println(tagStillPresent ? "✓" : "❌");
-        
-        if (!tagStillPresent) {
-          Serial.println("Tag wurde während/nach Schreibvorgang entfernt!");
-          break;
-        }
-      }
-    }
-  }
-  
-  if (!interfaceResponsive) {
-    Serial.println("WARNUNG: NFC-Interface reagiert nach Schreibvorgang nicht mehr stabil");
-    Serial.println("Schreibvorgang war erfolgreich, aber Interface benötigt möglicherweise Reset");
-  } else {
-    Serial.println("✓ NFC-Interface ist nach Schreibvorgang stabil");
-  }
-  
-  Serial.println("==================================================================");
-  
+  Serial.printf("✓ %u Bytes in %lu ms, Seiten 4-%u, Speicher-Auslastung: %u%%\n",
+                image.length, millis() - writeStart, 3 + pageCount,
+                tagCapacity > 0 ? (image.tlvLength * 100) / tagCapacity : 0);
+
   return 1;
 }
 
-bool decodeNdefAndReturnJson(const byte* encodedMessage, String uidString) {
-  oledShowProgressBar(1, octoEnabled?5:4, "Reading", "Decoding data");
+// Extracts the JSON payload of the NDEF record into nfcJsonData and decodes it
+// into the record (single JSON parse). No side effects beyond nfcJsonData and the
+// raw payload kept for tag migration.
+static bool decodeNdefRecord(const byte* encodedMessage, uint16_t length, SpoolTagRecord& record) {
 
   // Debug: Print first 32 bytes of the raw data
   Serial.println("Raw NDEF data (first 32 bytes):");
-  for (int i = 0; i < 32; i++) {
+  for (int i = 0; i < 32 && i < length; i++) {
     if (encodedMessage[i] < 0x10) Serial.print("0");
     Serial.print(encodedMessage[i], HEX);
     Serial.print(" ");
@@ -1521,234 +1431,183 @@ bool decodeNdefAndReturnJson(const byte* encodedMessage, String uidString) {
   }
   Serial.println();
 
-  // Look for the NDEF TLV structure starting from the beginning
-  int tlvOffset = 0;
-  bool foundNdefTlv = false;
-  
-  // Search for NDEF TLV (0x03) in the first few bytes
-  for (int i = 0; i < 16; i++) {
-    if (encodedMessage[i] == 0x03) {
-      tlvOffset = i;
-      foundNdefTlv = true;
-      Serial.print("Found NDEF TLV at offset: ");
-      Serial.println(tlvOffset);
-      break;
-    }
-  }
-
-  if (!foundNdefTlv) {
-    Serial.println("No NDEF TLV found in tag data");
+  NdefRecordLayout layout;
+  if (!parseNdefRecordLayout(encodedMessage, length, layout)) {
+    Serial.println("No valid NDEF TLV/record found in tag data");
     return false;
   }
-
-  // Get the NDEF message length from TLV
-  uint16_t ndefMessageLength = 0;
-  int ndefRecordOffset = 0;
-  
-  if (encodedMessage[tlvOffset + 1] == 0xFF) {
-    // Extended length format: next 2 bytes contain the actual length
-    ndefMessageLength = (encodedMessage[tlvOffset + 2] << 8) | encodedMessage[tlvOffset + 3];
-    ndefRecordOffset = tlvOffset + 4; // Skip TLV tag + 0xFF + 2 length bytes
-    Serial.print("NDEF Message Length (extended): ");
-  } else {
-    // Standard length format: single byte contains the length
-    ndefMessageLength = encodedMessage[tlvOffset + 1];
-    ndefRecordOffset = tlvOffset + 2; // Skip TLV tag + 1 length byte
-    Serial.print("NDEF Message Length (standard): ");
+  if (layout.messageEnd > length) {
+    Serial.print("Invalid NDEF structure - message extends beyond read data: ");
+    Serial.print(layout.messageEnd);
+    Serial.print(" > ");
+    Serial.println(length);
+    return false;
   }
-  Serial.println(ndefMessageLength);
 
-  // Get pointer to NDEF record
-  const byte* ndefRecord = &encodedMessage[ndefRecordOffset];
-  
-  // Parse NDEF record header
-  byte recordHeader = ndefRecord[0];
-  byte typeLength = ndefRecord[1];
-  
   Serial.print("NDEF Record Header: 0x");
-  Serial.println(recordHeader, HEX);
-  Serial.print("Type Length: ");
-  Serial.println(typeLength);
-
-  // Determine payload length (can be 1 or 4 bytes depending on SR flag)
-  uint32_t payloadLength = 0;
-  byte payloadLengthBytes = 1;
-  byte payloadLengthOffset = 2;
-  
-  // Check if Short Record (SR) flag is set (bit 4)
-  if (recordHeader & 0x10) { // SR flag
-    payloadLength = ndefRecord[2];
-    payloadLengthBytes = 1;
-    payloadLengthOffset = 2;
-  } else {
-    // Long record format (4 bytes for payload length)
-    payloadLength = (ndefRecord[2] << 24) | (ndefRecord[3] << 16) | 
-                   (ndefRecord[4] << 8) | ndefRecord[5];
-    payloadLengthBytes = 4;
-    payloadLengthOffset = 2;
-  }
-
-  Serial.print("Payload Length: ");
-  Serial.println(payloadLength);
-  Serial.print("Payload Length Bytes: ");
-  Serial.println(payloadLengthBytes);
-
-  // Check for ID field (if IL flag is set)
-  byte idLength = 0;
-  if (recordHeader & 0x08) { // IL flag
-    idLength = ndefRecord[payloadLengthOffset + payloadLengthBytes];
-    Serial.print("ID Length: ");
-    Serial.println(idLength);
-  }
-
-  // Calculate offset to payload
-  byte payloadOffset = 1 + 1 + payloadLengthBytes + typeLength + idLength;
-  
-  Serial.print("Calculated payload offset: ");
-  Serial.println(payloadOffset);
-
-  // Verify we have enough data
-  if (payloadOffset + payloadLength > ndefMessageLength) {
-    Serial.println("Invalid NDEF structure - payload extends beyond message");
-    Serial.print("Payload offset + length: ");
-    Serial.print(payloadOffset + payloadLength);
-    Serial.print(", NDEF message length: ");
-    Serial.println(ndefMessageLength);
-    return false;
-  }
+  Serial.print(encodedMessage[layout.recordOffset], HEX);
+  Serial.print(", Type Length: ");
+  Serial.print(layout.typeLength);
+  Serial.print(", Payload Length: ");
+  Serial.print(layout.payloadLength);
+  Serial.print(", Payload offset: ");
+  Serial.println(layout.payloadOffset);
 
   // Print the record type for debugging
   Serial.print("Record Type: ");
-  for (int i = 0; i < typeLength; i++) {
-    Serial.print((char)ndefRecord[1 + 1 + payloadLengthBytes + i]);
+  for (int i = 0; i < layout.typeLength; i++) {
+    Serial.print((char)encodedMessage[layout.typeOffset + i]);
   }
   Serial.println();
 
+  const byte* ndefRecord = encodedMessage;
+  const uint16_t payloadOffset = layout.payloadOffset;
+  const uint32_t payloadLength = layout.payloadLength;
+
   nfcJsonData = "";
+  nfcRawPayload = "";
+  nfcRawPayloadLossy = false;
 
-  // Extract JSON payload with validation
-  uint32_t actualJsonLength = 0;
-  for (uint32_t i = 0; i < payloadLength; i++) {
-    byte currentByte = ndefRecord[payloadOffset + i];
-    
-    // Stop at null terminator or if we find the end of JSON
-    if (currentByte == 0x00) {
-      Serial.print("Found null terminator at position: ");
-      Serial.println(i);
-      break;
+  if (layout.hasCrc) {
+    // Written by Filaman: the CRC proves the payload is complete, no guessing needed
+    if (!ndefPayloadCrcValid(encodedMessage, layout)) {
+      Serial.printf("Payload CRC mismatch (stored %04X) - tag data corrupt\n", layout.crc);
+      return false;
     }
-    
-    // Only add printable characters and common JSON characters
-    if (currentByte >= 32 && currentByte <= 126) {
-      nfcJsonData += (char)currentByte;
-      actualJsonLength++;
-    } else {
-      Serial.print("Skipping non-printable byte at position ");
-      Serial.print(i);
-      Serial.print(": 0x");
-      Serial.println(currentByte, HEX);
+    nfcJsonData.reserve(payloadLength);
+    for (uint32_t i = 0; i < payloadLength; i++) {
+      nfcJsonData += (char)encodedMessage[payloadOffset + i];
     }
-    
-    // Check if we've reached the end of a JSON object
-    if (currentByte == '}') {
-      // Count opening and closing braces to detect complete JSON
-      int braceCount = 0;
-      for (uint32_t j = 0; j <= i; j++) {
-        if (ndefRecord[payloadOffset + j] == '{') braceCount++;
-        else if (ndefRecord[payloadOffset + j] == '}') braceCount--;
-      }
-      
-      if (braceCount == 0) {
-        Serial.print("Found complete JSON object at position: ");
+    nfcRawPayload = nfcJsonData;
+    Serial.println("✓ Payload CRC valid");
+  } else {
+    // Extract JSON payload with validation
+    uint32_t actualJsonLength = 0;
+    for (uint32_t i = 0; i < payloadLength; i++) {
+      byte currentByte = ndefRecord[payloadOffset + i];
+    
+      // Stop at null terminator or if we find the end of JSON
+      if (currentByte == 0x00) {
+        Serial.print("Found null terminator at position: ");
         Serial.println(i);
-        actualJsonLength = i + 1;
         break;
       }
+    
+      nfcRawPayload += (char)currentByte;
+
+      // Only add printable characters and common JSON characters
+      if (currentByte >= 32 && currentByte <= 126) {
+        nfcJsonData += (char)currentByte;
+        actualJsonLength++;
+      } else {
+        nfcRawPayloadLossy = true;
+        Serial.print("Skipping non-printable byte at position ");
+        Serial.print(i);
+        Serial.print(": 0x");
+        Serial.println(currentByte, HEX);
+      }
+    
+      // Check if we've reached the end of a JSON object
+      if (currentByte == '}') {
+        // Count opening and closing braces to detect complete JSON
+        int braceCount = 0;
+        for (uint32_t j = 0; j <= i; j++) {
+          if (ndefRecord[payloadOffset + j] == '{') braceCount++;
+          else if (ndefRecord[payloadOffset + j] == '}') braceCount--;
+        }
+      
+        if (braceCount == 0) {
+          Serial.print("Found complete JSON object at position: ");
+          Serial.println(i);
+          actualJsonLength = i + 1;
+          break;
+        }
+      }
+    }
+
+    Serial.print("Actual JSON length extracted: ");
+    Serial.println(actualJsonLength);
+
+    // Check if JSON was truncated
+    if (nfcJsonData.length() < payloadLength && !nfcJsonData.endsWith("}")) {
+      Serial.println("WARNING: JSON payload appears to be truncated!");
+      Serial.print("Expected payload length: ");
+      Serial.println(payloadLength);
+      Serial.print("Actual extracted length: ");
+      Serial.println(nfcJsonData.length());
     }
   }
 
-  Serial.print("Actual JSON length extracted: ");
-  Serial.println(actualJsonLength);
   Serial.print("Total nfcJsonData length: ");
   Serial.println(nfcJsonData.length());
   Serial.println("=== DECODED JSON DATA START ===");
   Serial.println(nfcJsonData);
   Serial.println("=== DECODED JSON DATA END ===");
   
-  // Check if JSON was truncated
-  if (nfcJsonData.length() < payloadLength && !nfcJsonData.endsWith("}")) {
-    Serial.println("WARNING: JSON payload appears to be truncated!");
-    Serial.print("Expected payload length: ");
-    Serial.println(payloadLength);
-    Serial.print("Actual extracted length: ");
-    Serial.println(nfcJsonData.length());
-  }
-  
   // Trim any trailing whitespace or invalid characters
   nfcJsonData.trim();
 
   // JSON-Dokument verarbeiten
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, nfcJsonData);
-  if (error) 
+  if (!decodeSpoolTagRecord(nfcJsonData.c_str(), nfcJsonData.length(), record))
   {
     nfcJsonData = "";
     Serial.println("Fehler beim Verarbeiten des JSON-Dokuments");
-    Serial.print("deserializeJson() failed: ");
-    Serial.println(error.f_str());
     return false;
-  } 
-  else 
-  {
-    // If spoolman is unavailable, there is no point in continuing
-    if(spoolmanConnected){
-      // Sende die aktualisierten AMS-Daten an alle WebSocket-Clients
-      Serial.println("JSON-Dokument erfolgreich verarbeitet");
-      Serial.println(doc.as<String>());
-      if (doc["sm_id"].is<String>() && doc["sm_id"] != "" && doc["sm_id"] != "0")
-      {
-        oledShowProgressBar(2, octoEnabled?5:4, "Spool Tag", "Weighing");
-        Serial.println("SPOOL-ID gefunden: " + doc["sm_id"].as<String>());
-        activeSpoolId = doc["sm_id"].as<String>();
-        lastSpoolId = activeSpoolId;
-        noteAmsSpoolReadEvent();
-      }
-      else if(doc["location"].is<String>() && doc["location"] != "")
-      {
-        Serial.println("Location Tag found!");
-        String location = doc["location"].as<String>();
-        if(lastSpoolId != ""){
-          updateSpoolLocation(lastSpoolId, location);
-        }
-        else
-        {
-          Serial.println("Location update tag scanned without scanning spool before!");
-          oledShowProgressBar(1, 1, "Failure", "Scan spool first");
-        }
-      }
-      // Brand Filament not registered to Spoolman
-      else if ((!doc["sm_id"].is<String>() || (doc["sm_id"].is<String>() && (doc["sm_id"] == "0" || doc["sm_id"] == "")))
-              && doc["b"].is<String>() && doc["an"].is<String>())
-      {
-        doc["sm_id"] = "0"; // Ensure sm_id is set to 0
-        // If no sm_id is present but the brand is Brand Filament then
-        // create a new spool, maybe brand too, in Spoolman
-        Serial.println("New Brand Filament Tag found!");
-        createBrandFilament(doc, uidString);
+  }
+
+  Serial.println("JSON-Dokument erfolgreich verarbeitet");
+  return true;
+}
+
+bool decodeNdefAndReturnJson(const byte* encodedMessage, uint16_t length, String uidString) {
+  oledShowProgressBar(1, octoEnabled?5:4, "Reading", "Decoding data");
+
+  if (!decodeNdefRecord(encodedMessage, length, lastTagRecord)) {
+    return false;
+  }
+  const SpoolTagRecord& tag = lastTagRecord;
+
+  // Without Spoolman, known spools and location tags still work through the offline log
+  if(spoolmanConnected || tag.isKnownSpool() || tag.isLocationTag()){
+    if (tag.isKnownSpool())
+    {
+      oledShowProgressBar(2, octoEnabled?5:4, "Spool Tag", spoolmanConnected ? "Weighing" : "Weighing (offline)");
+      Serial.println("SPOOL-ID gefunden: " + tag.smId);
+      activeSpoolId = tag.smId;
+      lastSpoolId = activeSpoolId;
+      prefetchSpoolInfo(tag.smId.toInt());
+      noteAmsSpoolReadEvent();
+    }
+    else if(tag.isLocationTag())
+    {
+      Serial.println("Location Tag found!");
+      if(lastSpoolId != ""){
+        updateSpoolLocation(lastSpoolId, tag.location);
       }
-      else 
+      else
       {
-        Serial.println("Keine SPOOL-ID gefunden.");
-        activeSpoolId = "";
-        oledShowProgressBar(1, 1, "Failure", "Unkown tag");
+        Serial.println("Location update tag scanned without scanning spool before!");
+        oledShowProgressBar(1, 1, "Failure", "Scan spool first");
       }
-    }else{
-      oledShowProgressBar(octoEnabled?5:4, octoEnabled?5:4, "Failure!", "Spoolman unavailable");
     }
+    // Brand Filament not registered to Spoolman
+    else if (tag.isBrandFilament())
+    {
+      // If no sm_id is present but the brand is Brand Filament then
+      // create a new spool, maybe brand too, in Spoolman
+      Serial.println("New Brand Filament Tag found!");
+      createBrandFilament(tag, uidString);
+    }
+    else 
+    {
+      Serial.println("Keine SPOOL-ID gefunden.");
+      activeSpoolId = "";
+      oledShowProgressBar(1, 1, "Failure", "Unkown tag");
+    }
+  }else{
+    oledShowProgressBar(octoEnabled?5:4, octoEnabled?5:4, "Failure!", "Spoolman unavailable");
   }
 
-  doc.clear();
-
   return true;
 }
 
@@ -1763,36 +1622,15 @@ bool readCompleteJsonForFastPath() {
         return false;
     }
     
-    // Create buffer for complete data
-    uint8_t* data = (uint8_t*)malloc(tagSize);
+    uint16_t length = 0;
+    uint8_t* data = readNdefMessage(tagSize, length);
     if (!data) {
-        Serial.println("FAST-PATH: Could not allocate memory for complete read");
-        return false;
-    }
-    memset(data, 0, tagSize);
-    
-    // Read all pages
-    uint8_t numPages = tagSize / 4;
-    for (uint8_t i = 4; i < 4 + numPages; i++) {
-      if (!robustPageRead(i, data + (i - 4) * 4)) {
-        Serial.printf("FAST-PATH: Failed to read page %d\n", i);
-        free(data);
+        Serial.println("FAST-PATH: Could not read NDEF message");
         return false;
-      }
-
-      // Check for NDEF message end
-      if (data[(i - 4) * 4] == 0xFE) {
-        Serial.println("FAST-PATH: Found NDEF message end marker");
-        break;
-      }
-
-      yield();
-      esp_task_wdt_reset();
-      vTaskDelay(pdMS_TO_TICKS(2));
     }
     
-    // Decode NDEF and extract JSON
-    bool success = decodeNdefAndReturnJson(data, ""); // Empty UID string for fast-path
+    // Decode NDEF and extract JSON (spool handling was already done by the fast path)
+    bool success = decodeNdefRecord(data, length, lastTagRecord);
     
     free(data);
     
@@ -1819,156 +1657,56 @@ bool quickSpoolIdCheck(String uidString) {
     
     Serial.println("=== FAST-PATH: Quick sm_id Check ===");
     
-    // Read enough pages to cover NDEF header + beginning of payload (pages 4-8 = 20 bytes)
-    uint8_t ndefData[20];
-    memset(ndefData, 0, 20);
+    // Pages 4-15 cover TLV, record header, MIME type, CRC id and the start of the payload.
+    // Block reads first, single pages with retries only for a block that failed.
+    uint8_t ndefData[48];
+    memset(ndefData, 0, sizeof(ndefData));
     
-    for (uint8_t page = 4; page < 9; page++) {
-        if (!robustPageRead(page, ndefData + (page - 4) * 4)) {
-            Serial.print("FAST-PATH: Failed to read page ");
-            Serial.print(page);
-            Serial.println(" - falling back to full read");
-            return false; // Fall back to full read if any page read fails
+    for (uint8_t block = 0; block < 3; block++) {
+        uint8_t* blockData = ndefData + block * 16;
+        if (readTagBlock(4 + block * 4, blockData)) {
+            continue;
+        }
+        for (uint8_t page = 0; page < 4; page++) {
+            if (!robustPageRead(4 + block * 4 + page, blockData + page * 4)) {
+                Serial.print("FAST-PATH: Failed to read page ");
+                Serial.print(4 + block * 4 + page);
+                Serial.println(" - falling back to full read");
+                return false; // Fall back to full read if any page read fails
+            }
         }
     }
     
-    // Parse NDEF structure to find JSON payload start
-    Serial.print("Raw NDEF data (first 20 bytes): ");
-    for (int i = 0; i < 20; i++) {
+    Serial.print("Raw NDEF data (first 32 bytes): ");
+    for (int i = 0; i < 32; i++) {
         if (ndefData[i] < 0x10) Serial.print("0");
         Serial.print(ndefData[i], HEX);
         Serial.print(" ");
     }
     Serial.println();
     
-    // Look for NDEF TLV (0x03) at the beginning
-    int tlvOffset = -1;
-    for (int i = 0; i < 8; i++) {
-        if (ndefData[i] == 0x03) {
-            tlvOffset = i;
-            Serial.print("Found NDEF TLV at offset: ");
-            Serial.println(tlvOffset);
-            break;
-        }
-    }
-    
-    if (tlvOffset == -1) {
+    NdefRecordLayout layout;
+    if (!parseNdefRecordHeader(ndefData, sizeof(ndefData), layout)) {
         Serial.println("✗ FAST-PATH: No NDEF TLV found");
         return false;
     }
     
-    // Parse NDEF record to find JSON payload
-    int ndefRecordStart;
-    if (ndefData[tlvOffset + 1] == 0xFF) {
-        // Extended length format
-        ndefRecordStart = tlvOffset + 4;
-    } else {
-        // Standard length format
-        ndefRecordStart = tlvOffset + 2;
-    }
-    
-    if (ndefRecordStart >= 20) {
-        Serial.println("✗ FAST-PATH: NDEF record starts beyond read data");
-        return false;
-    }
-    
-    // Parse NDEF record header
-    uint8_t recordHeader = ndefData[ndefRecordStart];
-    uint8_t typeLength = ndefData[ndefRecordStart + 1];
-    
-    // Calculate payload offset
-    uint8_t payloadLengthBytes = (recordHeader & 0x10) ? 1 : 4; // SR flag check
-    uint8_t idLength = (recordHeader & 0x08) ? ndefData[ndefRecordStart + 2 + payloadLengthBytes + typeLength] : 0; // IL flag check
-    
-    int payloadOffset = ndefRecordStart + 1 + 1 + payloadLengthBytes + typeLength + idLength;
-    
     Serial.print("NDEF Record Header: 0x");
-    Serial.print(recordHeader, HEX);
+    Serial.print(ndefData[layout.recordOffset], HEX);
     Serial.print(", Type Length: ");
-    Serial.print(typeLength);
+    Serial.print(layout.typeLength);
     Serial.print(", Payload offset: ");
-    Serial.println(payloadOffset);
+    Serial.println(layout.payloadOffset);
     
-    // Check if payload starts within our read data
-    if (payloadOffset >= 20) {
-        Serial.println("✗ FAST-PATH: JSON payload starts beyond quick read data - need more pages");
-        
-        // Read additional pages to get to JSON payload
-        uint8_t extraData[16]; // Read 4 more pages
-        memset(extraData, 0, 16);
-        
-        for (uint8_t page = 9; page < 13; page++) {
-            if (!robustPageRead(page, extraData + (page - 9) * 4)) {
-                Serial.print("FAST-PATH: Failed to read additional page ");
-                Serial.print(page);
-                Serial.println(" - falling back to full read");
-                return false; // Fall back to full read if extended read fails
-            }
-        }
-        
-        // Combine data
-        uint8_t combinedData[36];
-        memcpy(combinedData, ndefData, 20);
-        memcpy(combinedData + 20, extraData, 16);
-        
-        // Extract JSON from combined data
-        String jsonStart = "";
-        int jsonStartPos = payloadOffset;
-        for (int i = 0; i < 36 - payloadOffset && i < 30; i++) {
-            uint8_t currentByte = combinedData[payloadOffset + i];
-            if (currentByte >= 32 && currentByte <= 126) {
-                jsonStart += (char)currentByte;
-            }
-            // Stop at first brace to get just the beginning
-            if (currentByte == '{' && i > 0) break;
-        }
-        
-        Serial.print("JSON start from extended read: ");
-        Serial.println(jsonStart);
-        
-        // Check for sm_id pattern - look for non-zero sm_id values
-        if (jsonStart.indexOf("\"sm_id\":\"") >= 0) {
-            int smIdStart = jsonStart.indexOf("\"sm_id\":\"") + 9;
-            int smIdEnd = jsonStart.indexOf("\"", smIdStart);
-            
-            if (smIdEnd > smIdStart && smIdEnd < jsonStart.length()) {
-                String quickSpoolId = jsonStart.substring(smIdStart, smIdEnd);
-                Serial.print("Found sm_id in extended read: ");
-                Serial.println(quickSpoolId);
-                
-                // Only process if sm_id is not "0" (known spool)
-                if (quickSpoolId != "0" && quickSpoolId.length() > 0) {
-                    Serial.println("✓ FAST-PATH: Known spool detected!");
-                    
-                    // Set as active spool immediately
-                    activeSpoolId = quickSpoolId;
-                    lastSpoolId = activeSpoolId;
-                    
-                    // Read complete JSON data for web interface display
-                    Serial.println("FAST-PATH: Reading complete JSON data for web interface...");
-                    if (readCompleteJsonForFastPath()) {
-                        Serial.println("✓ FAST-PATH: Complete JSON data loaded for web interface");
-                    } else {
-                        Serial.println("⚠ FAST-PATH: Could not read complete JSON, web interface may show limited data");
-                    }
-                    
-                    oledShowProgressBar(2, octoEnabled?5:4, "Known Spool", "Quick mode");
-                    Serial.println("✓ FAST-PATH SUCCESS: Known spool processed quickly");
-                    return true;
-                } else {
-                    Serial.println("✗ FAST-PATH: sm_id is 0 - new brand filament, need full read");
-                    return false;
-                }
-            }
-        }
-        
-        Serial.println("✗ FAST-PATH: No sm_id pattern in extended read");
+    if (layout.payloadOffset >= sizeof(ndefData)) {
+        Serial.println("✗ FAST-PATH: JSON payload starts beyond quick read data");
         return false;
     }
     
-    // Extract JSON payload from the available data
+    // Extract the beginning of the JSON payload
     String quickJson = "";
-    for (int i = payloadOffset; i < 20 && i < payloadOffset + 15; i++) {
+    uint32_t quickEnd = min((uint32_t)sizeof(ndefData), layout.payloadOffset + layout.payloadLength);
+    for (uint32_t i = layout.payloadOffset; i < quickEnd && i < layout.payloadOffset + 32U; i++) {
         uint8_t currentByte = ndefData[i];
         if (currentByte >= 32 && currentByte <= 126) {
             quickJson += (char)currentByte;
@@ -2039,9 +1777,8 @@ bool quickSpoolIdCheck(String uidString) {
 void writeJsonToTag(void *parameter) {
   NfcWriteParameterType* params = (NfcWriteParameterType*)parameter;
 
-  // Gib die erstellte NDEF-Message aus
-  Serial.println("Erstelle NDEF-Message...");
-  Serial.println(params->payload);
+  Serial.printf("NDEF-Message bereit: %u Bytes (%s)\n", params->image.tlvLength,
+                ndefCapacityClassName(params->image.tlvLength));
 
   nfcReaderState = NFC_WRITING;
   nfcWriteInProgress = true; // Block high-level tag operations during write
@@ -2078,6 +1815,20 @@ void writeJsonToTag(void *parameter) {
             uidString += ":"; // Optional: Trennzeichen hinzufügen
         }
       }
+      if (params->skipUid.length() > 0 && uidString == params->skipUid) {
+        // Clone source is still on the reader - wait for the blank tag
+        uidString = "";
+        success = 0;
+        vTaskDelay(pdMS_TO_TICKS(100));
+        continue;
+      }
+      if (params->onlyUid.length() > 0 && uidString != params->onlyUid) {
+        // Spool was created for a different tag - keep waiting for that one
+        uidString = "";
+        success = 0;
+        vTaskDelay(pdMS_TO_TICKS(100));
+        continue;
+      }
       foundNfcTag(nullptr, success);
       break;
     }
@@ -2097,7 +1848,18 @@ void writeJsonToTag(void *parameter) {
 
     // Schreibe die NDEF-Message auf den Tag
     setLedDefaultPattern(LED_PATTERN_WRITING);
-    success = ntag2xx_WriteNDEF(params->payload);
+    unsigned long writeStartMs = millis();
+    success = ntag2xx_WriteNDEF(params->image);
+    if (params->cloneCopy) {
+      if (success) {
+        nfcCloneCopies++;
+        nfcCloneBytes += params->image.length;
+        nfcCloneWriteMs += millis() - writeStartMs;
+      } else {
+        nfcCloneFailures++;
+      }
+      sendCloneStatus();
+    }
     if (success) 
     {
       triggerLedPattern(LED_PATTERN_WRITE_SUCCESS, 1500);
@@ -2109,30 +1871,20 @@ void writeJsonToTag(void *parameter) {
         sendNfcData();
         pauseBambuMqttTask = false;
         
-        if(params->tagType){
+        if (params->cloneCopy) {
+          oledShowProgressBar(1, 1, "Clone", ("Copy " + String(nfcCloneCopies) + " done").c_str());
+        } else if(params->tagType){
           // TBD: should this be simplified?
-          if (updateSpoolTagId(uidString, params->payload) && params->tagType) {
+          if (updateSpoolTagId(uidString, params->spoolId)) {
             // Check if weight is over 20g and send to Spoolman
             if (weight > 20) {
               Serial.println("Tag successfully written and weight > 20g - sending weight to Spoolman");
-              
-              // Extract spool ID from payload for weight update
-              JsonDocument payloadDoc;
-              DeserializationError error = deserializeJson(payloadDoc, params->payload);
-              
-              if (!error && payloadDoc["sm_id"].is<String>()) {
-                String spoolId = payloadDoc["sm_id"].as<String>();
-                if (spoolId != "") {
-                  Serial.printf("Updating spool %s with weight %dg\n", spoolId.c_str(), weight);
-                  updateSpoolWeight(spoolId, weight);
-                } else {
-                  Serial.println("No valid spool ID found for weight update");
-                }
+              if (params->spoolId != "" && params->spoolId != "0") {
+                Serial.printf("Updating spool %s with weight %dg\n", params->spoolId.c_str(), weight);
+                updateSpoolWeight(params->spoolId, weight);
               } else {
-                Serial.println("Error parsing payload for spool ID extraction");
+                Serial.println("No valid spool ID found for weight update");
               }
-              
-              payloadDoc.clear();
             } else {
               Serial.printf("Weight %dg is not above 20g threshold - skipping weight update\n", weight);
             }
@@ -2143,81 +1895,26 @@ void writeJsonToTag(void *parameter) {
           oledShowProgressBar(1, 1, "Write Tag", "Done!");
         }
         
-        // CRITICAL: Properly stabilize NFC interface after write operation
-        Serial.println();
-        Serial.println("=== POST-WRITE NFC STABILIZATION ===");
-        
-        // Wait for tag operations to complete
-        vTaskDelay(500 / portTICK_PERIOD_MS);
-        
-        // Test tag presence and remove detection
-        uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };
-        uint8_t uidLength;
-        int tagRemovalChecks = 0;
-        
-        Serial.println("Waiting for tag removal...");
-        
-        // Monitor tag presence
-        while (tagRemovalChecks < 10) {
-          yield();
-          esp_task_wdt_reset();
-          
-          bool tagPresent = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 500);
-          
-          if (!tagPresent) {
-            Serial.println("✓ Tag removed - NFC ready for next scan");
-            break;
-          }
-          
-          tagRemovalChecks++;
-          Serial.print("Tag noch vorhanden (");
-          Serial.print(tagRemovalChecks);
-          Serial.println("/10)");
-          
-          vTaskDelay(500 / portTICK_PERIOD_MS);
-        }
-        
-        if (tagRemovalChecks >= 10) {
-          Serial.println("WARNUNG: Tag wurde nicht entfernt - fahre trotzdem fort");
-        }
-        
-        // Additional interface stabilization before resuming normal operations
-        Serial.println("Stabilisiere NFC-Interface für normale Operationen...");
-        vTaskDelay(200 / portTICK_PERIOD_MS);
-        
         // Test if interface is ready for normal scanning
-        uint8_t interfaceTestBuffer[4];
         bool interfaceReady = false;
-        
         for (int testAttempt = 0; testAttempt < 3; testAttempt++) {
-          // Try a simple interface operation (without requiring tag presence)
-          Serial.print("Interface readiness test ");
-          Serial.print(testAttempt + 1);
-          Serial.print("/3... ");
-          
           // Use a safe read operation that doesn't depend on tag presence
-          // This tests if the PN532 chip itself is responsive
-          uint32_t versiondata = nfc.getFirmwareVersion();
-          if (versiondata != 0) {
-            Serial.println("✓");
+          // This tests if the reader chip itself is responsive
+          if (nfc.getFirmwareVersion() != 0) {
             interfaceReady = true;
             break;
-          } else {
-            Serial.println("❌");
-            vTaskDelay(100 / portTICK_PERIOD_MS);
           }
+          vTaskDelay(100 / portTICK_PERIOD_MS);
         }
-        
         if (!interfaceReady) {
           Serial.println("WARNUNG: NFC-Interface reagiert nicht - könnte normale Scans beeinträchtigen");
-        } else {
-          Serial.println("✓ NFC-Interface ist bereit für normale Scans");
         }
-        
-        Serial.println("=========================================");
-        
-        vTaskResume(RfidReaderTask);
-        vTaskDelay(500 / portTICK_PERIOD_MS);        
+
+        // The written tag is most likely still on the reader. Hand it over to the scan
+        // state machine, which waits for its removal without reading it back.
+        nfcScanHandoverUid = uidString;
+        nfcScanHandoverPending = true;
+
     } 
     else 
     {
@@ -2251,80 +1948,18 @@ void writeJsonToTag(void *parameter) {
   updateQueueLedState();
   pauseBambuMqttTask = false;
 
-  free(params->payload);
+  free(params->image.data);
   delete params;
 
   vTaskDelete(NULL);
 }
 
-// Ensures sm_id is always the first key in JSON for fast-path detection
-String optimizeJsonForFastPath(const char* payload) {
-    JsonDocument inputDoc;
-    DeserializationError error = deserializeJson(inputDoc, payload);
-    
-    if (error) {
-        Serial.print("JSON optimization failed: ");
-        Serial.println(error.c_str());
-        return String(payload); // Return original if parsing fails
-    }
-    
-    // Create optimized JSON with sm_id first
-    JsonDocument optimizedDoc;
-    
-    // Always add sm_id first (even if it's "0" for brand filaments)
-    if (inputDoc["sm_id"].is<String>()) {
-        optimizedDoc["sm_id"] = inputDoc["sm_id"].as<String>();
-        Serial.print("Optimizing JSON: sm_id found = ");
-        Serial.println(inputDoc["sm_id"].as<String>());
-    } else {
-        optimizedDoc["sm_id"] = "0"; // Default for brand filaments
-        Serial.println("Optimizing JSON: No sm_id found, setting to '0'");
-    }
-    
-    // Add all other keys in original order
-    for (JsonPair kv : inputDoc.as<JsonObject>()) {
-        String key = kv.key().c_str();
-        if (key != "sm_id") { // Skip sm_id as it's already added first
-            optimizedDoc[key] = kv.value();
-        }
-    }
-    
-    String optimizedJson;
-    serializeJson(optimizedDoc, optimizedJson);
-    
-    Serial.println("JSON optimized for fast-path detection:");
-    Serial.print("Original:  ");
-    Serial.println(payload);
-    Serial.print("Optimized: ");
-    Serial.println(optimizedJson);
-    
-    inputDoc.clear();
-    optimizedDoc.clear();
-    
-    return optimizedJson;
-}
-
     static void ensureWriteQueueInit() {
       if (writeQueueMutex == NULL) {
         writeQueueMutex = xSemaphoreCreateMutex();
       }
     }
 
-    static String extractSmId(const char* payload) {
-      DynamicJsonDocument doc(512);
-      DeserializationError error = deserializeJson(doc, payload);
-      if (error) {
-        return "";
-      }
-      if (doc["sm_id"].is<String>()) {
-        return doc["sm_id"].as<String>();
-      }
-      if (doc["sm_id"].is<int>()) {
-        return String(doc["sm_id"].as<int>());
-      }
-      return "";
-    }
-
     static size_t getWriteQueueSize() {
       ensureWriteQueueInit();
       size_t size = 0;
@@ -2373,7 +2008,7 @@ String optimizeJsonForFastPath(const char* payload) {
           oledShowProgressBar(1, 1, "Failure", reason);
           triggerLedPattern(LED_PATTERN_WRITE_FAILURE, 1500);
         }
-        free(entry->payload);
+        free(entry->image.data);
         delete entry;
       }
       queueOverwriteConfirmation = false;
@@ -2428,12 +2063,14 @@ String optimizeJsonForFastPath(const char* payload) {
       return true;
     }
 
-    static void enqueueWriteRequest(bool isSpoolTag, const char* payload) {
+    static void enqueueWriteRequest(bool isSpoolTag, const NdefImage& image, const String& spoolId, const String& onlyUid = "") {
       ensureWriteQueueInit();
       WriteQueueEntry* entry = new WriteQueueEntry();
       entry->isSpoolTag = isSpoolTag;
-      entry->payload = strdup(payload);
-      entry->spoolId = extractSmId(payload);
+      entry->image = image;
+      entry->spoolId = spoolId;
+      entry->cloneCopy = false;
+      entry->onlyUid = onlyUid;
       bool wasEmpty = true;
       if (xSemaphoreTake(writeQueueMutex, portMAX_DELAY) == pdTRUE) {
         wasEmpty = writeQueue.empty();
@@ -2447,6 +2084,30 @@ String optimizeJsonForFastPath(const char* payload) {
       }
     }
 
+    // Queues one copy of the clone image. The image stays owned by clone mode,
+    // each queue entry gets its own copy because the write task frees it.
+    static bool enqueueCloneCopy() {
+      NdefImage copy = nfcCloneImage;
+      copy.data = (uint8_t*)malloc(nfcCloneImage.length);
+      if (copy.data == NULL) {
+        Serial.println("Clone: not enough memory for image copy");
+        return false;
+      }
+      memcpy(copy.data, nfcCloneImage.data, nfcCloneImage.length);
+
+      ensureWriteQueueInit();
+      WriteQueueEntry* entry = new WriteQueueEntry();
+      entry->isSpoolTag = false;
+      entry->image = copy;
+      entry->cloneCopy = true;
+      entry->skipUid = nfcCloneSourceUid;
+      if (xSemaphoreTake(writeQueueMutex, portMAX_DELAY) == pdTRUE) {
+        writeQueue.push_back(entry);
+        xSemaphoreGive(writeQueueMutex);
+      }
+      return true;
+    }
+
     static void startNextWriteFromQueue() {
       if (writeWorkerActive) {
         return;
@@ -2467,7 +2128,11 @@ String optimizeJsonForFastPath(const char* payload) {
 
       NfcWriteParameterType* params = new NfcWriteParameterType();
       params->tagType = entry->isSpoolTag;
-      params->payload = entry->payload;
+      params->image = entry->image;
+      params->cloneCopy = entry->cloneCopy;
+      params->skipUid = entry->skipUid;
+      params->onlyUid = entry->onlyUid;
+      params->spoolId = entry->spoolId;
       delete entry;
 
       writeWorkerActive = true;
@@ -2486,8 +2151,11 @@ String optimizeJsonForFastPath(const char* payload) {
         if (xSemaphoreTake(writeQueueMutex, portMAX_DELAY) == pdTRUE) {
           WriteQueueEntry* retry   = new WriteQueueEntry();
           retry->isSpoolTag = params->tagType;
-          retry->payload = params->payload;
-          retry->spoolId = extractSmId(retry->payload);
+          retry->image = params->image;
+          retry->cloneCopy = params->cloneCopy;
+          retry->skipUid = params->skipUid;
+          retry->onlyUid = params->onlyUid;
+          retry->spoolId = params->spoolId;
           writeQueue.push_front(retry);
           xSemaphoreGive(writeQueueMutex);
         }
@@ -2498,112 +2166,485 @@ String optimizeJsonForFastPath(const char* payload) {
       }
     }
 
-    static void handleWriteQueueForTag(const String& detectedSmId) {
-      if (writeWorkerActive) {
-        return;
-      }
-      if (getWriteQueueSize() == 0) {
-        return;
-      }
+    static void handleWriteQueueForTag(const String& detectedSmId) {
+      if (writeWorkerActive) {
+        return;
+      }
+      if (getWriteQueueSize() == 0) {
+        return;
+      }
+
+      String nextSmId = peekWriteQueueSmId();
+      if (nextSmId.length() > 0 && detectedSmId.length() > 0 && nextSmId.equalsIgnoreCase(detectedSmId)) {
+        if (!queueOverwriteConfirmation) {
+          queueOverwriteConfirmation = true;
+          queueConfirmationStartMs = millis();
+          Serial.println("Queued tag matches existing spool - tap again to confirm overwrite");
+          oledShowProgressBar(1, 1, "Write Tag", "Confirm overwrite");
+          triggerLedPattern(LED_PATTERN_TAG_FOUND, 1200);
+          return;
+        }
+      }
+
+      queueOverwriteConfirmation = false;
+      queueConfirmationStartMs = 0;
+      startNextWriteFromQueue();
+    }
+
+void startWriteJsonToTag(const bool isSpoolTag, JsonObjectConst payload, const String& targetUid) {
+  // Single pass: reorder for the fast path and pick up sm_id for the queue
+  String optimizedPayload;
+  String spoolId = serializeFastPathJson(payload, optimizedPayload);
+  Serial.print("JSON optimized for fast-path detection: ");
+  Serial.println(optimizedPayload);
+
+  // Build the tag image now so the tag only has to stay on the reader for the transfer
+  NdefImage image;
+  if (!buildNdefImage(optimizedPayload, image)) {
+    Serial.println("!!!!!!!!!!!!!!!!!!!!!!!!");
+    if (image.tlvLength > ndefMaxCapacity()) {
+      Serial.println("FEHLER: Payload zu groß für jeden unterstützten Tag - Schreibauftrag abgelehnt");
+      Serial.printf("Payload: %u Bytes, NDEF-Nachricht: %u Bytes, Maximum (NTAG216): %u Bytes, Überschuss: %u Bytes\n",
+                    optimizedPayload.length(), image.tlvLength, ndefMaxCapacity(),
+                    image.tlvLength - ndefMaxCapacity());
+      oledShowProgressBar(1, 1, "Failure!", "Payload too large");
+    } else {
+      Serial.println("FEHLER: Nicht genug Speicher für NDEF-Image");
+      oledShowProgressBar(1, 1, "Failure!", "Memory error");
+    }
+    Serial.println("!!!!!!!!!!!!!!!!!!!!!!!!");
+    sendWriteResult(nullptr, 0);
+    return;
+  }
+
+  Serial.printf("NDEF image: %u bytes (%u pages), requires %s or larger\n",
+                image.tlvLength, image.length / 4, ndefCapacityClassName(image.tlvLength));
+
+  enqueueWriteRequest(isSpoolTag, image, spoolId, targetUid);
+  oledShowProgressBar(0, 1, "Write Tag", "Queued tag");
+  updateQueueLedState();
+}
+
+void startWriteJsonToTag(const bool isSpoolTag, const char* payload) {
+  JsonDocument doc;
+  DeserializationError error = deserializeJson(doc, payload);
+  if (error || !doc.is<JsonObject>()) {
+    Serial.print("startWriteJsonToTag: invalid payload JSON: ");
+    Serial.println(error.c_str());
+    oledShowProgressBar(1, 1, "Failure!", "Invalid payload");
+    return;
+  }
+  startWriteJsonToTag(isSpoolTag, doc.as<JsonObjectConst>());
+}
+
+// Safe tag detection with manual retry logic and short timeouts
+bool safeTagDetection(uint8_t* uid, uint8_t* uidLength, uint8_t attempts, uint16_t timeoutMs) {
+    for (uint8_t attempt = 0; attempt < attempts; attempt++) {
+      // Watchdog reset on each attempt
+      esp_task_wdt_reset();
+      yield();
+      // Ensure antenna is on before detection attempt
+    #ifdef USE_RC522
+      rfid.PCD_AntennaOn();
+
+      // Only print attempt diagnostics when PICC presence is detected
+      if (kNfcDiagnosticsEnabled) {
+        bool prelim = rfid.PICC_IsNewCardPresent();
+        if (prelim) {
+          byte vr = rfid.PCD_ReadRegister(rfid.VersionReg);
+          Serial.print("[DBG] safeTagDetection attempt "); Serial.print(attempt+1);
+          Serial.print(" VersionReg=0x"); Serial.print(vr, HEX);
+          Serial.print(" PICC_IsNewCardPresent="); Serial.print(prelim);
+          Serial.println();
+        }
+      }
+    #else
+      // For PN532 just ensure SAM is configured (no explicit antenna control)
+      nfc.SAMConfig();
+    #endif
+
+      // Use timeout to wait for tag
+      bool success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, timeoutMs);
+        
+        if (success) {
+            if (kNfcDiagnosticsEnabled) {
+              Serial.printf("✓ Tag detected on attempt %d with %dms timeout\n", attempt + 1, timeoutMs);
+            }
+            return true;
+        }
+        
+        // Refresh RF field between attempts. A failed final attempt needs no extra
+        // reset: every detection starts with a fresh PCD_Init / SAMConfig anyway.
+        if (attempt < attempts - 1) {
+          vTaskDelay(pdMS_TO_TICKS(25));
+          // Reconfigure SAM briefly to refresh RF field
+          nfc.SAMConfig();
+          vTaskDelay(pdMS_TO_TICKS(10));
+#ifdef USE_RC522
+          // Try a soft reset of the RC522 hardware registers without dumping registers
+          rfid.PCD_Reset();
+          vTaskDelay(pdMS_TO_TICKS(20));
+          rfid.PCD_Init(); // Re-init to restore timer/modulation settings
+          rfid.PCD_SetAntennaGain(rfid.RxGain_43dB); // Restore gain
+#endif
+        }
+#ifdef USE_RC522
+        else if (kNfcDiagnosticsEnabled) {
+          nfc.dumpRegisters("safeTagDetection final attempt");
+        }
+#endif
+    }
+    
+    return false;
+}
+
+static String uidToString(const uint8_t* uid, uint8_t uidLength) {
+  String uidString = "";
+  for (uint8_t i = 0; i < uidLength; i++) {
+    //TBD: Rework to remove all the string operations
+    uidString += String(uid[i], HEX);
+    if (i < uidLength - 1) {
+        uidString += ":"; // Optional: Trennzeichen hinzufügen
+    }
+  }
+  return uidString;
+}
+
+// Release the tag after processing. Detection re-initialises the PCD and toggles the
+// antenna on every call, so halting the PICC is enough to get a clean next detection.
+static void releaseTag() {
+#ifdef USE_RC522
+  rfid.PICC_HaltA();
+  rfid.PCD_StopCrypto1();
+  rfid.uid.size = 0;
+#else
+  nfc.SAMConfig();
+#endif
+}
+
+static void handleTagRemoved() {
+  nfcReaderState = NFC_IDLE;
+  nfcMigrateUid = "";
+  clearTagRetry();
+  nfcJsonData = "";
+  activeSpoolId = "";
+  Serial.println("Tag removed - ready for next scan");
+  updateQueueLedState();
+  if (!bambuCredentials.autosend_enable) oledShowWeight(weight);
+}
+
+// A tag that needed the full read is a migration candidate if its content in the
+// configured target layout differs from what is stored on it.
+static void prepareTagMigration(const String& uidString) {
+  nfcMigrateUid = "";
+  if (nfcMigrateMode == NFC_MIGRATE_OFF || !lastTagRecord.isKnownSpool()) {
+    return;
+  }
+  // Bytes were skipped while decoding (e.g. UTF-8 names on a tag without CRC): a
+  // rewrite would lose them for good
+  if (nfcRawPayloadLossy) {
+    Serial.println("Tag migration skipped - payload contains bytes the decoder dropped");
+    return;
+  }
+
+  JsonDocument doc;
+  if (deserializeJson(doc, nfcRawPayload) || !doc.is<JsonObject>()) {
+    return;
+  }
+
+  String target;
+  if (nfcMigrateMode == NFC_MIGRATE_COMPACT) {
+    // Reduced layout of createSpool() plus what AMS tray assignment reads from the tag
+    static const char* const compactKeys[] = {
+      "b", "cn", "an", "type", "color_hex", "brand", "brand_name",
+      "min_temp", "max_temp", "drying_temp", "drying_time"
+    };
+    JsonDocument compact;
+    compact["sm_id"] = lastTagRecord.smId;
+    for (const char* key : compactKeys) {
+      if (!doc[key].isNull()) compact[key] = doc[key];
+    }
+    serializeFastPathJson(compact.as<JsonObjectConst>(), target);
+  } else {
+    serializeFastPathJson(doc.as<JsonObjectConst>(), target);
+  }
+
+  if (target == nfcRawPayload) {
+    return;
+  }
+
+  for (const NfcMigrateAttempt& attempt : nfcMigrateHistory) {
+    if (attempt.uid == uidString && (millis() - attempt.lastAttemptMs) < NFC_MIGRATE_RETRY_MS) {
+      Serial.println("Tag migration skipped - rate limited for this UID");
+      return;
+    }
+  }
+
+  nfcMigrateUid = uidString;
+  nfcMigrateJson = target;
+  nfcMigrateOriginal = nfcRawPayload;
+  nfcMigrateReadyMs = millis() + nfcScanTimings.migrateDwellMs;
+  Serial.printf("Legacy tag layout detected - migration scheduled (%s)\n",
+                nfcMigrateMode == NFC_MIGRATE_COMPACT ? "compact" : "fast-path");
+}
+
+static void noteTagMigrationAttempt(const String& uidString) {
+  NfcMigrateAttempt* slot = &nfcMigrateHistory[0];
+  for (NfcMigrateAttempt& attempt : nfcMigrateHistory) {
+    if (attempt.uid == uidString) {
+      slot = &attempt;
+      break;
+    }
+    if (attempt.lastAttemptMs < slot->lastAttemptMs) {
+      slot = &attempt;
+    }
+  }
+  slot->uid = uidString;
+  slot->lastAttemptMs = millis();
+}
+
+// Runs in the scan task while the candidate tag is selected and nothing else uses
+// the reader. The spool reference is unchanged, so Spoolman needs no update.
+static void migrateTagLayout() {
+  if (nfcMigrateUid.length() == 0 || (long)(millis() - nfcMigrateReadyMs) < 0) {
+    return;
+  }
+  if (nfcReaderState != NFC_READ_SUCCESS || writeWorkerActive || getWriteQueueSize() > 0 ||
+      spoolmanApiState == API_TRANSMITTING) {
+    return;
+  }
+
+  String uidString = nfcMigrateUid;
+  nfcMigrateUid = "";
+  noteTagMigrationAttempt(uidString);
+
+  NdefImage image;
+  if (!buildNdefImage(nfcMigrateJson, image)) {
+    return;
+  }
+
+  Serial.printf("Migrating tag %s to %s layout (%u -> %u bytes)\n", uidString.c_str(),
+                nfcMigrateMode == NFC_MIGRATE_COMPACT ? "compact" : "fast-path",
+                nfcMigrateOriginal.length(), nfcMigrateJson.length());
+
+  nfcWriteInProgress = true;
+  bool migrated = ntag2xx_WriteNDEF(image);
+  free(image.data);
+
+  if (!migrated) {
+    // Put the old content back so an interrupted rewrite does not leave a broken tag
+    Serial.println("Tag migration failed - restoring original layout");
+    NdefImage original;
+    if (buildNdefImage(nfcMigrateOriginal, original)) {
+      if (!ntag2xx_WriteNDEF(original)) {
+        Serial.println("WARNUNG: Original konnte nicht wiederhergestellt werden");
+      }
+      free(original.data);
+    }
+    nfcMigrateFailed++;
+  } else {
+    nfcMigrateDone++;
+    Serial.println("✓ Tag migrated - next read uses the fast path");
+  }
+  nfcWriteInProgress = false;
+}
+
+// Scan task only: frees the clone image once start/stop asked for it
+static void releaseCloneImageIfPending() {
+  if (!nfcCloneReleasePending) return;
+  nfcCloneReleasePending = false;
+  free(nfcCloneImage.data);
+  nfcCloneImage = { NULL, 0, 0 };
+  nfcCloneSourceUid = "";
+}
 
-      String nextSmId = peekWriteQueueSmId();
-      if (nextSmId.length() > 0 && detectedSmId.length() > 0 && nextSmId.equalsIgnoreCase(detectedSmId)) {
-        if (!queueOverwriteConfirmation) {
-          queueOverwriteConfirmation = true;
-          queueConfirmationStartMs = millis();
-          Serial.println("Queued tag matches existing spool - tap again to confirm overwrite");
-          oledShowProgressBar(1, 1, "Write Tag", "Confirm overwrite");
-          triggerLedPattern(LED_PATTERN_TAG_FOUND, 1200);
-          return;
-        }
-      }
+// Clone mode: capture the source tag's NDEF area (up to the terminator TLV) as a raw
+// page image. Pages after the terminator are unused and not copied.
+static void captureCloneSource(const String& uidString) {
+  unsigned long readStart = millis();
+  uint16_t length = 0;
+  uint8_t* data = readNdefMessage(readTagSize(), length);
+  uint16_t span = (data != NULL) ? ndefMessageSpan(data, length) : 0;
+
+  NdefRecordLayout layout;
+  if (span == 0 || span > length || !parseNdefRecordLayout(data, length, layout) ||
+      (layout.hasCrc && !ndefPayloadCrcValid(data, layout))) {
+    free(data);
+    Serial.println("Clone: source tag has no valid NDEF message");
+    oledShowProgressBar(1, 1, "Clone", "Source unreadable");
+    triggerLedPattern(LED_PATTERN_WRITE_FAILURE, 1200);
+    nfcReaderState = NFC_READ_ERROR;
+    return;
+  }
 
-      queueOverwriteConfirmation = false;
-      queueConfirmationStartMs = 0;
-      startNextWriteFromQueue();
-    }
+  // The read buffer is page aligned and at least span bytes long, keep it as the image
+  nfcCloneReleasePending = false;  // the old image is freed right here
+  free(nfcCloneImage.data);
+  nfcCloneImage.data = data;
+  nfcCloneImage.tlvLength = span;
+  nfcCloneImage.length = (span + 3) & ~3U;
+  nfcCloneSourceUid = uidString;
+  nfcCloneReadMs = millis() - readStart;
+  nfcCloneState = NFC_CLONE_ACTIVE;
+
+  Serial.printf("Clone: source %s captured, %u bytes (%u pages) in %lu ms\n", uidString.c_str(),
+                nfcCloneImage.tlvLength, nfcCloneImage.length / 4, (unsigned long)nfcCloneReadMs);
+  oledShowProgressBar(1, 1, "Clone", "Present blank tag");
+  triggerLedPattern(LED_PATTERN_TAG_FOUND, 1200);
+  nfcReaderState = NFC_READ_SUCCESS;
+  sendCloneStatus();
+}
 
-void startWriteJsonToTag(const bool isSpoolTag, const char* payload) {
-  String optimizedPayload = optimizeJsonForFastPath(payload);
-  enqueueWriteRequest(isSpoolTag, optimizedPayload.c_str());
-  if (nfcReaderState == NFC_IDLE || nfcReaderState == NFC_READ_ERROR || nfcReaderState == NFC_READ_SUCCESS) {
-    oledShowProgressBar(0, 1, "Write Tag", "Queued tag");
-  } else {
-    oledShowProgressBar(0, 1, "Write Tag", "Queued tag");
+// Blank = no NDEF message TLV, an empty one, or a single empty record
+static bool isBlankTag() {
+  uint8_t block[16];
+  if (!readTagBlock(4, block)) {
+    for (uint8_t page = 0; page < 4; page++) {
+      if (!robustPageRead(4 + page, block + page * 4)) return false;
+    }
   }
-  updateQueueLedState();
+  int tlvOffset = ndefFindMessageTlv(block, sizeof(block));
+  if (tlvOffset < 0 || tlvOffset + 2 >= (int)sizeof(block)) return true;
+  uint8_t messageLength = block[tlvOffset + 1];
+  if (messageLength == 0) return true;
+  return messageLength == 3 && (block[tlvOffset + 2] & 0x07) == 0x00; // TNF empty
 }
 
-// Safe tag detection with manual retry logic and short timeouts
-bool safeTagDetection(uint8_t* uid, uint8_t* uidLength) {
-    const int MAX_ATTEMPTS = 3;
-  const int SHORT_TIMEOUT = 400; // Increase timeout to improve tag read reliability
-    
-    for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
-      // Watchdog reset on each attempt
-      esp_task_wdt_reset();
-      yield();
-      // Ensure antenna is on before detection attempt
-    #ifdef USE_RC522
-      rfid.PCD_AntennaOn();
+static void handleCloneTarget(const String& uidString) {
+  if (uidString == nfcCloneSourceUid) {
+    nfcReaderState = NFC_READ_SUCCESS;
+    return;
+  }
+  if (!isBlankTag()) {
+    Serial.println("Clone: tag is not blank - skipped");
+    oledShowProgressBar(1, 1, "Clone", "Tag not blank");
+    triggerLedPattern(LED_PATTERN_WRITE_FAILURE, 1200);
+    nfcReaderState = NFC_READ_ERROR;
+    return;
+  }
+  if (writeWorkerActive || !enqueueCloneCopy()) {
+    nfcReaderState = NFC_READ_ERROR;
+    return;
+  }
+  startNextWriteFromQueue();
+}
 
-      // Only print attempt diagnostics when PICC presence is detected
-      bool prelim = rfid.PICC_IsNewCardPresent();
-      if (prelim && kNfcDiagnosticsEnabled) {
-        byte vr = rfid.PCD_ReadRegister(rfid.VersionReg);
-        Serial.print("[DBG] safeTagDetection attempt "); Serial.print(attempt+1);
-        Serial.print(" VersionReg=0x"); Serial.print(vr, HEX);
-        Serial.print(" PICC_IsNewCardPresent="); Serial.print(prelim);
-        Serial.println();
+// Reading state: fast-path check first, full NDEF read as fallback.
+// Leaves nfcReaderState at NFC_READ_SUCCESS or NFC_READ_ERROR.
+static void readDetectedTag(const uint8_t* uid, uint8_t uidLength, const String& uidString) {
+  // ONE-SHOT DEBUG: Print concise UID and pages 3/4 (single line per detection)
+  if (kNfcDiagnosticsEnabled) {
+    uint8_t p3[4] = {0,0,0,0};
+    uint8_t p4[4] = {0,0,0,0};
+    bool p3ok = nfc.ntag2xx_ReadPage(3, p3);
+    bool p4ok = nfc.ntag2xx_ReadPage(4, p4);
+
+    Serial.print("[ONE-SHOT] UID=");
+    for (uint8_t i = 0; i < uidLength; i++) {
+      if (uid[i] < 0x10) Serial.print("0");
+      Serial.print(uid[i], HEX);
+      if (i < uidLength - 1) Serial.print(" ");
+    }
+    Serial.print(" | P3=");
+    if (p3ok) {
+      for (int j = 0; j < 4; j++) {
+        if (p3[j] < 0x10) Serial.print("0");
+        Serial.print(p3[j], HEX);
       }
-    #else
-      // For PN532 just ensure SAM is configured (no explicit antenna control)
-      nfc.SAMConfig();
-    #endif
+    } else {
+      Serial.print("ERR");
+    }
+    Serial.print(" | P4=");
+    if (p4ok) {
+      for (int j = 0; j < 4; j++) {
+        if (p4[j] < 0x10) Serial.print("0");
+        Serial.print(p4[j], HEX);
+      }
+    } else {
+      Serial.print("ERR");
+    }
+    Serial.println();
+  }
 
-      // Use timeout to wait for tag
-      bool success = nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, uidLength, SHORT_TIMEOUT);
-        
-        if (success) {
-            if (kNfcDiagnosticsEnabled) {
-              Serial.printf("✓ Tag detected on attempt %d with %dms timeout\n", attempt + 1, SHORT_TIMEOUT);
-            }
-            return true;
-        }
-        
-        // Short pause between attempts
-        vTaskDelay(pdMS_TO_TICKS(25));
-        
-        // Refresh RF field after failed attempt (do heavier diagnostics only on last attempt)
-        if (attempt < MAX_ATTEMPTS - 1) {
-          // Reconfigure SAM briefly to refresh RF field
-          nfc.SAMConfig();
-          vTaskDelay(pdMS_TO_TICKS(10));
-#ifdef USE_RC522
-          // Try a soft reset of the RC522 hardware registers without dumping registers
-          rfid.PCD_Reset();
-          vTaskDelay(pdMS_TO_TICKS(20));
-          rfid.PCD_Init(); // Re-init to restore timer/modulation settings
-          rfid.PCD_SetAntennaGain(rfid.RxGain_43dB); // Restore gain
-          // rfid.PCD_AntennaOn(); // PCD_Init enables antenna
-#endif
-        } else {
-          // On final failure do a single register dump for diagnostics
-          nfc.SAMConfig();
-          vTaskDelay(pdMS_TO_TICKS(10));
-#ifdef USE_RC522
-          if (kNfcDiagnosticsEnabled) {
-            nfc.dumpRegisters("safeTagDetection after SAMConfig");
-          }
-          rfid.PCD_Reset();
-          // give the chip a bit more time here before re-enabling the antenna
-          vTaskDelay(pdMS_TO_TICKS(150));
-          rfid.PCD_AntennaOn();
-#endif
-        }
+  if (uidLength != 7)
+  {
+    //TBD: Show error here?!
+    oledShowProgressBar(1, 1, "Failure", "Unkown tag type");
+    Serial.println("This doesn't seem to be an NTAG2xx tag (UUID length != 7 bytes)!");
+    // Reset activeSpoolId when tag type is unknown to prevent autoSet
+    activeSpoolId = "";
+    nfcReaderState = NFC_READ_ERROR;
+    Serial.println("Unknown tag type - activeSpoolId reset to prevent autoSet");
+    return;
+  }
+
+  // Try fast-path detection first for known spools
+  if (quickSpoolIdCheck(uidString)) {
+    Serial.println("✓ FAST-PATH: Tag processed quickly, skipping full read");
+    pauseBambuMqttTask = false;
+    triggerLedPattern(LED_PATTERN_TAG_FOUND, 1200);
+    nfcReaderState = NFC_READ_SUCCESS;
+    handleWriteQueueForTag(activeSpoolId);
+    // Try to queue tag for AMS tray assignment if empty tray available
+    tryQueueTagForAmsTray();
+    return;
+  }
+
+  Serial.println("Continuing with full tag read after fast-path check");
+
+  uint16_t tagSize = readTagSize();
+  if (handleAmsReadTimeout()) {
+    return;
+  }
+  if (tagSize == 0)
+  {
+    oledShowProgressBar(1, 1, "Failure", "Tag read error");
+    triggerLedPattern(LED_PATTERN_WRITE_FAILURE, 1200);
+    nfcReaderState = NFC_READ_ERROR;
+    // Reset activeSpoolId when tag reading fails to prevent autoSet
+    activeSpoolId = "";
+    Serial.println("Tag read failed - activeSpoolId reset to prevent autoSet");
+    return;
+  }
+
+  // We probably have an NTAG2xx card (though it could be Ultralight as well)
+  Serial.println("Seems to be an NTAG2xx tag (7 byte UID)");
+  Serial.print("Tag size: ");
+  Serial.print(tagSize);
+  Serial.println(" bytes");
+
+  uint16_t length = 0;
+  uint8_t* data = readNdefMessage(tagSize, length);
+  if (data == NULL || handleAmsReadTimeout()) {
+    free(data);
+    if (nfcReaderState == NFC_READING) {
+      oledShowProgressBar(1, 1, "Failure", "Tag read error");
+      triggerLedPattern(LED_PATTERN_WRITE_FAILURE, 1200);
+      nfcReaderState = NFC_READ_ERROR;
+      activeSpoolId = "";
     }
-    
-    return false;
+    return;
+  }
+
+  Serial.println("Tag reading completed, starting NDEF decode...");
+  
+  if (!decodeNdefAndReturnJson(data, length, uidString)) 
+  {
+    oledShowProgressBar(1, 1, "Failure", "Unknown tag");
+    triggerLedPattern(LED_PATTERN_WRITE_FAILURE, 1200);
+    nfcReaderState = NFC_READ_ERROR;
+  }
+  else 
+  {
+    triggerLedPattern(LED_PATTERN_TAG_FOUND, 1200);
+    nfcReaderState = NFC_READ_SUCCESS;
+    prepareTagMigration(uidString);
+    handleWriteQueueForTag(activeSpoolId);
+    // Try to queue tag for AMS tray assignment if empty tray available
+    tryQueueTagForAmsTray();
+  }
+
+  free(data);
 }
 
 void scanRfidTask(void * parameter) {
@@ -2615,12 +2656,18 @@ void scanRfidTask(void * parameter) {
     vTaskDelay(pdMS_TO_TICKS(500));
   }
   Serial.println("Boot complete, NFC scanning starting");
+
+  uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };  // UID of the tag currently handled
+  uint8_t uidLength = 0;
+  String uidString = "";
+  uint8_t removalMisses = 0;
   
   for(;;) {
     // Regular watchdog reset
     esp_task_wdt_reset();
     yield();
 
+    releaseCloneImageIfPending();
     checkWriteQueueConfirmationTimeout();
 
         // Quick sample diagnostics every 1s to help when no tags are being detected
@@ -2644,6 +2691,7 @@ void scanRfidTask(void * parameter) {
       lastDiag = now;
       if (kNfcDiagnosticsEnabled) {
         Serial.print("[DIAG] nfcReaderState="); Serial.print((int)nfcReaderState);
+        Serial.print(" scanState="); Serial.print((int)nfcScanState);
         Serial.print(" writeInProgress="); Serial.print(nfcWriteInProgress);
         Serial.print(" suspendReq="); Serial.print(nfcReadingTaskSuspendRequest);
         Serial.print(" suspendState="); Serial.println(nfcReadingTaskSuspendState);
@@ -2688,305 +2736,270 @@ void scanRfidTask(void * parameter) {
     }
     
     // Skip scanning during write operations, but keep NFC interface active
-    if (nfcReaderState != NFC_WRITING && !nfcWriteInProgress && !nfcReadingTaskSuspendRequest)
+    if (nfcReaderState == NFC_WRITING || nfcWriteInProgress || nfcReadingTaskSuspendRequest)
     {
-      nfcReadingTaskSuspendState = false;
-      yield();
+      nfcReadingTaskSuspendState = true;
+      
+      // Different behavior for write protection vs. full suspension
+      if (nfcWriteInProgress) {
+        // During write: Just pause scanning, don't disable NFC interface
+        vTaskDelay(100 / portTICK_PERIOD_MS);
+      } else {
+        // Full suspension requested
+        if (kNfcDiagnosticsEnabled) Serial.println("NFC Reading disabled");
+        vTaskDelay(pdMS_TO_TICKS(nfcScanTimings.suspendPollMs));
+      }
+      continue;
+    }
+    nfcReadingTaskSuspendState = false;
 
-      uint8_t success;
-      uint8_t uid[] = { 0, 0, 0, 0, 0, 0, 0 };  // Buffer to store the returned UID
-      uint8_t uidLength;
+    // A finished write hands its tag over so it is not read back right away
+    if (nfcScanHandoverPending) {
+      nfcScanHandoverPending = false;
+      uidString = nfcScanHandoverUid;
+      removalMisses = 0;
+      nfcScanState = NFC_SCAN_AWAIT_REMOVAL;
+    }
 
-      // Use safe tag detection instead of blocking readPassiveTargetID
-      success = safeTagDetection(uid, &uidLength);
+    switch (nfcScanState) {
+      case NFC_SCAN_IDLE: {
+        bool success = safeTagDetection(uid, &uidLength, 1, nfcScanTimings.detectTimeoutMs);
+        foundNfcTag(nullptr, success);
 
-      foundNfcTag(nullptr, success);
-      
-      // Reset activeSpoolId immediately when no tag is detected to prevent stale autoSet
-      if (!success) {
-        activeSpoolId = "";
+        if (!success) {
+          // Reset activeSpoolId immediately when no tag is detected to prevent stale autoSet
+          activeSpoolId = "";
+          if (nfcReaderState != NFC_IDLE) handleTagRemoved();
+          sendNfcData();
+          vTaskDelay(pdMS_TO_TICKS(nfcScanTimings.idlePollMs));
+          break;
+        }
+
+        uidString = uidToString(uid, uidLength);
+        nfcScanState = NFC_SCAN_PRESENT;
+        break;
       }
-      
-      // As long as there is still a tag on the reader, do not try to read it again
-      if (success && nfcReaderState == NFC_IDLE)
-      {
+
+      case NFC_SCAN_PRESENT:
         // Set the current tag as not processed
         tagProcessed = false;
-
-        // Display some basic information about the card
         Serial.println("Found an ISO14443A card");
 
         nfcReaderState = NFC_READING;
+        sendNfcData();
         armAmsReadWatchdog();
-        if (handleAmsReadTimeout()) {
-          continue;
-        }
-
         oledShowProgressBar(0, octoEnabled?5:4, "Reading", "Detecting tag");
 
-        // Reduced stabilization time for better responsiveness
-        Serial.println("Tag detected, minimal stabilization...");
-        vTaskDelay(200 / portTICK_PERIOD_MS); // Reduced from 1000ms to 200ms
-
-        // create Tag UID string
-        String uidString = "";
-        for (uint8_t i = 0; i < uidLength; i++) {
-          //TBD: Rework to remove all the string operations
-          uidString += String(uid[i], HEX);
-          if (i < uidLength - 1) {
-              uidString += ":"; // Optional: Trennzeichen hinzufügen
-          }
-        }
-        
-        // ONE-SHOT DEBUG: Print concise UID and pages 3/4 (single line per detection)
-        {
-          uint8_t p3[4] = {0,0,0,0};
-          uint8_t p4[4] = {0,0,0,0};
-          bool p3ok = nfc.ntag2xx_ReadPage(3, p3);
-          bool p4ok = nfc.ntag2xx_ReadPage(4, p4);
-
-          Serial.print("[ONE-SHOT] UID=");
-          for (uint8_t i = 0; i < uidLength; i++) {
-            if (uid[i] < 0x10) Serial.print("0");
-            Serial.print(uid[i], HEX);
-            if (i < uidLength - 1) Serial.print(" ");
-          }
-          Serial.print(" | P3=");
-          if (p3ok) {
-            for (int j = 0; j < 4; j++) {
-              if (p3[j] < 0x10) Serial.print("0");
-              Serial.print(p3[j], HEX);
-            }
-          } else {
-            Serial.print("ERR");
-          }
-          Serial.print(" | P4=");
-          if (p4ok) {
-            for (int j = 0; j < 4; j++) {
-              if (p4[j] < 0x10) Serial.print("0");
-              Serial.print(p4[j], HEX);
-            }
-          } else {
-            Serial.print("ERR");
-          }
-          Serial.println();
+        if (nfcScanTimings.settleMs > 0) {
+          vTaskDelay(pdMS_TO_TICKS(nfcScanTimings.settleMs));
         }
-        if (uidLength == 7)
-        {
-          bool amsTimeout = false;
-          // Try fast-path detection first for known spools
-            if (quickSpoolIdCheck(uidString)) {
-              Serial.println("✓ FAST-PATH: Tag processed quickly, skipping full read");
-              pauseBambuMqttTask = false;
-              // Set reader back to idle for next scan
-              triggerLedPattern(LED_PATTERN_TAG_FOUND, 1200);
-              nfcReaderState = NFC_READ_SUCCESS;
-              handleWriteQueueForTag(activeSpoolId);
-              // Try to queue tag for AMS tray assignment if empty tray available
-              tryQueueTagForAmsTray();
-              disarmAmsReadWatchdog();
-      #ifdef USE_RC522
-              // Ensure tag is halted and MFRC522 crypto stopped so new tags can be detected
-              rfid.PICC_HaltA();
-              rfid.PCD_StopCrypto1();
-              rfid.uid.size = 0;
-              Serial.println("[CLEANUP] Fast-path: halted tag and cleared UID");
-              // Force a soft-reset + RF field toggle to ensure the RC522
-              // fully releases the tag and is ready for the next one.
-              rfid.PCD_Reset();
-              rfid.PCD_AntennaOff();
-              // Give the RF field time to collapse so the card truly leaves the field
-              vTaskDelay(pdMS_TO_TICKS(200));
-              rfid.PCD_AntennaOn();
-              // Re-init the RC522 to ensure internal state is cleared
-              rfid.PCD_Init();
-              // Allow the reader to stabilise after init
-              vTaskDelay(pdMS_TO_TICKS(150));
-              rfid.uid.size = 0;
-              Serial.println("[CLEANUP] Fast-path: forced reset, antenna toggle and re-init (long)");
-              // As a last-resort, perform a hardware-level power-cycle to ensure
-              // the RC522 internal state is fully cleared and the RF field is
-              // truly removed. This is heavy-handed but can fix modules that
-              // refuse to detect a subsequent tag.
-              nfc.hardwarePowerCycle();
-              delay(600); // Small delay before next scan
-      #else
-              // PN532 minimal cleanup: reconfigure SAM to refresh interface
-              nfc.SAMConfig();
-              vTaskDelay(pdMS_TO_TICKS(50));
-      #endif
-              continue; // Skip full tag reading and continue scan loop
-            }
+        nfcScanState = NFC_SCAN_READING;
+        break;
 
-          Serial.println("Continuing with full tag read after fast-path check");
+      case NFC_SCAN_READING:
+        if (nfcCloneState == NFC_CLONE_AWAIT_SOURCE) {
+          captureCloneSource(uidString);
+        } else if (nfcCloneState == NFC_CLONE_ACTIVE) {
+          handleCloneTarget(uidString);
+        } else if (!handleAmsReadTimeout()) {
+          readDetectedTag(uid, uidLength, uidString);
+        }
+        if (amsReadWatchdogArmed) {
+          disarmAmsReadWatchdog();
+        }
+        nfcScanState = NFC_SCAN_PROCESSED;
+        break;
 
-          uint16_t tagSize = readTagSize();
-          if (handleAmsReadTimeout()) {
-            continue;
-          }
-          if(tagSize > 0)
-          {
-            // Create a buffer depending on the size of the tag
-            uint8_t* data = (uint8_t*)malloc(tagSize);
-            memset(data, 0, tagSize);
-
-            // We probably have an NTAG2xx card (though it could be Ultralight as well)
-            Serial.println("Seems to be an NTAG2xx tag (7 byte UID)");
-            Serial.print("Tag size: ");
-            Serial.print(tagSize);
-            Serial.println(" bytes");
-            
-            uint8_t numPages = readTagSize()/4;
-            
-            for (uint8_t i = 4; i < 4+numPages; i++) {
-              if (handleAmsReadTimeout()) {
-                amsTimeout = true;
-                break;
-              }
-              
-              if (!robustPageRead(i, data+(i-4) * 4))
-              {
-                Serial.printf("Failed to read page %d after retries, stopping\n", i);
-                break; // Stop if reading fails after retries
-              }
-             
-              // Check for NDEF message end
-              if (data[(i - 4) * 4] == 0xFE) 
-              {
-                Serial.println("Found NDEF message end marker");
-                break; // End of NDEF message
-              }
+      case NFC_SCAN_PROCESSED:
+        releaseTag();
+        sendNfcData();
+        removalMisses = 0;
+        nfcScanState = NFC_SCAN_AWAIT_REMOVAL;
+        vTaskDelay(pdMS_TO_TICKS(nfcScanTimings.removalPollMs));
+        break;
 
-              yield();
-              esp_task_wdt_reset();
-              // Reduced delay for faster reading
-              vTaskDelay(pdMS_TO_TICKS(2)); // Reduced from 5ms to 2ms
-            }
-            
-            Serial.println("Tag reading completed, starting NDEF decode...");
-            
-            if (!decodeNdefAndReturnJson(data, uidString)) 
-            {
-              oledShowProgressBar(1, 1, "Failure", "Unknown tag");
-              triggerLedPattern(LED_PATTERN_WRITE_FAILURE, 1200);
-              nfcReaderState = NFC_READ_ERROR;
-            }
-            else 
-            {
-              triggerLedPattern(LED_PATTERN_TAG_FOUND, 1200);
-              nfcReaderState = NFC_READ_SUCCESS;
-              handleWriteQueueForTag(activeSpoolId);
-              // Try to queue tag for AMS tray assignment if empty tray available
-              tryQueueTagForAmsTray();
+      case NFC_SCAN_AWAIT_REMOVAL: {
+        uint8_t presentUid[] = { 0, 0, 0, 0, 0, 0, 0 };
+        uint8_t presentUidLength = 0;
+        bool present = safeTagDetection(presentUid, &presentUidLength, 1, nfcScanTimings.detectTimeoutMs);
+
+        if (present) {
+          String presentUidString = uidToString(presentUid, presentUidLength);
+          // A failed API call resets the reader state to request a retry, which
+          // waits for its backoff
+          bool retry = presentUidString == uidString && nfcReaderState == NFC_IDLE &&
+                       tagRetryDue(uidString);
+          if (presentUidString == uidString && !retry) {
+            // Same tag still on the reader - rewrite it if it is a pending legacy tag
+            removalMisses = 0;
+            if (nfcReaderState != NFC_IDLE && nfcMigrateUid == uidString) {
+              migrateTagLayout();
             }
-
-            free(data);;
-            // After finishing reading and processing, perform cleanup so the
-            // reader is ready to detect new tags. RC522 requires a heavier
-            // sequence; PN532 can use a lighter approach.
-#ifdef USE_RC522
-            // Halt tag and stop crypto for MFRC522
-            rfid.PICC_HaltA();
-            rfid.PCD_StopCrypto1();
-            rfid.uid.size = 0;
-            Serial.println("[CLEANUP] Full-read: halted tag and cleared UID");
-            // Force a soft-reset + RF field toggle to ensure the RC522
-            // fully releases the tag and is ready for the next one.
-            rfid.PCD_Reset();
-            rfid.PCD_AntennaOff();
-            // Give the RF field time to collapse so the card truly leaves the field
-            vTaskDelay(pdMS_TO_TICKS(200));
-            rfid.PCD_AntennaOn();
-            // Re-init the RC522 to ensure internal state is cleared
-            rfid.PCD_Init();
-            // Allow the reader to stabilise after init
-            vTaskDelay(pdMS_TO_TICKS(150));
-            rfid.uid.size = 0;
-            Serial.println("[CLEANUP] Full-read: forced reset, antenna toggle and re-init (long)");
-            // As a last-resort, perform a hardware-level power-cycle to ensure
-            // the RC522 internal state is fully cleared and the RF field is
-            // truly removed.
-            nfc.hardwarePowerCycle();
-#else
-            // PN532 minimal cleanup
-            nfc.SAMConfig();
-            vTaskDelay(pdMS_TO_TICKS(50));
-#endif
-          }
-          else
-          {
-            oledShowProgressBar(1, 1, "Failure", "Tag read error");
-            triggerLedPattern(LED_PATTERN_WRITE_FAILURE, 1200);
-            nfcReaderState = NFC_READ_ERROR;
-            // Reset activeSpoolId when tag reading fails to prevent autoSet
-            activeSpoolId = "";
-            Serial.println("Tag read failed - activeSpoolId reset to prevent autoSet");
+            releaseTag();
+            vTaskDelay(pdMS_TO_TICKS(nfcScanTimings.removalPollMs));
+            break;
           }
+
+          // A different tag replaced the previous one, or a retry is due
+          if (presentUidString != uidString) handleTagRemoved();
+          memcpy(uid, presentUid, sizeof(uid));
+          uidLength = presentUidLength;
+          uidString = presentUidString;
+          nfcScanState = NFC_SCAN_PRESENT;
+          break;
         }
-        else
-        {
-          //TBD: Show error here?!
-          oledShowProgressBar(1, 1, "Failure", "Unkown tag type");
-          Serial.println("This doesn't seem to be an NTAG2xx tag (UUID length != 7 bytes)!");
-          // Reset activeSpoolId when tag type is unknown to prevent autoSet
-          activeSpoolId = "";
-          Serial.println("Unknown tag type - activeSpoolId reset to prevent autoSet");
-        }
-        if (amsReadWatchdogArmed) {
-          disarmAmsReadWatchdog();
+
+        if (++removalMisses < nfcScanTimings.removalMisses) {
+          vTaskDelay(pdMS_TO_TICKS(nfcScanTimings.removalPollMs));
+          break;
         }
-      }
 
-      if (!success && nfcReaderState != NFC_IDLE && !nfcReadingTaskSuspendRequest)
-      {
-        nfcReaderState = NFC_IDLE;
-        //uidString = "";
-        nfcJsonData = "";
-        activeSpoolId = "";
-        Serial.println("Tag removed");
-        updateQueueLedState();
-        if (!bambuCredentials.autosend_enable) oledShowWeight(weight);
-      }
-      // Reset state after successful read when tag is removed
-      else if (!success && nfcReaderState == NFC_READ_SUCCESS)
-      {
-        nfcReaderState = NFC_IDLE;
-        Serial.println("Tag read successfully - ready for next scan");
+        foundNfcTag(nullptr, false);
+        handleTagRemoved();
+        sendNfcData();
+        uidString = "";
+        nfcScanState = NFC_SCAN_IDLE;
+        break;
       }
+    }
+    yield();
+  }
+}
 
-      // Add a pause after successful reading to prevent immediate re-reading
-      if (nfcReaderState == NFC_READ_SUCCESS) {
-        Serial.println("Tag erfolgreich gelesen - warte 3 Sekunden vor nächstem Scan");
-        vTaskDelay(3000 / portTICK_PERIOD_MS); // Reduced from 5 seconds to 3 seconds
-      } else {
-        // Faster scanning when no tag or idle state
-        vTaskDelay(150 / portTICK_PERIOD_MS); // Faster scan interval
-      }
+static void loadNfcScanTimings() {
+  Preferences preferences;
+  preferences.begin(NVS_NAMESPACE_NFC, true);
+  for (const NfcScanTimingKey& entry : nfcScanTimingKeys) {
+    uint16_t value = preferences.getUShort(entry.key, nfcScanTimings.*entry.field);
+    nfcScanTimings.*entry.field = constrain(value, entry.minValue, entry.maxValue);
+  }
+  nfcMigrateMode = (nfcMigrateModeType)constrain(
+    preferences.getUChar(NVS_KEY_NFC_MIGRATE_MODE, NFC_MIGRATE_OFF), NFC_MIGRATE_OFF, NFC_MIGRATE_COMPACT);
+  preferences.end();
+}
 
-      // aktualisieren der Website wenn sich der Status ändert
-      sendNfcData();
-    }
-    else
-    {
-      nfcReadingTaskSuspendState = true;
-      
-      // Different behavior for write protection vs. full suspension
-      if (nfcWriteInProgress) {
-        // During write: Just pause scanning, don't disable NFC interface
-        // Serial.println("NFC Scanning paused during write operation");
-        vTaskDelay(100 / portTICK_PERIOD_MS); // Shorter delay during write
-      } else {
-        // Full suspension requested
-        Serial.println("NFC Reading disabled");
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-      }
+bool isNfcScanTimingKey(const String& key) {
+  for (const NfcScanTimingKey& entry : nfcScanTimingKeys) {
+    if (key == entry.key) return true;
+  }
+  return false;
+}
+
+bool checkNfcScanTiming(const String& key, long value) {
+  for (const NfcScanTimingKey& entry : nfcScanTimingKeys) {
+    if (key != entry.key) continue;
+    if (value < (long)entry.minValue || value > (long)entry.maxValue) {
+      Serial.printf("NFC timing %s=%ld out of range (%u-%u)\n", entry.key, value, entry.minValue, entry.maxValue);
+      return false;
     }
-    yield();
+    return true;
+  }
+  return false;
+}
+
+bool saveNfcScanTiming(const String& key, uint16_t value) {
+  for (const NfcScanTimingKey& entry : nfcScanTimingKeys) {
+    if (key != entry.key) continue;
+    if (value < entry.minValue || value > entry.maxValue) {
+      Serial.printf("NFC timing %s=%u out of range (%u-%u)\n", entry.key, value, entry.minValue, entry.maxValue);
+      return false;
+    }
+    Preferences preferences;
+    preferences.begin(NVS_NAMESPACE_NFC, false);
+    preferences.putUShort(entry.key, value);
+    preferences.end();
+    nfcScanTimings.*entry.field = value;
+    return true;
+  }
+  return false;
+}
+
+String getNfcScanTimingsJson() {
+  JsonDocument doc;
+  for (const NfcScanTimingKey& entry : nfcScanTimingKeys) {
+    doc[entry.key] = nfcScanTimings.*entry.field;
+  }
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+bool saveNfcMigrateMode(uint8_t mode) {
+  if (mode > NFC_MIGRATE_COMPACT) {
+    return false;
   }
+  Preferences preferences;
+  preferences.begin(NVS_NAMESPACE_NFC, false);
+  preferences.putUChar(NVS_KEY_NFC_MIGRATE_MODE, mode);
+  preferences.end();
+  nfcMigrateMode = (nfcMigrateModeType)mode;
+  if (nfcMigrateMode == NFC_MIGRATE_OFF) {
+    nfcMigrateUid = "";
+  }
+  return true;
+}
+
+String getNfcMigrateStatsJson() {
+  JsonDocument doc;
+  doc["mode"] = (uint8_t)nfcMigrateMode;
+  doc["migrated"] = nfcMigrateDone;
+  doc["failed"] = nfcMigrateFailed;
+  String json;
+  serializeJson(doc, json);
+  return json;
+}
+
+bool startCloneMode() {
+  if (writeWorkerActive || getWriteQueueSize() > 0) {
+    Serial.println("Clone: write queue busy - clone mode not started");
+    return false;
+  }
+  // Set before the state: a capture that sees the new state also sees the request
+  nfcCloneReleasePending = true;
+  nfcCloneReadMs = 0;
+  nfcCloneCopies = 0;
+  nfcCloneFailures = 0;
+  nfcCloneBytes = 0;
+  nfcCloneWriteMs = 0;
+  nfcCloneState = NFC_CLONE_AWAIT_SOURCE;
+
+  Serial.println("Clone: present source tag");
+  oledShowProgressBar(0, 1, "Clone", "Present source tag");
+  sendCloneStatus();
+  return true;
+}
+
+void stopCloneMode() {
+  nfcCloneState = NFC_CLONE_OFF;
+  nfcCloneReleasePending = true;  // freed by the scan task, after any copy in progress
+  Serial.printf("Clone: stopped after %u copies\n", nfcCloneCopies);
+  oledShowProgressBar(1, 1, "Clone", "Stopped");
+  updateQueueLedState();
+  sendCloneStatus();
+}
+
+String getCloneStatusJson() {
+  JsonDocument doc;
+  const char* state = "off";
+  if (nfcCloneState == NFC_CLONE_AWAIT_SOURCE) state = "awaitSource";
+  else if (nfcCloneState == NFC_CLONE_ACTIVE) state = "active";
+  doc["state"] = state;
+  doc["source"] = nfcCloneSourceUid;
+  doc["bytes"] = nfcCloneImage.tlvLength;
+  doc["readMs"] = nfcCloneReadMs;
+  doc["copies"] = nfcCloneCopies;
+  doc["failed"] = nfcCloneFailures;
+  doc["avgWriteMs"] = nfcCloneCopies > 0 ? nfcCloneWriteMs / nfcCloneCopies : 0;
+  // bytes per second over pure transfer time of all copies
+  doc["bytesPerSec"] = nfcCloneWriteMs > 0 ? (uint32_t)((uint64_t)nfcCloneBytes * 1000 / nfcCloneWriteMs) : 0;
+  String json;
+  serializeJson(doc, json);
+  return json;
 }
 
 void startNfc() {
   oledShowProgressBar(5, 7, DISPLAY_BOOT_TEXT, "NFC init");
+  loadNfcScanTimings();
   Serial.println("NFC: begin() start");
   esp_task_wdt_reset();
   nfc.begin();                                           // Begin communication with NFC reader
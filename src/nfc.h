@@ -2,6 +2,7 @@
 #define NFC_H
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
 
 typedef enum{
     NFC_IDLE,
@@ -13,11 +14,34 @@ typedef enum{
     NFC_WRITE_ERROR
 } nfcReaderStateType;
 
+// Rewrite legacy tags in place while they rest on the reader
+typedef enum{
+    NFC_MIGRATE_OFF,
+    NFC_MIGRATE_FAST_PATH,   // same content, sm_id as first key
+    NFC_MIGRATE_COMPACT      // only sm_id, b and cn
+} nfcMigrateModeType;
+
 void startNfc();
 void scanRfidTask(void * parameter);
+// targetUid: only write to this tag (uid as "04:a1:..."), empty = first tag presented
+void startWriteJsonToTag(const bool isSpoolTag, JsonObjectConst payload, const String& targetUid = "");
 void startWriteJsonToTag(const bool isSpoolTag, const char* payload);
 bool quickSpoolIdCheck(String uidString);
 bool readCompleteJsonForFastPath(); // Read complete JSON data for fast-path web interface display
+bool isNfcScanTimingKey(const String& key);
+bool checkNfcScanTiming(const String& key, long value); // known key and value in range
+bool saveNfcScanTiming(const String& key, uint16_t value);
+String getNfcScanTimingsJson();
+bool saveNfcMigrateMode(uint8_t mode);
+String getNfcMigrateStatsJson();
+bool startCloneMode();
+void stopCloneMode();
+String getCloneStatusJson();
+#ifdef USE_RC522
+uint32_t getRc522SpiClock();
+bool saveRc522SpiClock(uint32_t clockHz);
+String getRc522SpiClockStatsJson();
+#endif
 
 extern TaskHandle_t RfidReaderTask;
 extern String nfcJsonData;
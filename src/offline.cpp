@@ -0,0 +1,288 @@
+#include "offline.h"
+#include <LittleFS.h>
+#include "commonFS.h"
+#include "config.h"
+#include <esp_random.h>
+
+// Log format, one JSON object per line:
+//   {"k":"1a2b3c4d-7","t":3,"m":"PUT","p":"/spool/12/measure","b":"{...}","c":"weight:12"}
+//   {"ack":"1a2b3c4d-7"}
+// Entries are never modified in place; the file is removed once every entry is acknowledged.
+
+static SemaphoreHandle_t offlineMutex = NULL;
+static uint32_t offlineBootId = 0;
+static uint32_t offlineSequence = 0;
+static uint16_t offlinePending = 0;
+static uint32_t offlineLogged = 0;
+static uint32_t offlineAcked = 0;
+
+static JsonDocument spoolMirror;    // {"<id>": {...}}, oldest entry first
+static bool spoolMirrorLoaded = false;
+
+class OfflineLock {
+public:
+    OfflineLock() { if (offlineMutex) xSemaphoreTake(offlineMutex, portMAX_DELAY); }
+    ~OfflineLock() { if (offlineMutex) xSemaphoreGive(offlineMutex); }
+};
+
+// Reads all log lines, drops acknowledged entries and keeps the newest entry per coalesce key.
+// Caller holds the lock.
+static size_t readPendingLocked(std::vector<OfflineUpdate>& updates) {
+    updates.clear();
+    File file = LittleFS.open(OFFLINE_LOG_FILE, "r");
+    if (!file) return 0;
+
+    std::vector<String> acked;
+    while (file.available()) {
+        String line = file.readStringUntil('\n');
+        line.trim();
+        if (line.length() == 0) continue;
+
+        JsonDocument doc;
+        if (deserializeJson(doc, line)) {
+            // Torn last line after a power loss
+            Serial.println("Offline log: skipping unreadable line");
+            continue;
+        }
+        if (doc["ack"].is<const char*>()) {
+            acked.push_back(doc["ack"].as<String>());
+            continue;
+        }
+
+        OfflineUpdate update;
+        update.key = doc["k"].as<String>();
+        update.requestType = doc["t"].as<uint8_t>();
+        update.method = doc["m"].as<String>();
+        update.path = doc["p"].as<String>();
+        update.payload = doc["b"].as<String>();
+        update.coalesceKey = doc["c"] | "";
+        updates.push_back(update);
+    }
+    file.close();
+
+    std::vector<OfflineUpdate> pending;
+    for (size_t i = 0; i < updates.size(); i++) {
+        bool skip = false;
+        for (const String& key : acked) {
+            if (key == updates[i].key) { skip = true; break; }
+        }
+        // A newer update with the same key supersedes this one
+        for (size_t j = i + 1; !skip && updates[i].coalesceKey.length() > 0 && j < updates.size(); j++) {
+            if (updates[j].coalesceKey == updates[i].coalesceKey) skip = true;
+        }
+        if (!skip) pending.push_back(updates[i]);
+    }
+    updates.swap(pending);
+    return updates.size();
+}
+
+static bool appendLineLocked(const JsonDocument& doc) {
+    File file = LittleFS.open(OFFLINE_LOG_FILE, "a");
+    if (!file) {
+        Serial.println("Offline log: cannot open " OFFLINE_LOG_FILE);
+        return false;
+    }
+    size_t written = serializeJson(doc, file);
+    written += file.print('\n');
+    file.close();
+    return written > 1;
+}
+
+// Rewrite the log with the pending entries only, or remove it if nothing is left
+static void compactLocked() {
+    std::vector<OfflineUpdate> pending;
+    readPendingLocked(pending);
+    offlinePending = pending.size();
+
+    if (pending.empty()) {
+        removeJsonValue(OFFLINE_LOG_FILE);
+        return;
+    }
+
+    LittleFS.remove(OFFLINE_LOG_FILE);
+    for (const OfflineUpdate& update : pending) {
+        JsonDocument doc;
+        doc["k"] = update.key;
+        doc["t"] = update.requestType;
+        doc["m"] = update.method;
+        doc["p"] = update.path;
+        doc["b"] = update.payload;
+        if (update.coalesceKey.length() > 0) doc["c"] = update.coalesceKey;
+        appendLineLocked(doc);
+    }
+}
+
+void initOfflineStore() {
+    if (offlineMutex == NULL) offlineMutex = xSemaphoreCreateMutex();
+    offlineBootId = esp_random();
+
+    OfflineLock lock;
+    compactLocked();
+    if (offlinePending > 0) {
+        Serial.printf("Offline log: %u pending Spoolman updates\n", offlinePending);
+    }
+
+    if (!spoolMirrorLoaded) {
+        if (!LittleFS.exists(OFFLINE_MIRROR_FILE) || !loadJsonValue(OFFLINE_MIRROR_FILE, spoolMirror)) {
+            spoolMirror.to<JsonObject>();
+        }
+        spoolMirrorLoaded = true;
+        Serial.printf("Spool mirror: %u spools\n", spoolMirror.as<JsonObject>().size());
+    }
+}
+
+bool offlineLogAppend(OfflineUpdate& update) {
+    OfflineLock lock;
+    if (offlinePending >= OFFLINE_LOG_MAX_ENTRIES) {
+        compactLocked();
+        if (offlinePending >= OFFLINE_LOG_MAX_ENTRIES) {
+            Serial.println("Offline log full, update dropped");
+            return false;
+        }
+    }
+
+    update.key = String(offlineBootId, HEX) + "-" + String(++offlineSequence);
+
+    JsonDocument doc;
+    doc["k"] = update.key;
+    doc["t"] = update.requestType;
+    doc["m"] = update.method;
+    doc["p"] = update.path;
+    doc["b"] = update.payload;
+    if (update.coalesceKey.length() > 0) doc["c"] = update.coalesceKey;
+
+    if (!appendLineLocked(doc)) return false;
+    offlinePending++;
+    offlineLogged++;
+    Serial.println("Offline log: queued " + update.method + " " + update.path + " (" + update.key + ")");
+    return true;
+}
+
+bool offlineLogAck(const String& key) {
+    OfflineLock lock;
+    JsonDocument doc;
+    doc["ack"] = key;
+    if (!appendLineLocked(doc)) return false;
+
+    offlineAcked++;
+    if (offlinePending > 0) offlinePending--;
+    // Superseded entries are not counted down individually, compaction settles the count
+    if (offlinePending == 0) compactLocked();
+    return true;
+}
+
+size_t offlineLogLoadPending(std::vector<OfflineUpdate>& updates) {
+    OfflineLock lock;
+    size_t count = readPendingLocked(updates);
+    offlinePending = count;
+    return count;
+}
+
+uint16_t offlineLogPendingCount() {
+    return offlinePending;
+}
+
+// #### Spool mirror
+static bool saveMirrorLocked() {
+    return saveJsonValue(OFFLINE_MIRROR_FILE, spoolMirror);
+}
+
+bool offlineMirrorUpdate(JsonObjectConst spool) {
+    if (!spoolMirrorLoaded || !spool["id"].is<uint16_t>()) return false;
+
+    String id = String(spool["id"].as<uint16_t>());
+    JsonObjectConst filament = spool["filament"];
+
+    JsonDocument fresh;
+    JsonObject entry = fresh.to<JsonObject>();
+    entry["n"] = filament["name"] | "";
+    entry["m"] = filament["material"] | "";
+    entry["v"] = filament["vendor"]["name"] | "";
+    entry["c"] = filament["color_hex"] | "";
+    entry["l"] = spool["location"] | "";
+    entry["sw"] = spool["spool_weight"].is<float>() ? spool["spool_weight"].as<float>() : (filament["spool_weight"] | 0.0f);
+    entry["iw"] = spool["initial_weight"].is<float>() ? spool["initial_weight"].as<float>() : (filament["weight"] | 0.0f);
+    entry["rw"] = spool["remaining_weight"] | 0.0f;
+
+    OfflineLock lock;
+    JsonObject mirror = spoolMirror.as<JsonObject>();
+    // Most responses repeat what is mirrored already, spare the flash
+    if (mirror[id].is<JsonObject>() && mirror[id].as<JsonObjectConst>() == JsonObjectConst(entry)) return true;
+
+    // Re-insert so the most recently changed spools stay at the end
+    mirror.remove(id);
+    while (mirror.size() >= OFFLINE_MIRROR_MAX_SPOOLS) {
+        String oldest = mirror.begin()->key().c_str();
+        mirror.remove(oldest);
+    }
+    mirror[id] = entry;
+
+    return saveMirrorLocked();
+}
+
+bool offlineMirrorGet(uint16_t spoolId, SpoolMirrorEntry& entry) {
+    OfflineLock lock;
+    JsonObjectConst mirrored = spoolMirror[String(spoolId)];
+    if (mirrored.isNull()) return false;
+
+    entry.id = spoolId;
+    entry.name = mirrored["n"] | "";
+    entry.material = mirrored["m"] | "";
+    entry.vendor = mirrored["v"] | "";
+    entry.colorHex = mirrored["c"] | "";
+    entry.location = mirrored["l"] | "";
+    entry.spoolWeight = mirrored["sw"] | 0.0f;
+    entry.initialWeight = mirrored["iw"] | 0.0f;
+    entry.remainingWeight = mirrored["rw"] | 0.0f;
+    return true;
+}
+
+bool offlineMirrorRemove(uint16_t spoolId) {
+    if (!spoolMirrorLoaded) return false;
+
+    String id = String(spoolId);
+    OfflineLock lock;
+    if (!spoolMirror[id].is<JsonObject>()) return false;
+    spoolMirror.remove(id);
+    return saveMirrorLocked();
+}
+
+// Same rule as Spoolman's /measure: remaining = measured - empty spool weight
+bool offlineMirrorApplyWeight(uint16_t spoolId, uint16_t measuredWeight, uint16_t& remaining) {
+    OfflineLock lock;
+    JsonObject mirrored = spoolMirror[String(spoolId)];
+    if (mirrored.isNull()) return false;
+
+    float net = (float)measuredWeight - (mirrored["sw"] | 0.0f);
+    if (net < 0) net = 0;
+    float initial = mirrored["iw"] | 0.0f;
+    if (initial > 0 && net > initial) net = initial;
+
+    mirrored["rw"] = net;
+    remaining = (uint16_t)(net + 0.5f);
+    return saveMirrorLocked();
+}
+
+bool offlineMirrorApplyLocation(uint16_t spoolId, const String& location) {
+    OfflineLock lock;
+    JsonObject mirrored = spoolMirror[String(spoolId)];
+    if (mirrored.isNull()) return false;
+
+    mirrored["l"] = location;
+    return saveMirrorLocked();
+}
+
+String getOfflineStatsJson() {
+    JsonDocument doc;
+    doc["pending"] = offlinePending;
+    doc["logged"] = offlineLogged;
+    doc["acked"] = offlineAcked;
+    {
+        OfflineLock lock;
+        doc["mirrored"] = spoolMirror.as<JsonObjectConst>().size();
+    }
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
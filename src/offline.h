@@ -0,0 +1,48 @@
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <vector>
+
+// One pending Spoolman update in the write-ahead log
+struct OfflineUpdate {
+    String key;             // idempotency key, acknowledged once Spoolman accepted it
+    uint8_t requestType;    // SpoolmanApiRequestType
+    String method;
+    String path;            // relative to spoolmanUrl + apiUrl
+    String payload;
+    String coalesceKey;     // only the newest entry per key is replayed
+};
+
+// Fields needed to keep identifying and weighing a spool while Spoolman is down
+struct SpoolMirrorEntry {
+    uint16_t id = 0;
+    String name;
+    String material;
+    String vendor;
+    String colorHex;
+    String location;
+    float spoolWeight = 0;
+    float initialWeight = 0;
+    float remainingWeight = 0;
+};
+
+void initOfflineStore();
+
+// Write-ahead log of Spoolman updates (LittleFS, append-only)
+bool offlineLogAppend(OfflineUpdate& update);
+bool offlineLogAck(const String& key);
+size_t offlineLogLoadPending(std::vector<OfflineUpdate>& updates);
+uint16_t offlineLogPendingCount();
+
+// Local spool mirror
+bool offlineMirrorUpdate(JsonObjectConst spool);
+bool offlineMirrorGet(uint16_t spoolId, SpoolMirrorEntry& entry);
+bool offlineMirrorRemove(uint16_t spoolId);
+bool offlineMirrorApplyWeight(uint16_t spoolId, uint16_t measuredWeight, uint16_t& remaining);
+bool offlineMirrorApplyLocation(uint16_t spoolId, const String& location);
+
+String getOfflineStatsJson();
+
+#endif
@@ -0,0 +1,244 @@
+#include "spool_cache.h"
+#include "config.h"
+
+// Small LRU of spools seen recently. Filled from every spool document Spoolman
+// returns (fetch, /measure, location and tag updates) and refreshed in the
+// background with conditional GETs, so the AMS path can read it without waiting.
+// While the Spoolman event connection is up, changes are applied as they are
+// pushed and entries do not age.
+
+struct SpoolCacheSlot {
+    CachedSpool spool;
+    unsigned long usedAt;
+};
+
+struct SpoolCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t stored;
+    uint32_t notModified;
+    uint32_t weightSkipped;
+    uint32_t pushed;
+};
+
+static SpoolCacheSlot spoolCache[SPOOL_CACHE_SIZE];
+static SpoolCacheStats spoolCacheStats = {};
+static SemaphoreHandle_t spoolCacheMutex = NULL;
+static volatile bool spoolCachePushMode = false;
+
+class SpoolCacheLock {
+public:
+    SpoolCacheLock() { if (spoolCacheMutex) xSemaphoreTake(spoolCacheMutex, portMAX_DELAY); }
+    ~SpoolCacheLock() { if (spoolCacheMutex) xSemaphoreGive(spoolCacheMutex); }
+};
+
+// Caller holds the lock
+static SpoolCacheSlot* findSlot(uint16_t spoolId) {
+    for (uint8_t i = 0; i < SPOOL_CACHE_SIZE; i++) {
+        if (spoolCache[i].spool.id == spoolId) return &spoolCache[i];
+    }
+    return nullptr;
+}
+
+// Free slot or least recently used one. Caller holds the lock.
+static SpoolCacheSlot* victimSlot() {
+    SpoolCacheSlot* victim = &spoolCache[0];
+    for (uint8_t i = 0; i < SPOOL_CACHE_SIZE; i++) {
+        if (spoolCache[i].spool.id == 0) return &spoolCache[i];
+        if (spoolCache[i].usedAt < victim->usedAt) victim = &spoolCache[i];
+    }
+    return victim;
+}
+
+// Filament part of a spool document, also sent on its own by filament change events
+static void fillFilamentFields(CachedSpool& entry, JsonObjectConst filament) {
+    JsonObjectConst extra = filament["extra"];
+
+    entry.filamentId = filament["id"] | 0;
+    entry.vendorId = filament["vendor"]["id"] | 0;
+    entry.type = filament["material"].as<String>();
+    entry.brand = filament["vendor"]["name"].as<String>();
+    entry.color = filament["color_hex"].as<String>();
+    entry.color.toUpperCase();
+
+    // Extra fields are stored as JSON strings by Spoolman ("[190,230]", "\"153\"")
+    if (extra["nozzle_temperature"].is<const char*>()) {
+        String tempString = extra["nozzle_temperature"].as<String>();
+        tempString.replace("[", "");
+        tempString.replace("]", "");
+        int commaIndex = tempString.indexOf(',');
+        if (commaIndex != -1) {
+            entry.nozzleTempMin = tempString.substring(0, commaIndex).toInt();
+            entry.nozzleTempMax = tempString.substring(commaIndex + 1).toInt();
+        }
+    }
+    entry.trayInfoIdx = extra["bambu_idx"].as<String>();
+    entry.trayInfoIdx.replace("\"", "");
+    entry.caliIdx = extra["bambu_cali_id"].as<String>();
+    entry.caliIdx.replace("\"", "");
+    entry.bambuSettingId = extra["bambu_setting_id"].as<String>();
+    entry.bambuSettingId.replace("\"", "");
+}
+
+void initSpoolCache() {
+    if (spoolCacheMutex == NULL) spoolCacheMutex = xSemaphoreCreateMutex();
+}
+
+void spoolCacheStore(JsonObjectConst spool, const String& etag) {
+    if (!spool["id"].is<uint16_t>()) return;
+    uint16_t spoolId = spool["id"].as<uint16_t>();
+    JsonObjectConst filament = spool["filament"];
+
+    CachedSpool entry;
+    entry.id = spoolId;
+    fillFilamentFields(entry, filament);
+
+    entry.spoolWeight = spool["spool_weight"].is<float>() ? spool["spool_weight"].as<float>() : (filament["spool_weight"] | 0.0f);
+    entry.remainingWeight = spool["remaining_weight"] | 0.0f;
+    entry.etag = etag;
+    entry.fetchedAt = millis();
+
+    SpoolCacheLock lock;
+    SpoolCacheSlot* slot = findSlot(spoolId);
+    if (slot == nullptr) slot = victimSlot();
+    slot->spool = entry;
+    slot->usedAt = millis();
+    spoolCacheStats.stored++;
+}
+
+void spoolCacheConfirm(uint16_t spoolId) {
+    SpoolCacheLock lock;
+    SpoolCacheSlot* slot = findSlot(spoolId);
+    if (slot == nullptr) return;
+    slot->spool.fetchedAt = millis();
+    slot->spool.invalidated = false;
+    spoolCacheStats.notModified++;
+}
+
+bool spoolCacheGet(uint16_t spoolId, CachedSpool& entry) {
+    if (spoolId == 0) return false;
+
+    SpoolCacheLock lock;
+    SpoolCacheSlot* slot = findSlot(spoolId);
+    if (slot == nullptr) {
+        spoolCacheStats.misses++;
+        return false;
+    }
+    slot->usedAt = millis();
+    entry = slot->spool;
+    spoolCacheStats.hits++;
+    return true;
+}
+
+bool spoolCacheIsStale(const CachedSpool& entry) {
+    if (entry.invalidated) return true;
+    if (spoolCachePushMode) return false;
+    return millis() - entry.fetchedAt >= SPOOL_CACHE_REFRESH_MS;
+}
+
+size_t spoolCacheStaleIds(uint16_t* ids, size_t maxIds) {
+    SpoolCacheLock lock;
+    size_t count = 0;
+    for (uint8_t i = 0; i < SPOOL_CACHE_SIZE && count < maxIds; i++) {
+        if (spoolCache[i].spool.id != 0 && spoolCacheIsStale(spoolCache[i].spool)) {
+            ids[count++] = spoolCache[i].spool.id;
+        }
+    }
+    return count;
+}
+
+bool spoolCacheContains(uint16_t spoolId) {
+    SpoolCacheLock lock;
+    return spoolId != 0 && findSlot(spoolId) != nullptr;
+}
+
+void spoolCacheForget(uint16_t spoolId) {
+    SpoolCacheLock lock;
+    SpoolCacheSlot* slot = findSlot(spoolId);
+    if (slot == nullptr) return;
+    slot->spool = CachedSpool();
+    slot->usedAt = 0;
+}
+
+uint8_t spoolCacheApplyFilament(JsonObjectConst filament) {
+    uint16_t filamentId = filament["id"] | 0;
+    if (filamentId == 0) return 0;
+
+    SpoolCacheLock lock;
+    uint8_t changed = 0;
+    for (uint8_t i = 0; i < SPOOL_CACHE_SIZE; i++) {
+        CachedSpool& spool = spoolCache[i].spool;
+        if (spool.id == 0 || spool.filamentId != filamentId) continue;
+        fillFilamentFields(spool, filament);
+        spool.etag = ""; // the spool document changed as well
+        changed++;
+    }
+    spoolCacheStats.pushed += changed;
+    return changed;
+}
+
+uint8_t spoolCacheApplyVendor(uint16_t vendorId, const String& name) {
+    if (vendorId == 0) return 0;
+
+    SpoolCacheLock lock;
+    uint8_t changed = 0;
+    for (uint8_t i = 0; i < SPOOL_CACHE_SIZE; i++) {
+        CachedSpool& spool = spoolCache[i].spool;
+        if (spool.id == 0 || spool.vendorId != vendorId) continue;
+        spool.brand = name;
+        spool.etag = "";
+        changed++;
+    }
+    spoolCacheStats.pushed += changed;
+    return changed;
+}
+
+void spoolCacheInvalidateAll() {
+    SpoolCacheLock lock;
+    for (uint8_t i = 0; i < SPOOL_CACHE_SIZE; i++) {
+        if (spoolCache[i].spool.id != 0) spoolCache[i].spool.invalidated = true;
+    }
+}
+
+void spoolCacheSetPushMode(bool enabled) {
+    spoolCachePushMode = enabled;
+}
+
+// Same layout fetchSingleSpoolInfo has always returned
+void spoolCacheToFilteredJson(const CachedSpool& entry, JsonDocument& doc) {
+    doc["color"] = entry.color;
+    doc["type"] = entry.type;
+    doc["nozzle_temp_min"] = entry.nozzleTempMin;
+    doc["nozzle_temp_max"] = entry.nozzleTempMax;
+    doc["brand"] = entry.brand;
+    doc["tray_info_idx"] = entry.trayInfoIdx;
+    doc["cali_idx"] = entry.caliIdx;
+    doc["bambu_setting_id"] = entry.bambuSettingId;
+}
+
+void spoolCacheNoteWeightSkipped() {
+    spoolCacheStats.weightSkipped++;
+}
+
+String getSpoolCacheStatsJson() {
+    JsonDocument doc;
+    uint8_t used = 0;
+    {
+        SpoolCacheLock lock;
+        for (uint8_t i = 0; i < SPOOL_CACHE_SIZE; i++) {
+            if (spoolCache[i].spool.id != 0) used++;
+        }
+    }
+    doc["entries"] = used;
+    doc["hits"] = spoolCacheStats.hits;
+    doc["misses"] = spoolCacheStats.misses;
+    doc["stored"] = spoolCacheStats.stored;
+    doc["notModified"] = spoolCacheStats.notModified;
+    doc["weightSkipped"] = spoolCacheStats.weightSkipped;
+    doc["pushed"] = spoolCacheStats.pushed;
+    doc["pushMode"] = (bool)spoolCachePushMode;
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
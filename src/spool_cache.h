@@ -0,0 +1,48 @@
+#ifndef SPOOL_CACHE_H
+#define SPOOL_CACHE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Filtered view of a Spoolman spool, as needed for AMS assignment and weighing
+struct CachedSpool {
+    uint16_t id = 0;
+    uint16_t filamentId = 0;
+    uint16_t vendorId = 0;
+    String color;
+    String type;
+    String brand;
+    String trayInfoIdx;
+    String caliIdx;
+    String bambuSettingId;
+    int nozzleTempMin = 0;
+    int nozzleTempMax = 0;
+    float spoolWeight = 0;
+    float remainingWeight = 0;
+    String etag;                    // validator for conditional refreshes, may be empty
+    unsigned long fetchedAt = 0;    // millis() of the last confirmed state
+    bool invalidated = false;       // may have missed a change, refresh regardless of age
+};
+
+void initSpoolCache();
+// Store a full Spoolman spool document
+void spoolCacheStore(JsonObjectConst spool, const String& etag);
+// Server answered 304 for this entry
+void spoolCacheConfirm(uint16_t spoolId);
+bool spoolCacheGet(uint16_t spoolId, CachedSpool& entry);
+bool spoolCacheIsStale(const CachedSpool& entry);
+// Ids of entries older than the refresh age, oldest first
+size_t spoolCacheStaleIds(uint16_t* ids, size_t maxIds);
+// Change events from Spoolman
+bool spoolCacheContains(uint16_t spoolId);
+void spoolCacheForget(uint16_t spoolId);
+uint8_t spoolCacheApplyFilament(JsonObjectConst filament);
+uint8_t spoolCacheApplyVendor(uint16_t vendorId, const String& name);
+void spoolCacheInvalidateAll();
+// While pushed changes arrive, entries only go stale when invalidated
+void spoolCacheSetPushMode(bool enabled);
+void spoolCacheToFilteredJson(const CachedSpool& entry, JsonDocument& doc);
+void spoolCacheNoteWeightSkipped();
+String getSpoolCacheStatsJson();
+
+#endif
@@ -0,0 +1,120 @@
+#include "spool_tag.h"
+
+namespace {
+struct StringField {
+    const char* key;
+    String SpoolTagRecord::*member;
+};
+
+struct IntField {
+    const char* key;
+    int SpoolTagRecord::*member;
+};
+
+// Key -> member tables, resolved at compile time. Adding a tag field only needs a
+// new member in SpoolTagRecord and one line here.
+constexpr StringField kStringFields[] = {
+    { "sm_id",      &SpoolTagRecord::smId },
+    { "location",   &SpoolTagRecord::location },
+    { "type",       &SpoolTagRecord::type },
+    { "color_hex",  &SpoolTagRecord::colorHex },
+    { "brand",      &SpoolTagRecord::brand },
+    { "brand_name", &SpoolTagRecord::brandName },
+    { "b",          &SpoolTagRecord::b },
+    { "an",         &SpoolTagRecord::an },
+    { "cn",         &SpoolTagRecord::cn },
+    { "t",          &SpoolTagRecord::t },
+    { "c",          &SpoolTagRecord::c },
+    { "mc",         &SpoolTagRecord::mc },
+    { "mcd",        &SpoolTagRecord::mcd },
+    { "de",         &SpoolTagRecord::de },
+    { "di",         &SpoolTagRecord::di },
+    { "sw",         &SpoolTagRecord::sw },
+    { "et",         &SpoolTagRecord::et },
+    { "bt",         &SpoolTagRecord::bt },
+    { "u",          &SpoolTagRecord::u },
+    { "artnr",      &SpoolTagRecord::artnr },
+};
+
+constexpr IntField kIntFields[] = {
+    { "min_temp",    &SpoolTagRecord::minTemp },
+    { "max_temp",    &SpoolTagRecord::maxTemp },
+    { "drying_temp", &SpoolTagRecord::dryingTemp },
+    { "drying_time", &SpoolTagRecord::dryingTime },
+};
+
+// Scalars only; numbers are kept in their JSON text form ("1.24", "180")
+bool scalarToString(JsonVariantConst value, String& out) {
+    if (value.is<const char*>()) {
+        out = value.as<const char*>();
+        return true;
+    }
+    if (value.is<JsonObjectConst>() || value.is<JsonArrayConst>() || value.isNull()) {
+        return false;
+    }
+    out = "";
+    serializeJson(value, out);
+    return true;
+}
+}
+
+void decodeSpoolTagRecord(JsonObjectConst payload, SpoolTagRecord& record) {
+    record = SpoolTagRecord();
+
+    for (JsonPairConst kv : payload) {
+        const char* key = kv.key().c_str();
+        bool matched = false;
+
+        for (const StringField& field : kStringFields) {
+            if (strcmp(key, field.key) == 0) {
+                scalarToString(kv.value(), record.*field.member);
+                matched = true;
+                break;
+            }
+        }
+        if (matched) continue;
+
+        for (const IntField& field : kIntFields) {
+            if (strcmp(key, field.key) == 0) {
+                if (kv.value().is<int>()) record.*field.member = kv.value().as<int>();
+                break;
+            }
+        }
+    }
+}
+
+bool decodeSpoolTagRecord(const char* json, size_t length, SpoolTagRecord& record) {
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, json, length);
+    if (error) {
+        Serial.print("deserializeJson() failed: ");
+        Serial.println(error.f_str());
+        return false;
+    }
+    if (!doc.is<JsonObject>()) {
+        Serial.println("Tag JSON is not an object");
+        return false;
+    }
+
+    decodeSpoolTagRecord(doc.as<JsonObjectConst>(), record);
+    return true;
+}
+
+String serializeFastPathJson(JsonObjectConst payload, String& json) {
+    String smId;
+    if (!scalarToString(payload["sm_id"], smId) || smId.length() == 0) {
+        smId = "0"; // Default for brand filaments
+    }
+
+    // sm_id first so quickSpoolIdCheck finds it in the first pages
+    JsonDocument doc;
+    doc["sm_id"] = smId;
+    for (JsonPairConst kv : payload) {
+        if (strcmp(kv.key().c_str(), "sm_id") == 0) continue;
+        doc[kv.key()] = kv.value();
+    }
+
+    json = "";
+    serializeJson(doc, json);
+    return smId;
+}
@@ -0,0 +1,52 @@
+#ifndef SPOOL_TAG_H
+#define SPOOL_TAG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Typed view of the JSON stored on a spool / location tag. Filled once per
+// read or write and handed through the pipeline instead of re-parsing JSON.
+struct SpoolTagRecord {
+    // Spoolman reference / location tag
+    String smId;          // "sm_id"
+    String location;      // "location"
+
+    // Standard Filaman format
+    String type;          // "type"
+    String colorHex;      // "color_hex"
+    String brand;         // "brand" (manufacturer)
+    String brandName;     // "brand_name"
+    int minTemp = 0;      // "min_temp"
+    int maxTemp = 0;      // "max_temp"
+    int dryingTemp = 0;   // "drying_temp"
+    int dryingTime = 0;   // "drying_time"
+
+    // Brand filament format
+    String b;             // brand / vendor name
+    String an;            // article number
+    String cn;            // color name
+    String t;             // material
+    String c;             // color hex
+    String mc;            // multi color hexes
+    String mcd;           // multi color direction
+    String de;            // density
+    String di;            // diameter
+    String sw;            // spool weight
+    String et;            // extruder temp
+    String bt;            // bed temp
+    String u;             // product url
+    String artnr;         // article number (legacy key)
+
+    bool isKnownSpool() const { return smId.length() > 0 && smId != "0"; }
+    bool isLocationTag() const { return location.length() > 0; }
+    bool isBrandFilament() const { return !isKnownSpool() && b.length() > 0 && an.length() > 0; }
+};
+
+// Decode tag JSON into a record with a single deserializeJson pass
+bool decodeSpoolTagRecord(const char* json, size_t length, SpoolTagRecord& record);
+// Fill a record from an already parsed object (no parsing)
+void decodeSpoolTagRecord(JsonObjectConst payload, SpoolTagRecord& record);
+// Serialize a tag payload with sm_id as first key (fast-path layout), returns the sm_id used
+String serializeFastPathJson(JsonObjectConst payload, String& json);
+
+#endif
@@ -0,0 +1,189 @@
+#include "spoolman_endpoint.h"
+#include <ArduinoJson.h>
+#include "config.h"
+
+struct SpoolmanEndpoint {
+    String baseUrl;
+    bool internal;
+    bool healthy;           // last request got an answer
+    float srttMs;           // smoothed response time, valid once samples > 0
+    uint32_t samples;
+    uint32_t failures;
+    unsigned long lastFailure;
+    unsigned long lastAnswer;   // 0 = never
+};
+
+static SpoolmanEndpoint endpoints[SPOOLMAN_ENDPOINT_MAX];
+static uint8_t endpointCount = 0;
+static int8_t selectedEndpoint = -1;
+static uint32_t endpointSwitches = 0;
+static SemaphoreHandle_t endpointMutex = NULL;
+
+class EndpointLock {
+public:
+    EndpointLock() { if (endpointMutex) xSemaphoreTake(endpointMutex, portMAX_DELAY); }
+    ~EndpointLock() { if (endpointMutex) xSemaphoreGive(endpointMutex); }
+};
+
+// Creates the lock up front, two tasks creating it lazily could each get their own
+void initSpoolmanEndpoints() {
+    if (endpointMutex == NULL) endpointMutex = xSemaphoreCreateMutex();
+}
+
+// Caller holds the lock
+static int8_t endpointOf(const String& url) {
+    for (uint8_t i = 0; i < endpointCount; i++) {
+        if (url.startsWith(endpoints[i].baseUrl + apiUrl)) return i;
+    }
+    return -1;
+}
+
+// Healthy and measured beats unmeasured, then the lower RTT wins. The current
+// endpoint is only left for one that is clearly faster. Caller holds the lock.
+static void selectEndpoint() {
+    int8_t best = -1;
+    for (uint8_t i = 0; i < endpointCount; i++) {
+        const SpoolmanEndpoint& e = endpoints[i];
+        if (!e.healthy) continue;
+        if (best == -1 || (endpoints[best].samples == 0 && e.samples > 0) ||
+            (endpoints[best].samples > 0 && e.samples > 0 && e.srttMs < endpoints[best].srttMs)) {
+            best = i;
+        }
+    }
+
+    if (best == -1) {
+        // Nothing known to work, try the one that failed longest ago
+        for (uint8_t i = 0; i < endpointCount; i++) {
+            if (best == -1 || (long)(endpoints[i].lastFailure - endpoints[best].lastFailure) < 0) best = i;
+        }
+    } else if (selectedEndpoint >= 0 && selectedEndpoint != best) {
+        const SpoolmanEndpoint& current = endpoints[selectedEndpoint];
+        if (current.healthy && current.samples > 0 && endpoints[best].samples > 0 &&
+            endpoints[best].srttMs * (100 + SPOOLMAN_ENDPOINT_HYSTERESIS_PCT) / 100.0f >= current.srttMs) {
+            best = selectedEndpoint;
+        }
+    }
+
+    if (best != selectedEndpoint) {
+        if (selectedEndpoint >= 0 && best >= 0) {
+            endpointSwitches++;
+            Serial.println("Spoolman endpoint: switching to " + endpoints[best].baseUrl);
+        }
+        selectedEndpoint = best;
+    }
+}
+
+void spoolmanEndpointsConfigure(const String& externalUrl, const String& internalUrl) {
+    EndpointLock lock;
+    SpoolmanEndpoint previous[SPOOLMAN_ENDPOINT_MAX];
+    uint8_t previousCount = endpointCount;
+    for (uint8_t i = 0; i < previousCount; i++) previous[i] = endpoints[i];
+
+    // The internal URL comes first, it wins as long as nothing has been measured
+    const String urls[] = { internalUrl, externalUrl };
+    endpointCount = 0;
+    for (uint8_t u = 0; u < 2 && endpointCount < SPOOLMAN_ENDPOINT_MAX; u++) {
+        if (urls[u] == "" || (u == 1 && urls[1] == urls[0])) continue;
+
+        SpoolmanEndpoint& e = endpoints[endpointCount++];
+        e = SpoolmanEndpoint();
+        e.baseUrl = urls[u];
+        e.healthy = true;
+        for (uint8_t p = 0; p < previousCount; p++) {
+            if (previous[p].baseUrl == urls[u]) e = previous[p];
+        }
+        e.internal = (u == 0);
+    }
+    selectedEndpoint = -1;
+    selectEndpoint();
+}
+
+uint8_t spoolmanEndpointCount() {
+    EndpointLock lock;
+    return endpointCount;
+}
+
+String spoolmanEndpointBaseUrl(uint8_t index) {
+    EndpointLock lock;
+    return (index < endpointCount) ? endpoints[index].baseUrl : String("");
+}
+
+String spoolmanBaseUrl() {
+    EndpointLock lock;
+    return (selectedEndpoint >= 0) ? endpoints[selectedEndpoint].baseUrl : String("");
+}
+
+String spoolmanEndpointRoute(const String& url) {
+    EndpointLock lock;
+    int8_t index = endpointOf(url);
+    if (index == -1 || selectedEndpoint == -1 || index == selectedEndpoint) return url;
+    return endpoints[selectedEndpoint].baseUrl + url.substring(endpoints[index].baseUrl.length());
+}
+
+bool spoolmanEndpointRelative(const String& url, String& path) {
+    EndpointLock lock;
+    int8_t index = endpointOf(url);
+    if (index == -1) return false;
+    path = url.substring(endpoints[index].baseUrl.length() + strlen(apiUrl));
+    return true;
+}
+
+void spoolmanEndpointRecord(const String& url, bool success, uint32_t rttMs) {
+    EndpointLock lock;
+    int8_t index = endpointOf(url);
+    if (index == -1) return;
+
+    SpoolmanEndpoint& e = endpoints[index];
+    if (success) {
+        e.srttMs = (e.samples == 0) ? (float)rttMs : 0.875f * e.srttMs + 0.125f * (float)rttMs;
+        e.samples++;
+        e.lastAnswer = millis();
+        if (!e.healthy) Serial.println("Spoolman endpoint reachable again: " + e.baseUrl);
+        e.healthy = true;
+    } else {
+        if (e.healthy) Serial.println("Spoolman endpoint unreachable: " + e.baseUrl);
+        e.healthy = false;
+        e.failures++;
+        e.lastFailure = millis();
+    }
+    selectEndpoint();
+}
+
+bool spoolmanEndpointIdle(uint8_t index, uint32_t idleMs) {
+    EndpointLock lock;
+    if (index >= endpointCount) return false;
+    const SpoolmanEndpoint& e = endpoints[index];
+    return !e.healthy || e.lastAnswer == 0 || millis() - e.lastAnswer >= idleMs;
+}
+
+bool spoolmanEndpointAnyHealthy() {
+    EndpointLock lock;
+    for (uint8_t i = 0; i < endpointCount; i++) {
+        if (endpoints[i].healthy) return true;
+    }
+    return false;
+}
+
+String getSpoolmanEndpointStatsJson() {
+    JsonDocument doc;
+    {
+        EndpointLock lock;
+        doc["switches"] = endpointSwitches;
+        JsonArray list = doc["endpoints"].to<JsonArray>();
+        for (uint8_t i = 0; i < endpointCount; i++) {
+            const SpoolmanEndpoint& e = endpoints[i];
+            JsonObject entry = list.add<JsonObject>();
+            entry["url"] = e.baseUrl;
+            entry["internal"] = e.internal;
+            entry["selected"] = (i == selectedEndpoint);
+            entry["healthy"] = e.healthy;
+            entry["srttMs"] = (uint32_t)e.srttMs;
+            entry["samples"] = e.samples;
+            entry["failures"] = e.failures;
+        }
+    }
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
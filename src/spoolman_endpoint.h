@@ -0,0 +1,29 @@
+#ifndef SPOOLMAN_ENDPOINT_H
+#define SPOOLMAN_ENDPOINT_H
+
+#include <Arduino.h>
+
+// Spoolman may be configured with an internal (LAN) and an external URL. Every
+// request and health probe reports reachability and response time per base URL,
+// all traffic goes to the fastest healthy one. A failure switches over at once,
+// the health check brings a recovered endpoint back into the rotation.
+
+void initSpoolmanEndpoints();
+// internalUrl may be empty; statistics survive if a URL did not change
+void spoolmanEndpointsConfigure(const String& externalUrl, const String& internalUrl);
+uint8_t spoolmanEndpointCount();
+String spoolmanEndpointBaseUrl(uint8_t index);
+// Base URL (without apiUrl) all Spoolman requests should use right now
+String spoolmanBaseUrl();
+// Same request on the currently selected endpoint, other URLs are returned unchanged
+String spoolmanEndpointRoute(const String& url);
+// url relative to base + apiUrl of whichever endpoint it was built for, false if none
+bool spoolmanEndpointRelative(const String& url, String& path);
+// Outcome of a request to url, ignored if url belongs to no endpoint
+void spoolmanEndpointRecord(const String& url, bool success, uint32_t rttMs);
+// No answer within idleMs (or marked down): real traffic no longer proves it is up
+bool spoolmanEndpointIdle(uint8_t index, uint32_t idleMs);
+bool spoolmanEndpointAnyHealthy();
+String getSpoolmanEndpointStatsJson();
+
+#endif
@@ -0,0 +1,279 @@
+#include "spoolman_events.h"
+#include <WiFi.h>
+#include <WebSocketsClient.h>
+#include <ArduinoJson.h>
+#include "api.h"
+#include "config.h"
+#include "spool_cache.h"
+#include "brand_cache.h"
+#include "offline.h"
+#include "spoolman_endpoint.h"
+
+// Spoolman pushes {"type": "added|updated|deleted", "resource": "spool|filament|vendor",
+// "date": ..., "payload": {...}} on the root websocket of the API for every change.
+
+struct SpoolmanEventStats {
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t received;
+    uint32_t applied;
+    uint32_t ignored;
+};
+
+static WebSocketsClient spoolmanEvents;
+static TaskHandle_t spoolmanEventsTask = NULL;
+static JsonDocument eventFilter;
+static SpoolmanEventStats eventStats = {};
+static volatile bool eventsConnected = false;
+static volatile bool eventsReconfigure = false;
+static bool eventsStarted = false;
+static String eventsTarget = "";
+static unsigned long lastEventAt = 0;
+
+static void addFilamentFilter(JsonObject filament) {
+    filament["id"] = true;
+    filament["name"] = true;
+    filament["material"] = true;
+    filament["color_hex"] = true;
+    filament["spool_weight"] = true;
+    filament["weight"] = true;
+    filament["external_id"] = true;
+    filament["vendor"]["id"] = true;
+    filament["vendor"]["name"] = true;
+    filament["extra"]["nozzle_temperature"] = true;
+    filament["extra"]["bambu_idx"] = true;
+    filament["extra"]["bambu_cali_id"] = true;
+    filament["extra"]["bambu_setting_id"] = true;
+}
+
+// One filter for all resources: a filament payload has the same shape as spool.filament
+static void buildEventFilter() {
+    eventFilter["type"] = true;
+    eventFilter["resource"] = true;
+
+    JsonObject payload = eventFilter["payload"].to<JsonObject>();
+    addFilamentFilter(payload);
+    payload["location"] = true;
+    payload["initial_weight"] = true;
+    payload["remaining_weight"] = true;
+    addFilamentFilter(payload["filament"].to<JsonObject>());
+}
+
+// Only spools the device already knows, new ones are fetched on their first scan
+static bool applySpoolEvent(const char* type, JsonObjectConst spool) {
+    uint16_t spoolId = spool["id"] | 0;
+    if (spoolId == 0) return false;
+
+    if (strcmp(type, "deleted") == 0) {
+        spoolCacheForget(spoolId);
+        offlineMirrorRemove(spoolId);
+        return true;
+    }
+
+    bool applied = false;
+    if (spoolCacheContains(spoolId)) {
+        spoolCacheStore(spool, "");
+        applied = true;
+    }
+    SpoolMirrorEntry mirrored;
+    if (offlineMirrorGet(spoolId, mirrored)) {
+        offlineMirrorUpdate(spool);
+        applied = true;
+    }
+    return applied;
+}
+
+static bool applyFilamentEvent(const char* type, JsonObjectConst filament) {
+    uint16_t filamentId = filament["id"] | 0;
+    if (filamentId == 0) return false;
+
+    // Vendor or external_id may have changed, the old lookup key has to go
+    brandCacheForgetFilamentId(filamentId);
+    if (strcmp(type, "deleted") == 0) return true;
+
+    brandCacheStoreFilament(filament["vendor"]["id"] | 0, filament["external_id"] | "", filamentId);
+    spoolCacheApplyFilament(filament);
+    return true;
+}
+
+static bool applyVendorEvent(const char* type, JsonObjectConst vendor) {
+    uint16_t vendorId = vendor["id"] | 0;
+    if (vendorId == 0) return false;
+
+    brandCacheForgetVendorId(vendorId);
+    if (strcmp(type, "deleted") == 0) return true;
+
+    String name = vendor["name"] | "";
+    brandCacheStoreVendor(name, vendorId);
+    spoolCacheApplyVendor(vendorId, name);
+    return true;
+}
+
+static void handleEventMessage(const uint8_t* payload, size_t length) {
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, payload, length, DeserializationOption::Filter(eventFilter));
+    if (error) {
+        Serial.print("Spoolman event: JSON error: ");
+        Serial.println(error.c_str());
+        return;
+    }
+
+    eventStats.received++;
+    lastEventAt = millis();
+
+    const char* type = doc["type"] | "";
+    const char* resource = doc["resource"] | "";
+    JsonObjectConst data = doc["payload"];
+
+    bool applied = false;
+    if (strcmp(resource, "spool") == 0) applied = applySpoolEvent(type, data);
+    else if (strcmp(resource, "filament") == 0) applied = applyFilamentEvent(type, data);
+    else if (strcmp(resource, "vendor") == 0) applied = applyVendorEvent(type, data);
+
+    if (applied) {
+        eventStats.applied++;
+        Serial.printf("Spoolman event: %s %s %u\n", resource, type, (unsigned)(data["id"] | 0));
+    } else {
+        eventStats.ignored++;
+    }
+}
+
+static void onSpoolmanEvent(WStype_t type, uint8_t* payload, size_t length) {
+    switch (type) {
+    case WStype_CONNECTED:
+        Serial.println("Spoolman events connected: " + eventsTarget);
+        eventStats.connects++;
+        // Whatever changed while there was no connection has been missed
+        spoolCacheInvalidateAll();
+        spoolCacheSetPushMode(true);
+        eventsConnected = true;
+        lastEventAt = millis();
+        break;
+    case WStype_DISCONNECTED:
+        if (eventsConnected) {
+            Serial.println("Spoolman events disconnected");
+            eventStats.disconnects++;
+        }
+        eventsConnected = false;
+        spoolCacheSetPushMode(false);
+        break;
+    case WStype_TEXT:
+        handleEventMessage(payload, length);
+        break;
+    default:
+        break;
+    }
+}
+
+// "https://host:port/prefix" -> parts, port defaults by scheme
+static bool parseBaseUrl(const String& baseUrl, bool& secure, String& host, uint16_t& port, String& path) {
+    int schemeEnd = baseUrl.indexOf("://");
+    if (schemeEnd == -1) return false;
+    secure = baseUrl.substring(0, schemeEnd).equalsIgnoreCase("https");
+
+    String rest = baseUrl.substring(schemeEnd + 3);
+    int pathStart = rest.indexOf('/');
+    String authority = (pathStart == -1) ? rest : rest.substring(0, pathStart);
+    path = (pathStart == -1) ? "" : rest.substring(pathStart);
+    while (path.endsWith("/")) path.remove(path.length() - 1);
+
+    int colon = authority.lastIndexOf(':');
+    if (colon != -1) {
+        host = authority.substring(0, colon);
+        port = authority.substring(colon + 1).toInt();
+    } else {
+        host = authority;
+        port = secure ? 443 : 80;
+    }
+    return host.length() > 0 && port > 0;
+}
+
+static bool startConnection() {
+    String baseUrl = spoolmanBaseUrl();
+    bool secure = false;
+    String host, path;
+    uint16_t port = 0;
+    if (!parseBaseUrl(baseUrl, secure, host, port, path)) return false;
+    if (secure && ESP.getFreeHeap() < SPOOLMAN_EVENTS_MIN_HEAP) return false;
+
+    // The root endpoint of the API streams changes of all resources
+    String url = path + apiUrl + "/";
+    eventsTarget = host + ":" + String(port) + url;
+
+    if (secure) spoolmanEvents.beginSSL(host.c_str(), port, url.c_str());
+    else spoolmanEvents.begin(host.c_str(), port, url.c_str());
+    spoolmanEvents.onEvent(onSpoolmanEvent);
+    spoolmanEvents.setReconnectInterval(SPOOLMAN_EVENTS_RECONNECT_MS);
+    spoolmanEvents.enableHeartbeat(SPOOLMAN_EVENTS_PING_MS, SPOOLMAN_EVENTS_PONG_TIMEOUT_MS, 2);
+    return true;
+}
+
+// The client is not thread safe, everything touching it runs in this task
+static void spoolmanEventsLoop(void* parameter) {
+    unsigned long lastAttempt = 0;
+    for (;;) {
+        if (eventsReconfigure) {
+            eventsReconfigure = false;
+            if (eventsStarted) spoolmanEvents.disconnect();
+            eventsStarted = false;
+            eventsConnected = false;
+            spoolCacheSetPushMode(false);
+            lastAttempt = 0;
+        }
+
+        if (!eventsStarted) {
+            if (WiFi.status() == WL_CONNECTED && spoolmanUrl != "" &&
+                (lastAttempt == 0 || millis() - lastAttempt >= SPOOLMAN_EVENTS_RECONNECT_MS)) {
+                lastAttempt = millis();
+                eventsStarted = startConnection();
+            }
+            vTaskDelay(pdMS_TO_TICKS(500));
+            continue;
+        }
+
+        spoolmanEvents.loop();
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+void initSpoolmanEvents() {
+    if (spoolmanEventsTask != NULL) return;
+
+    buildEventFilter();
+    BaseType_t result = xTaskCreatePinnedToCore(
+        spoolmanEventsLoop,
+        "SpoolmanEvents",
+        8192,
+        NULL,
+        spoolmanEventsTaskPrio,
+        &spoolmanEventsTask,
+        spoolmanEventsTaskCore);
+    if (result != pdPASS) {
+        Serial.println("Failed to start Spoolman event task");
+        spoolmanEventsTask = NULL;
+    }
+}
+
+void spoolmanEventsReconnect() {
+    eventsReconfigure = true;
+}
+
+bool spoolmanEventsConnected() {
+    return eventsConnected && !eventsReconfigure;
+}
+
+String getSpoolmanEventsStatsJson() {
+    JsonDocument doc;
+    doc["connected"] = spoolmanEventsConnected();
+    doc["target"] = eventsTarget;
+    doc["connects"] = eventStats.connects;
+    doc["disconnects"] = eventStats.disconnects;
+    doc["received"] = eventStats.received;
+    doc["applied"] = eventStats.applied;
+    doc["ignored"] = eventStats.ignored;
+    if (lastEventAt > 0) doc["lastEventAgeMs"] = millis() - lastEventAt;
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
@@ -0,0 +1,16 @@
+#ifndef SPOOLMAN_EVENTS_H
+#define SPOOLMAN_EVENTS_H
+
+#include <Arduino.h>
+
+// Long-lived websocket to Spoolman's change notifications. Spool, filament and
+// vendor events are applied to the spool cache, the offline mirror and the
+// brand cache as they arrive. While connected it also stands in for /health.
+
+void initSpoolmanEvents();
+// Spoolman URL changed, drop the connection and reconnect to the new one
+void spoolmanEventsReconnect();
+bool spoolmanEventsConnected();
+String getSpoolmanEventsStatsJson();
+
+#endif
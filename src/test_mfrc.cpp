@@ -12,6 +12,8 @@
 #define BUTTON_PIN 27
 
 MFRC522 mfrc522(SS_PIN, RST_PIN);
+// Referenced by MFRC522_SPICLOCK (see platformio.ini), keep the library default here
+volatile uint32_t rc522SpiClockHz = 4000000UL;
 
 #ifndef TEST_WIFI_SSID
 #define TEST_WIFI_SSID ""
@@ -0,0 +1,166 @@
+#include "upstream.h"
+#include <ArduinoJson.h>
+#include "config.h"
+
+// Timeout as in RFC 6298: SRTT + 4 * RTTVAR, doubled after every failure
+// without an answer and reset by the next response.
+
+typedef enum {
+    BREAKER_CLOSED,
+    BREAKER_OPEN,
+    BREAKER_HALF_OPEN
+} BreakerState;
+
+struct UpstreamState {
+    BreakerState state;
+    float srttMs;
+    float rttvarMs;
+    uint8_t backoff;            // timeout doubled this many times
+    uint8_t failures;           // consecutive
+    uint32_t openMs;            // current cool-down
+    unsigned long openedAt;
+    unsigned long probeAt;      // 0 = no probe in flight
+    uint32_t samples;
+    uint32_t opened;
+    uint32_t rejected;          // failed fast while open
+};
+
+static const char* upstreamNames[UPSTREAM_COUNT] = { "spoolman", "octoprint" };
+static const char* breakerStateNames[] = { "closed", "open", "half-open" };
+
+static UpstreamState upstreams[UPSTREAM_COUNT] = {};
+static SemaphoreHandle_t upstreamMutex = NULL;
+
+class UpstreamLock {
+public:
+    UpstreamLock() { if (upstreamMutex) xSemaphoreTake(upstreamMutex, portMAX_DELAY); }
+    ~UpstreamLock() { if (upstreamMutex) xSemaphoreGive(upstreamMutex); }
+};
+
+// Called from initSpoolman() before the API worker and the web server use the breaker
+void initUpstreams() {
+    if (upstreamMutex == NULL) upstreamMutex = xSemaphoreCreateMutex();
+}
+
+// Caller holds the lock
+static uint16_t timeoutOf(const UpstreamState& u) {
+    uint32_t timeout = UPSTREAM_TIMEOUT_DEFAULT_MS;
+    if (u.samples > 0) {
+        timeout = (uint32_t)(u.srttMs + 4.0f * u.rttvarMs);
+        if (timeout < UPSTREAM_TIMEOUT_MIN_MS) timeout = UPSTREAM_TIMEOUT_MIN_MS;
+    }
+    timeout <<= u.backoff;
+    return (timeout > UPSTREAM_TIMEOUT_MAX_MS) ? UPSTREAM_TIMEOUT_MAX_MS : timeout;
+}
+
+// Caller holds the lock
+static void openBreaker(UpstreamState& u, UpstreamId upstream) {
+    // A failed probe doubles the cool-down, a fresh outage starts with the base value
+    if (u.state == BREAKER_HALF_OPEN) {
+        u.openMs = (u.openMs * 2 > UPSTREAM_BREAKER_OPEN_MAX_MS) ? UPSTREAM_BREAKER_OPEN_MAX_MS : u.openMs * 2;
+    } else {
+        u.openMs = UPSTREAM_BREAKER_OPEN_MS;
+    }
+    u.state = BREAKER_OPEN;
+    u.openedAt = millis();
+    u.probeAt = 0;
+    u.opened++;
+    Serial.printf("Upstream %s unreachable, failing fast for %lu s\n", upstreamNames[upstream], u.openMs / 1000UL);
+}
+
+bool upstreamAllow(UpstreamId upstream) {
+    UpstreamLock lock;
+    UpstreamState& u = upstreams[upstream];
+    unsigned long now = millis();
+
+    if (u.state == BREAKER_OPEN && now - u.openedAt >= u.openMs) {
+        u.state = BREAKER_HALF_OPEN;
+        u.probeAt = 0;
+    }
+    if (u.state == BREAKER_CLOSED) return true;
+
+    // A probe whose outcome never arrived does not block the next one forever
+    if (u.state == BREAKER_HALF_OPEN &&
+        (u.probeAt == 0 || now - u.probeAt >= 3UL * UPSTREAM_TIMEOUT_MAX_MS)) {
+        u.probeAt = now;
+        Serial.printf("Upstream %s: probing\n", upstreamNames[upstream]);
+        return true;
+    }
+    u.rejected++;
+    return false;
+}
+
+bool upstreamIsOpen(UpstreamId upstream) {
+    UpstreamLock lock;
+    const UpstreamState& u = upstreams[upstream];
+    return u.state == BREAKER_OPEN && millis() - u.openedAt < u.openMs;
+}
+
+void upstreamRecord(UpstreamId upstream, bool success, uint32_t rttMs) {
+    UpstreamLock lock;
+    UpstreamState& u = upstreams[upstream];
+
+    if (!success) {
+        if (u.backoff < 3) u.backoff++;
+        if (u.failures < 255) u.failures++;
+        if (u.state == BREAKER_HALF_OPEN ||
+            (u.state == BREAKER_CLOSED && u.failures >= UPSTREAM_BREAKER_FAILURES)) {
+            openBreaker(u, upstream);
+        }
+        return;
+    }
+
+    float rtt = (float)rttMs;
+    if (u.samples == 0) {
+        u.srttMs = rtt;
+        u.rttvarMs = rtt / 2.0f;
+    } else {
+        u.rttvarMs = 0.75f * u.rttvarMs + 0.25f * fabsf(u.srttMs - rtt);
+        u.srttMs = 0.875f * u.srttMs + 0.125f * rtt;
+    }
+    u.samples++;
+    u.backoff = 0;
+    u.failures = 0;
+    if (u.state != BREAKER_CLOSED) {
+        Serial.printf("Upstream %s reachable again\n", upstreamNames[upstream]);
+        u.state = BREAKER_CLOSED;
+        u.probeAt = 0;
+    }
+}
+
+uint16_t upstreamTimeoutMs(UpstreamId upstream) {
+    UpstreamLock lock;
+    return timeoutOf(upstreams[upstream]);
+}
+
+void upstreamReset(UpstreamId upstream) {
+    UpstreamLock lock;
+    upstreams[upstream] = UpstreamState();
+}
+
+String getUpstreamStatsJson() {
+    JsonDocument doc;
+    unsigned long now = millis();
+    {
+        UpstreamLock lock;
+        for (uint8_t i = 0; i < UPSTREAM_COUNT; i++) {
+            const UpstreamState& u = upstreams[i];
+            JsonObject entry = doc[upstreamNames[i]].to<JsonObject>();
+            entry["state"] = breakerStateNames[u.state];
+            entry["timeoutMs"] = timeoutOf(u);
+            entry["srttMs"] = (uint32_t)u.srttMs;
+            entry["rttvarMs"] = (uint32_t)u.rttvarMs;
+            entry["samples"] = u.samples;
+            entry["failures"] = u.failures;
+            entry["opened"] = u.opened;
+            entry["rejected"] = u.rejected;
+            if (u.state == BREAKER_OPEN && now - u.openedAt < u.openMs) {
+                entry["retryInMs"] = u.openMs - (now - u.openedAt);
+            }
+        }
+    }
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
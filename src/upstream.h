@@ -0,0 +1,31 @@
+#ifndef UPSTREAM_H
+#define UPSTREAM_H
+
+#include <Arduino.h>
+
+// Timeout policy and circuit breaker per upstream server. Response times feed a
+// smoothed RTT (EWMA as in TCP) from which the request timeout is derived.
+// Consecutive failures open the breaker: requests then fail immediately until a
+// cool-down has passed, after which a single probe request is let through
+// (half-open). The probe closes the breaker again or doubles the cool-down.
+
+typedef enum {
+    UPSTREAM_SPOOLMAN,
+    UPSTREAM_OCTOPRINT,
+    UPSTREAM_COUNT
+} UpstreamId;
+
+void initUpstreams();
+// false = fail fast. In half-open state the first caller gets the probe and
+// must report its outcome with upstreamRecord().
+bool upstreamAllow(UpstreamId upstream);
+// Breaker open and still cooling down, does not take the probe
+bool upstreamIsOpen(UpstreamId upstream);
+// Server answered (any status below 500): success, rttMs is fed into the estimate
+void upstreamRecord(UpstreamId upstream, bool success, uint32_t rttMs);
+uint16_t upstreamTimeoutMs(UpstreamId upstream);
+// Spoolman URL changed, start over with the defaults
+void upstreamReset(UpstreamId upstream);
+String getUpstreamStatsJson();
+
+#endif
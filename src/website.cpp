@@ -1,6 +1,13 @@
 #include "website.h"
 #include "commonFS.h"
 #include "api.h"
+#include "offline.h"
+#include "spool_cache.h"
+#include "brand_cache.h"
+#include "spoolman_events.h"
+#include "http_pool.h"
+#include "upstream.h"
+#include "spoolman_endpoint.h"
 #include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
 #include "bambu.h"
@@ -8,6 +15,7 @@
 #include "scale.h"
 #include "esp_task_wdt.h"
 #include <Update.h>
+#include <errno.h>
 #include "display.h"
 #include "ota.h"
 #include "config.h"
@@ -82,10 +90,19 @@ void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventTyp
         else if (doc["type"] == "writeNfcTag") {
             if (doc["payload"].is<JsonObject>()) {
                 // Versuche NFC-Daten zu schreiben
-                String payloadString;
-                serializeJson(doc["payload"], payloadString);
+                startWriteJsonToTag((doc["tagType"] == "spool") ? true : false, doc["payload"].as<JsonObjectConst>());
+            }
+        }
 
-                startWriteJsonToTag((doc["tagType"] == "spool") ? true : false, payloadString.c_str());
+        else if (doc["type"] == "cloneTag") {
+            if (doc["action"] == "start") {
+                if (!startCloneMode()) {
+                    client->text("{\"type\":\"cloneTag\",\"payload\":{\"state\":\"off\",\"error\":\"Write queue busy\"}}");
+                }
+            } else if (doc["action"] == "stop") {
+                stopCloneMode();
+            } else {
+                sendCloneStatus();
             }
         }
 
@@ -120,7 +137,8 @@ void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventTyp
             }
 
             if (doc["payload"] == "spoolman") {
-                initSpoolman();
+                // Queued on the API worker, the result arrives via sendSpoolmanHealth()
+                scheduleSpoolmanHealthCheck(true);
             }
         }
 
@@ -167,6 +185,14 @@ void sendWriteResult(AsyncWebSocketClient *client, uint8_t success) {
     ws.textAll(response);
 }
 
+void sendSpoolmanHealth() {
+    ws.textAll("{\"type\":\"spoolmanHealth\",\"payload\":{\"connected\":" + String(spoolmanConnected ? "true" : "false") + "}}");
+}
+
+void sendCloneStatus() {
+    ws.textAll("{\"type\":\"cloneTag\",\"payload\":" + getCloneStatusJson() + "}");
+}
+
 void foundNfcTag(AsyncWebSocketClient *client, uint8_t success) {
     if (success == lastSuccess) return;
     if (success) {
@@ -205,6 +231,15 @@ void sendNfcData() {
     lastnfcReaderState = nfcReaderState;
 }
 
+// Whole string must be a decimal number, toInt() would turn "abc" into 0
+static bool parseLongParam(const String& text, long& value) {
+    if (text.length() == 0) return false;
+    char* end = nullptr;
+    errno = 0;
+    value = strtol(text.c_str(), &end, 10);
+    return errno == 0 && end != nullptr && *end == '\0';
+}
+
 void sendAmsData(AsyncWebSocketClient *client) {
     // Check for low memory before attempting to allocate large strings
     uint32_t freeHeap = ESP.getFreeHeap();
@@ -376,17 +411,24 @@ void setupWebserver(AsyncWebServer &server) {
         html.replace("{{spoolmanOctoEnabled}}", octoEnabled ? "checked" : "");
         html.replace("{{spoolmanOctoUrl}}", octoUrl.length() > 0 ? octoUrl : "");
         html.replace("{{spoolmanOctoToken}}", octoToken.length() > 0 ? octoToken : "");
+        html.replace("{{spoolmanOctoTool}}", octoTool);
 
         html.replace("{{bambuIp}}", bambuCredentials.ip.length() > 0 ? bambuCredentials.ip : "");            
         html.replace("{{bambuSerial}}", bambuCredentials.serial.length() > 0 ? bambuCredentials.serial : "");
         html.replace("{{bambuCode}}", bambuCredentials.accesscode.length() > 0 ? bambuCredentials.accesscode : "");
         html.replace("{{autoSendToBambu}}", bambuCredentials.autosend_enable ? "checked" : "");
         html.replace("{{autoSendTime}}", (bambuCredentials.autosend_time != 0) ? String(bambuCredentials.autosend_time) : String(BAMBU_DEFAULT_AUTOSEND_TIME));
+        html.replace("{{bambuPersistent}}", bambuCredentials.persistent_session ? "checked" : "");
 
         Serial.println("Spoolman page sent");
         request->send(200, "text/html", html);
     });
 
+    // Route für den Status der Spoolman API Queue
+    server.on("/api/spoolman", HTTP_GET, [](AsyncWebServerRequest *request){
+        request->send(200, "application/json", "{\"queue\": " + getApiQueueStatsJson() + ", \"offline\": " + getOfflineStatsJson() + ", \"cache\": " + getSpoolCacheStatsJson() + ", \"brands\": " + getBrandCacheStatsJson() + ", \"events\": " + getSpoolmanEventsStatsJson() + ", \"http\": " + getHttpPoolStatsJson() + ", \"upstream\": " + getUpstreamStatsJson() + ", \"endpoints\": " + getSpoolmanEndpointStatsJson() + "}");
+    });
+
     // Route für das Überprüfen der Spoolman-Instanz
     server.on("/api/checkSpoolman", HTTP_GET, [](AsyncWebServerRequest *request){
         if (!request->hasParam("url")) {
@@ -411,12 +453,15 @@ void setupWebserver(AsyncWebServer &server) {
         bool octoEnabled = (request->getParam("octoEnabled")->value() == "true") ? true : false;
         String octoUrl = request->getParam("octoUrl")->value();
         String octoToken = (request->getParam("octoToken")->value() != "") ? request->getParam("octoToken")->value() : "";
+        String octoTool = request->hasParam("octoTool") ? request->getParam("octoTool")->value() : "";
 
         url.trim();
         octoUrl.trim();
         octoToken.trim();
+        octoTool.trim();
+        if (octoTool == "") octoTool = OCTOPRINT_DEFAULT_TOOL;
         
-        bool healthy = saveSpoolmanUrl(url, octoEnabled, octoUrl, octoToken);
+        bool healthy = saveSpoolmanUrl(url, octoEnabled, octoUrl, octoToken, octoTool);
         String jsonResponse = "{\"healthy\": " + String(healthy ? "true" : "false") + "}";
 
         request->send(200, "application/json", jsonResponse);
@@ -443,6 +488,7 @@ void setupWebserver(AsyncWebServer &server) {
         String bambu_accesscode = request->getParam("bambu_accesscode")->value();
         bool autoSend = (request->getParam("autoSend")->value() == "true") ? true : false;
         String autoSendTime = request->getParam("autoSendTime")->value();
+        bool persistentSession = request->hasParam("persistent") && request->getParam("persistent")->value() == "true";
         
         bambu_ip.trim();
         bambu_serialnr.trim();
@@ -454,11 +500,63 @@ void setupWebserver(AsyncWebServer &server) {
             return;
         }
 
-        bool success = saveBambuCredentials(bambu_ip, bambu_serialnr, bambu_accesscode, autoSend, autoSendTime);
+        bool success = saveBambuCredentials(bambu_ip, bambu_serialnr, bambu_accesscode, autoSend, autoSendTime, persistentSession);
 
         request->send(200, "application/json", "{\"healthy\": " + String(success ? "true" : "false") + "}");
     });
 
+    // Route für NFC-Leser Einstellungen (Scan-Timings, RC522 SPI-Takt)
+    server.on("/api/nfc", HTTP_GET, [](AsyncWebServerRequest *request){
+        // Validate every setting first, a bad value must not leave the earlier ones
+        // applied. Unknown parameters (e.g. cache busters) are ignored.
+        for (size_t i = 0; i < request->params(); i++) {
+            const AsyncWebParameter* param = request->getParam(i);
+            const String& name = param->name();
+            bool known = name == NVS_KEY_NFC_MIGRATE_MODE || isNfcScanTimingKey(name);
+#ifdef USE_RC522
+            known = known || name == NVS_KEY_RC522_SPI_CLOCK;
+#endif
+            if (!known) continue;
+
+            long value;
+            bool valid = parseLongParam(param->value(), value);
+            if (valid && name == NVS_KEY_NFC_MIGRATE_MODE) {
+                valid = value >= NFC_MIGRATE_OFF && value <= NFC_MIGRATE_COMPACT;
+#ifdef USE_RC522
+            } else if (valid && name == NVS_KEY_RC522_SPI_CLOCK) {
+                valid = value >= (long)RC522_SPI_CLOCK_MIN && value <= (long)RC522_SPI_CLOCK_MAX;
+#endif
+            } else if (valid) {
+                valid = checkNfcScanTiming(name, value);
+            }
+            if (!valid) {
+                request->send(400, "application/json", "{\"success\": false, \"error\": \"Invalid " + name + "\"}");
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < request->params(); i++) {
+            const AsyncWebParameter* param = request->getParam(i);
+            const String& name = param->name();
+            long value;
+            if (!parseLongParam(param->value(), value)) continue;
+            if (name == NVS_KEY_NFC_MIGRATE_MODE) {
+                saveNfcMigrateMode((uint8_t)value);
+#ifdef USE_RC522
+            } else if (name == NVS_KEY_RC522_SPI_CLOCK) {
+                saveRc522SpiClock((uint32_t)value);
+#endif
+            } else if (isNfcScanTimingKey(name)) {
+                saveNfcScanTiming(name, (uint16_t)value);
+            }
+        }
+#ifdef USE_RC522
+        request->send(200, "application/json", "{\"timings\": " + getNfcScanTimingsJson() + ", \"migration\": " + getNfcMigrateStatsJson() + ", \"spi\": " + getRc522SpiClockStatsJson() + "}");
+#else
+        request->send(200, "application/json", "{\"timings\": " + getNfcScanTimingsJson() + ", \"migration\": " + getNfcMigrateStatsJson() + "}");
+#endif
+    });
+
     // Route für das Überprüfen der Spoolman-Instanz
     server.on("/reboot", HTTP_GET, [](AsyncWebServerRequest *request){
         ESP.restart();
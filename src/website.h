@@ -27,5 +27,7 @@ void sendAmsData(AsyncWebSocketClient *client);
 void sendNfcData();
 void foundNfcTag(AsyncWebSocketClient *client, uint8_t success);
 void sendWriteResult(AsyncWebSocketClient *client, uint8_t success);
+void sendCloneStatus();
+void sendSpoolmanHealth();
 
 #endif